@@ -90,6 +90,10 @@ auto Demo_Stats = [](Application& app)
         buf = util::format(u8"%lld us", average(&record, over, f));
         ImGuiLTable::PlotLines("Record", get_timings, &record, frame_count, f, buf.c_str(), 0.0f, 10.0f);
 
+        auto uq = app.vsgcontext->updateQueueStats();
+        ImGuiLTable::Text("Update queue", "%d waiting  %d ran  %.1f / %.1f ms", (int)uq.queued, (int)uq.ran,
+            0.001f * (float)uq.used.count(), 0.001f * (float)uq.budget.count());
+
         ImGuiLTable::End();
     }
 
@@ -119,7 +123,10 @@ auto Demo_Stats = [](Application& app)
             if (m)
             {
                 std::string name = m->name.empty() ? "default" : m->name;
-                auto buf = util::format("(%d) %d / %d", (int)m->concurrency, (int)m->running, (int)m->pending);
+                auto buf = util::format("(%d) %d / %d  pick %.1f us  blocked %d%%", (int)m->concurrency, (int)m->running, (int)m->pending,
+                    0.001 * m->average_pick_time_ns(), (int)(100.0f * m->blocked_ratio));
+                if (m->grows > 0 || m->shrinks > 0)
+                    buf += util::format("  +%d/-%d", (int)m->grows, (int)m->shrinks);
                 ImGuiLTable::Text(name.c_str(), buf.c_str());
             }
         }
@@ -187,6 +194,28 @@ auto Demo_Stats = [](Application& app)
         if (ImGuiLTable::Begin("Terrain-Settings"))
         {
             ImGuiLTable::SliderInt("Load threads", (int*)&app.mapNode->terrainNode->concurrency.mutable_value(), 1, 16);
+            ImGuiLTable::Checkbox("Adaptive load threads", &app.mapNode->terrainNode->adaptiveConcurrency.mutable_value());
+            ImGuiLTable::Checkbox("Prefetch", &app.mapNode->terrainNode->prefetch.mutable_value());
+            ImGuiLTable::Checkbox("Skip LOD", &app.mapNode->terrainNode->skipLOD.mutable_value());
+            auto ps = app.mapNode->terrainNode->pagerStats();
+            ImGuiLTable::Text("Tiles", "%d  (%d loaded, %d leaves pending, %d loads canceled)",
+                (int)ps.tiles, (int)ps.loaded, (int)ps.pendingLeaves, (int)ps.canceledLoads);
+            ImGuiLTable::SliderInt("Residency budget (MB)", (int*)&app.mapNode->terrainNode->residencyBudget.mutable_value(), 0, 4096);
+            constexpr double MB = 1024.0 * 1024.0;
+            ImGuiLTable::Text("Resident memory", "%.1f MB  (color %.1f  elev %.1f  geom %.1f)",
+                (double)ps.residentBytes.total() / MB, (double)ps.residentBytes.color / MB,
+                (double)ps.residentBytes.elevation / MB, (double)ps.residentBytes.geometry / MB);
+            ImGuiLTable::Text("Peak memory", "%.1f MB  (color %.1f  elev %.1f  geom %.1f)",
+                (double)ps.peakBytes.total() / MB, (double)ps.peakBytes.color / MB,
+                (double)ps.peakBytes.elevation / MB, (double)ps.peakBytes.geometry / MB);
+            ImGuiLTable::Text("Off-screen tiles", "%d  (%d evicted)", (int)ps.offscreenTiles, (int)ps.evictions);
+            ImGuiLTable::Text("Time to final detail", "%d ms  (max %d ms)",
+                (int)ps.lastTimeToFinalDetail.count(), (int)ps.maxTimeToFinalDetail.count());
+            ImGuiLTable::Text("Prefetch results", "%d hits  %d wasted  %d canceled  (%d pending)",
+                (int)ps.prefetch.hits, (int)ps.prefetch.wasted, (int)ps.prefetch.canceled, (int)ps.prefetch.pending);
+            float budget_ms = 0.001f * (float)app.vsgcontext->updateBudget().count();
+            if (ImGuiLTable::SliderFloat("Update budget (ms)", &budget_ms, 0.0f, 16.0f, "%.1f"))
+                app.vsgcontext->setUpdateBudget(std::chrono::microseconds((long long)(budget_ms * 1000.0f)));
             ImGuiLTable::Checkbox("Continuous rendering", &app.vsgcontext->renderContinuously);
             ImGuiLTable::End();
         }
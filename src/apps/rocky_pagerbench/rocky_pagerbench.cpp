@@ -0,0 +1,455 @@
+/**
+ * rocky c++
+ * Copyright 2023 Pelican Mapping
+ * MIT License
+ */
+
+/**
+* ROCKY_PAGERBENCH is a headless terrain paging simulator and benchmark.
+* It flies a simulated camera along a path over local data, and drives the
+* terrain pager, the tile data loaders, and the render model builds just like
+* the renderer would - but without a window or a GPU. When the flight is over
+* it waits for the view to settle and then reports the results as JSON, so that
+* paging changes can be compared on a machine with no graphics device.
+*
+* Example:
+*   rocky_pagerbench --image world.tif --elevation dem.mbtiles
+*       --from -100 35 5000000 --to -77 39 2000 --frames 600 --out results.json
+*
+* To compare a cold start with a warm one, run twice against a TMS service
+* with the same --cache folder, emptying the folder before the first run.
+*/
+
+#include <rocky/Version.h>
+#include <rocky/Utils.h>
+#include <rocky/GDALImageLayer.h>
+#include <rocky/GDALElevationLayer.h>
+#include <rocky/MBTilesImageLayer.h>
+#include <rocky/MBTilesElevationLayer.h>
+#include <rocky/TMSImageLayer.h>
+#include <rocky/TMSElevationLayer.h>
+#include <rocky/DiskContentCache.h>
+
+#include <rocky/vsg/VSGContext.h>
+#include <rocky/vsg/MapNode.h>
+#include <rocky/vsg/terrain/TerrainNode.h>
+#include <rocky/vsg/terrain/TerrainTileNode.h>
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <thread>
+
+using namespace ROCKY_NAMESPACE;
+
+namespace
+{
+    int usage(const char* name)
+    {
+        std::cout
+            << "Usage: " << name << " [options]\n"
+            << "  --image <file|url>        GeoTIFF, MBTiles, or TMS imagery\n"
+            << "  --elevation <file|url>    GeoTIFF, MBTiles, or TMS elevation\n"
+            << "  --from <lon> <lat> <alt>  start of the camera path (degrees, meters)\n"
+            << "  --to <lon> <lat> <alt>    end of the camera path (degrees, meters)\n"
+            << "  --frames <n>              frames in the camera path (default 600)\n"
+            << "  --fps <n>                 simulated frame rate (default 60)\n"
+            << "  --settle <seconds>        how long to wait for the view to settle (default 30)\n"
+            << "  --viewport <w> <h>        simulated viewport size (default 1920 1080)\n"
+            << "  --skip-lod                page with TerrainSettings::skipLOD; with --frames 1,\n"
+            << "                            fails if any placeholder tile loads data of its own\n"
+            << "  --budget <MB>             TerrainSettings::residencyBudget\n"
+            << "  --texture-arrays          render with TerrainSettings::textureArrays\n"
+            << "  --compress-textures       TerrainSettings::compressTextures\n"
+            << "  --compact-terrain         TerrainSettings::compactTerrain\n"
+            << "  --concurrency <n>         TerrainSettings::concurrency\n"
+            << "  --cache <folder>          keep downloaded content in a DiskContentCache\n"
+            << "  --out <file>              write the JSON report here (default stdout)\n";
+        return -1;
+    }
+
+    bool endsWith(const std::string& str, const std::string& suffix)
+    {
+        return str.length() >= suffix.length() &&
+            util::toLower(str.substr(str.length() - suffix.length())) == suffix;
+    }
+
+    bool isURL(const std::string& str)
+    {
+        return util::startsWith(str, "http://", false) || util::startsWith(str, "https://", false);
+    }
+
+    Layer::Ptr createImageLayer(const std::string& file)
+    {
+        if (isURL(file))
+        {
+            auto layer = TMSImageLayer::create();
+            layer->uri = file;
+            return layer;
+        }
+#ifdef ROCKY_HAS_MBTILES
+        if (endsWith(file, ".mbtiles"))
+        {
+            auto layer = MBTilesImageLayer::create();
+            layer->uri = file;
+            return layer;
+        }
+#endif
+#ifdef ROCKY_HAS_GDAL
+        auto layer = GDALImageLayer::create();
+        layer->uri = file;
+        return layer;
+#else
+        return nullptr;
+#endif
+    }
+
+    Layer::Ptr createElevationLayer(const std::string& file)
+    {
+        if (isURL(file))
+        {
+            auto layer = TMSElevationLayer::create();
+            layer->uri = file;
+            return layer;
+        }
+#ifdef ROCKY_HAS_MBTILES
+        if (endsWith(file, ".mbtiles"))
+        {
+            auto layer = MBTilesElevationLayer::create();
+            layer->uri = file;
+            return layer;
+        }
+#endif
+#ifdef ROCKY_HAS_GDAL
+        auto layer = GDALElevationLayer::create();
+        layer->uri = file;
+        return layer;
+#else
+        return nullptr;
+#endif
+    }
+
+    // Running statistics for one job pool's queue
+    struct QueueDepth
+    {
+        unsigned maxPending = 0u;
+        unsigned maxRunning = 0u;
+        double sumPending = 0.0;
+        unsigned samples = 0u;
+    };
+
+    // Minimal JSON writer for the report (json.h is internal to the SDK)
+    struct JSONWriter
+    {
+        std::ostringstream out;
+        bool first = true;
+        int depth = 0;
+
+        void key(const std::string& name)
+        {
+            out << (first ? "" : ",") << "\n" << std::string(2 * depth, ' ') << "\"" << name << "\": ";
+            first = false;
+        }
+        void begin(const std::string& name = {}, char bracket = '{')
+        {
+            if (!name.empty()) key(name);
+            else if (depth > 0) out << (first ? "" : ",") << "\n" << std::string(2 * depth, ' ');
+            out << bracket;
+            first = true;
+            ++depth;
+        }
+        void end(char bracket = '}')
+        {
+            --depth;
+            out << "\n" << std::string(2 * depth, ' ') << bracket;
+            first = false;
+        }
+        template<typename T>
+        void value(const std::string& name, const T& v)
+        {
+            key(name);
+            if constexpr (std::is_same_v<T, bool>)
+                out << (v ? "true" : "false");
+            else if constexpr (std::is_arithmetic_v<T>)
+                out << std::setprecision(6) << v;
+            else
+                out << "\"" << v << "\"";
+        }
+        void bytes(const std::string& name, const TerrainTilePager::ResidentBytes& b)
+        {
+            begin(name);
+            value("color", b.color);
+            value("elevation", b.elevation);
+            value("geometry", b.geometry);
+            value("total", b.total());
+            end();
+        }
+    };
+}
+
+int main(int argc, char** argv)
+{
+    vsg::CommandLine arguments(&argc, argv);
+    if (arguments.read({ "--help", "-h" }))
+        return usage(argv[0]);
+
+    std::string imageFile, elevationFile, outFile, cachePath;
+    glm::dvec3 from{ -100.0, 35.0, 5e6 }, to{ -77.0, 39.0, 2e3 };
+    unsigned frames = 600u, fps = 60u, budget = 0u, concurrency = 0u;
+    double settle = 30.0;
+    unsigned viewportWidth = 1920u, viewportHeight = 1080u;
+
+    arguments.read("--image", imageFile);
+    arguments.read("--elevation", elevationFile);
+    arguments.read("--from", from.x, from.y, from.z);
+    arguments.read("--to", to.x, to.y, to.z);
+    arguments.read("--frames", frames);
+    arguments.read("--fps", fps);
+    arguments.read("--settle", settle);
+    arguments.read("--viewport", viewportWidth, viewportHeight);
+    arguments.read("--out", outFile);
+    bool skipLOD = arguments.read("--skip-lod");
+    bool setBudget = arguments.read("--budget", budget);
+    bool textureArrays = arguments.read("--texture-arrays");
+    bool compressTextures = arguments.read("--compress-textures");
+    bool compactTerrain = arguments.read("--compact-terrain");
+    bool setConcurrency = arguments.read("--concurrency", concurrency);
+    arguments.read("--cache", cachePath);
+
+    if (imageFile.empty() && elevationFile.empty())
+        return usage(argv[0]);
+
+    frames = std::max(frames, 1u);
+    fps = std::max(fps, 1u);
+
+    // A viewer with no windows: nothing gets compiled or recorded, but the update
+    // operations (terrain paging, merging) run as usual.
+    auto viewer = vsg::Viewer::create();
+    auto context = VSGContextFactory::create(viewer, argc, argv);
+    auto mapNode = MapNode::create(context);
+
+    if (!cachePath.empty())
+    {
+        DiskContentCache::Settings cacheSettings;
+        cacheSettings.path = cachePath;
+        auto r = DiskContentCache::create(cacheSettings);
+        if (r.failed())
+        {
+            Log()->warn(r.error().string());
+            return usage(argv[0]);
+        }
+        context->io.services().contentCache = r.value();
+    }
+
+    auto& settings = mapNode->terrainSettings();
+    if (skipLOD) settings.skipLOD = true;
+    if (setBudget) settings.residencyBudget = budget;
+    if (textureArrays) settings.textureArrays = true;
+    if (compressTextures) settings.compressTextures = true;
+    if (compactTerrain) settings.compactTerrain = true;
+    if (setConcurrency) settings.concurrency = concurrency;
+
+    if (!imageFile.empty())
+    {
+        auto layer = createImageLayer(imageFile);
+        if (!layer)
+            return usage(argv[0]);
+        mapNode->map->add(layer);
+    }
+
+    if (!elevationFile.empty())
+    {
+        auto layer = createElevationLayer(elevationFile);
+        if (!layer)
+            return usage(argv[0]);
+        mapNode->map->add(layer);
+    }
+
+    // The record traversal is only passed along to the pager's ping; nothing is recorded.
+    auto record = vsg::RecordTraversal::create();
+
+    TerrainTileSimulatedView view;
+    view.record = record.get();
+    view.viewportHeight = (double)viewportHeight;
+    view.aspectRatio = (double)viewportWidth / (double)viewportHeight;
+    view.horizon.setEllipsoid(mapNode->srs().ellipsoid());
+
+    auto& ellipsoid = mapNode->srs().ellipsoid();
+    const auto frameTime = std::chrono::nanoseconds(1000000000 / fps);
+
+    std::map<std::string, QueueDepth> queues;
+    std::size_t maxTilesDrawn = 0u;
+
+    // Runs one frame: update (paging, merging), then a simulated record from
+    // the camera, then a wait until the frame's time is up.
+    auto runFrame = [&](const glm::dvec3& lla)
+        {
+            auto start = std::chrono::steady_clock::now();
+
+            if (!viewer->advanceToNextFrame())
+                return false;
+
+            viewer->update();
+
+            glm::dvec3 ground{ lla.x, lla.y, 0.0 };
+            view.eye = ellipsoid.geodeticToGeocentric(lla);
+            view.lookVector = glm::normalize(ellipsoid.geodeticToGeocentric(ground) - view.eye);
+            view.horizon.setEye(view.eye);
+            view.frame = viewer->getFrameStamp()->frameCount;
+            view.time = viewer->getFrameStamp()->time;
+            view.tilesDrawn = 0u;
+
+            for (auto& child : mapNode->terrainNode->children)
+            {
+                if (auto profileNode = child.cast<TerrainProfileNode>())
+                {
+                    for (auto& root : profileNode->children)
+                    {
+                        if (auto tile = root.cast<TerrainTileNode>())
+                            tile->simulate(view);
+                    }
+                }
+            }
+
+            maxTilesDrawn = std::max(maxTilesDrawn, view.tilesDrawn);
+
+            for (auto m : jobs::get_metrics()->all())
+            {
+                if (m)
+                {
+                    auto& q = queues[m->name.empty() ? "default" : m->name];
+                    q.maxPending = std::max(q.maxPending, m->pending.load());
+                    q.maxRunning = std::max(q.maxRunning, m->running.load());
+                    q.sumPending += (double)m->pending.load();
+                    ++q.samples;
+                }
+            }
+
+            std::this_thread::sleep_until(start + frameTime);
+            return true;
+        };
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    // Fly the path. Altitude changes geometrically so that a descent spends
+    // time at every scale, like a real zoom would.
+    for (unsigned i = 0; i < frames; ++i)
+    {
+        double t = frames > 1 ? (double)i / (double)(frames - 1) : 1.0;
+        glm::dvec3 lla{
+            from.x + (to.x - from.x) * t,
+            from.y + (to.y - from.y) * t,
+            std::exp(std::log(std::max(from.z, 1.0)) * (1.0 - t) + std::log(std::max(to.z, 1.0)) * t) };
+
+        if (!runFrame(lla))
+        {
+            Log()->warn("Viewer stopped during the simulation");
+            return -1;
+        }
+    }
+
+    auto t1 = std::chrono::steady_clock::now();
+
+    // Then hold still until nothing is loading, merging, or waiting to be loaded.
+    bool stable = false;
+    unsigned quietFrames = 0u;
+    while (!stable && std::chrono::steady_clock::now() - t1 < std::chrono::duration<double>(settle))
+    {
+        runFrame(to);
+
+        auto pager = mapNode->terrainNode->pagerStats();
+        auto busy =
+            pager.pendingLeaves > 0u ||
+            jobs::get_metrics()->total() > 0 ||
+            context->updateQueueStats().queued > 0u;
+
+        quietFrames = busy ? 0u : quietFrames + 1u;
+        stable = quietFrames >= 3u;
+    }
+
+    auto t2 = std::chrono::steady_clock::now();
+
+    auto pager = mapNode->terrainNode->pagerStats();
+    auto seconds = [](auto d) { return std::chrono::duration<double>(d).count(); };
+
+    JSONWriter json;
+    json.begin();
+    json.value("version", ROCKY_VERSION_STRING);
+    json.value("frames", frames);
+    json.value("fps", fps);
+    json.value("path_seconds", seconds(t1 - t0));
+    json.value("total_seconds", seconds(t2 - t0));
+    json.value("tiles_loaded", pager.loaded);
+    json.value("tiles_per_second", (double)pager.loaded / std::max(seconds(t2 - t0), 1e-9));
+    json.value("stable", stable);
+    json.value("time_to_stable_view_ms", stable ? 1000.0 * seconds(t2 - t1) : -1.0);
+    json.value("last_time_to_final_detail_ms", pager.lastTimeToFinalDetail.count());
+    json.value("max_time_to_final_detail_ms", pager.maxTimeToFinalDetail.count());
+    json.value("resident_tiles", pager.tiles);
+    json.value("max_tiles_drawn", maxTilesDrawn);
+    json.value("canceled_loads", pager.canceledLoads);
+    json.value("placeholder_loads", pager.placeholderLoads);
+    json.value("evictions", pager.evictions);
+    json.bytes("peak_bytes", pager.peakBytes);
+    json.bytes("resident_bytes", pager.residentBytes);
+    json.value("color_bytes_per_tile", pager.tiles > 0 ? pager.residentBytes.color / pager.tiles : 0);
+    if (auto cache = context->io.services().contentCache)
+    {
+        json.begin("content_cache");
+        json.value("disk", !cachePath.empty());
+        json.value("hits", cache->hits());
+        json.value("misses", cache->misses());
+        json.end();
+    }
+    json.begin("uri_reads");
+    json.value("executed", context->io.services().uriFlights.executed());
+    json.value("coalesced", context->io.services().uriFlights.coalesced());
+    json.end();
+    json.begin("job_queues", '[');
+    for (auto& [name, q] : queues)
+    {
+        json.begin();
+        json.value("name", name);
+        json.value("max_pending", q.maxPending);
+        json.value("avg_pending", q.samples > 0 ? q.sumPending / (double)q.samples : 0.0);
+        json.value("max_running", q.maxRunning);
+        json.end();
+    }
+    json.end(']');
+    json.begin("settings");
+    json.value("skipLOD", settings.skipLOD.value());
+    json.value("residencyBudget", settings.residencyBudget.value());
+    json.value("textureArrays", settings.textureArrays.value());
+    json.value("compressTextures", settings.compressTextures.value());
+    json.value("compactTerrain", settings.compactTerrain.value());
+    json.value("concurrency", settings.concurrency.value());
+    json.value("pixelError", settings.pixelError.value());
+    json.value("viewport_height", viewportHeight);
+    json.end();
+    json.end();
+    json.out << std::endl;
+
+    if (outFile.empty())
+    {
+        std::cout << json.out.str();
+    }
+    else
+    {
+        std::ofstream fout(outFile);
+        fout << json.out.str();
+    }
+
+    // stop the loaders before the terrain goes away
+    jobs::shutdown();
+
+    // Jumping straight to the view with skip-LOD, only the roots and the final
+    // leaves should load anything; the tiles in between are placeholders.
+    bool placeholdersOK = !(skipLOD && frames == 1u && pager.placeholderLoads > 0u);
+    if (!placeholdersOK)
+    {
+        Log()->warn("{} placeholder tiles loaded data of their own", pager.placeholderLoads);
+    }
+
+    return stable && placeholdersOK ? 0 : 1;
+}
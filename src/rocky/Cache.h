@@ -7,11 +7,15 @@
 
 #include <rocky/Common.h>
 #include <rocky/Utils.h>
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <mutex>
 #include <shared_mutex>
 #include <list>
 #include <optional>
 #include <unordered_map>
+#include <vector>
 
 namespace ROCKY_NAMESPACE
 {
@@ -19,6 +23,7 @@ namespace ROCKY_NAMESPACE
     class Cache
     {
     public:
+        virtual ~Cache() = default;
         virtual std::optional<V> get(const K& k) = 0;
         virtual void put(const K& k, const V& v) = 0;
         virtual std::size_t capacity() const = 0;
@@ -224,5 +229,248 @@ namespace ROCKY_NAMESPACE
                 _hits = 0, _misses = 0;
             }
         };
+
+        /**
+        * ShardedLRUCache is a thread-safe Least Recently Used cache for heavily shared
+        * use. Entries are spread across independently locked shards by the hash of
+        * their key, each with a hash index and its own LRU order, so lookups are O(1)
+        * and threads working on different keys rarely contend.
+        *
+        * Capacity is a total weight. By default every entry weighs 1, so it is a number
+        * of entries; supply a weigher to budget by something else, like bytes.
+        *
+        * Optionally the cache can filter admissions TinyLFU-style: it keeps an
+        * approximate count of recent requests per key, and when a shard is full a new
+        * entry only gets in if its key has been asked for more often than that of the
+        * entry it would evict. This keeps one-off requests from flushing out entries
+        * that are in regular use.
+        */
+        template<class K, class V, class HASH = std::hash<K>>
+        class ShardedLRUCache : public rocky::Cache<K, V>
+        {
+        public:
+            //! Weight of an entry
+            using Weigher = std::function<std::size_t(const K&, const V&)>;
+
+            //! Constructs a cache.
+            //! \param capacity Total weight the cache can hold
+            //! \param weigher Weight of an entry; if empty, each entry weighs 1
+            //! \param admission Whether to filter admissions by request frequency
+            //! \param shards Maximum number of independently locked shards
+            ShardedLRUCache(std::size_t capacity = 32, Weigher weigher = {}, bool admission = false, unsigned shards = 16u) :
+                _weigher(weigher),
+                _admission(admission),
+                // with a small count-based capacity, each shard still needs a few entries for LRU to mean anything
+                _shards(weigher ? std::max(1u, shards) : std::max(1u, std::min(shards, (unsigned)(capacity / 8))))
+            {
+                setCapacity(capacity);
+            }
+
+            //! Sets the cache capacity and clears all current entries and statistics.
+            inline void setCapacity(std::size_t value)
+            {
+                _capacity = value;
+                auto perShard = (value + _shards.size() - 1) / _shards.size();
+                for (auto& shard : _shards)
+                {
+                    std::scoped_lock L(shard.mutex);
+                    shard.lru.clear();
+                    shard.map.clear();
+                    shard.weight = 0;
+                    shard.capacity = perShard;
+                    if (_admission)
+                        shard.sketch.reset(_weigher ? 4096 : perShard);
+                }
+                _hits = 0;
+                _misses = 0;
+            }
+
+            //! Retrieves the value associated with the given key, if present,
+            //! and makes it the most recently used entry.
+            inline std::optional<V> get(const K& key) override
+            {
+                if (_capacity == 0)
+                    return {};
+                auto hash = HASH()(key);
+                auto& shard = shardFor(hash);
+                std::scoped_lock L(shard.mutex);
+                if (_admission)
+                    shard.sketch.increment(hash);
+                auto it = shard.map.find(key);
+                if (it == shard.map.end()) {
+                    ++_misses;
+                    return {};
+                }
+                shard.lru.splice(shard.lru.end(), shard.lru, it->second);
+                ++_hits;
+                return it->second->value;
+            }
+
+            //! Inserts or updates the value for the given key, and evicts the least
+            //! recently used entries in its shard until the shard is within capacity.
+            //! A value heavier than a whole shard is not stored.
+            inline void put(const K& key, const V& value) override
+            {
+                if (_capacity == 0)
+                    return;
+                auto weight = _weigher ? _weigher(key, value) : 1;
+                auto hash = HASH()(key);
+                auto& shard = shardFor(hash);
+                std::scoped_lock L(shard.mutex);
+                auto it = shard.map.find(key);
+                if (it != shard.map.end()) {
+                    shard.weight -= it->second->weight;
+                    shard.lru.erase(it->second);
+                    shard.map.erase(it);
+                }
+                else if (_admission && shard.weight + weight > shard.capacity && !shard.lru.empty()) {
+                    if (shard.sketch.estimate(hash) <= shard.sketch.estimate(shard.lru.front().hash))
+                        return;
+                }
+                if (weight > shard.capacity)
+                    return;
+                while (shard.weight + weight > shard.capacity) {
+                    auto& victim = shard.lru.front();
+                    shard.weight -= victim.weight;
+                    shard.map.erase(victim.key);
+                    shard.lru.pop_front();
+                }
+                shard.lru.push_back(Entry{ key, value, weight, hash });
+                shard.map[key] = std::prev(shard.lru.end());
+                shard.weight += weight;
+            }
+
+            //! Total weight the cache can hold
+            inline std::size_t capacity() const override
+            {
+                return _capacity;
+            }
+
+            //! Total weight of the entries
+            std::size_t size() const override
+            {
+                std::size_t total = 0;
+                for (auto& shard : _shards) {
+                    std::scoped_lock L(shard.mutex);
+                    total += shard.weight;
+                }
+                return total;
+            }
+
+            //! Number of entries
+            std::size_t count() const
+            {
+                std::size_t total = 0;
+                for (auto& shard : _shards) {
+                    std::scoped_lock L(shard.mutex);
+                    total += shard.map.size();
+                }
+                return total;
+            }
+
+            std::uint32_t hits() const override
+            {
+                return _hits;
+            }
+
+            std::uint32_t misses() const override
+            {
+                return _misses;
+            }
+
+            //! Clears all entries from the cache and resets statistics.
+            inline void clear()
+            {
+                setCapacity(_capacity);
+            }
+
+        private:
+            struct Entry
+            {
+                K key;
+                V value;
+                std::size_t weight;
+                std::size_t hash;
+            };
+
+            // Count-min sketch of recent request frequencies, four 4-bit-range
+            // counters per key. Counts are halved periodically so they favor
+            // recent requests.
+            struct FrequencySketch
+            {
+                std::vector<std::uint8_t> counters;
+                std::size_t mask = 0;
+                std::size_t additions = 0;
+                std::size_t sampleSize = 0;
+
+                void reset(std::size_t expectedEntries)
+                {
+                    std::size_t width = 64;
+                    while (width < expectedEntries && width < (1u << 16))
+                        width <<= 1;
+                    counters.assign(width * 4, 0);
+                    mask = width - 1;
+                    additions = 0;
+                    sampleSize = width * 10;
+                }
+
+                inline std::size_t index(std::size_t hash, unsigned row) const
+                {
+                    std::uint64_t x = ((std::uint64_t)hash + row * 0x9E3779B97F4A7C15ull) * 0xBF58476D1CE4E5B9ull;
+                    x ^= x >> 31;
+                    return row * (mask + 1) + (std::size_t)(x & mask);
+                }
+
+                unsigned estimate(std::size_t hash) const
+                {
+                    unsigned result = 15;
+                    for (unsigned row = 0; row < 4; ++row)
+                        result = std::min(result, (unsigned)counters[index(hash, row)]);
+                    return result;
+                }
+
+                void increment(std::size_t hash)
+                {
+                    // only raise the smallest counters, which keeps collisions from inflating the estimate
+                    auto min = estimate(hash);
+                    if (min < 15) {
+                        for (unsigned row = 0; row < 4; ++row) {
+                            auto& c = counters[index(hash, row)];
+                            if (c == min)
+                                ++c;
+                        }
+                    }
+                    if (++additions >= sampleSize) {
+                        for (auto& c : counters)
+                            c >>= 1;
+                        additions /= 2;
+                    }
+                }
+            };
+
+            struct Shard
+            {
+                mutable std::mutex mutex;
+                std::list<Entry> lru;
+                std::unordered_map<K, typename std::list<Entry>::iterator, HASH> map;
+                std::size_t weight = 0;
+                std::size_t capacity = 0;
+                FrequencySketch sketch;
+            };
+
+            Weigher _weigher;
+            bool _admission = false;
+            std::size_t _capacity = 0;
+            std::vector<Shard> _shards;
+            std::atomic<std::uint32_t> _hits = { 0 };
+            std::atomic<std::uint32_t> _misses = { 0 };
+
+            inline Shard& shardFor(std::size_t hash)
+            {
+                // std::hash is often the identity for integers, so mix before picking a shard
+                std::uint64_t x = (std::uint64_t)hash * 0x9E3779B97F4A7C15ull;
+                return _shards[(std::size_t)(x >> 32) % _shards.size()];
+            }
+        };
     }
 }
\ No newline at end of file
@@ -0,0 +1,282 @@
+/**
+ * rocky c++
+ * Copyright 2025 Pelican Mapping
+ * MIT License
+ */
+#include "CompressedImage.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace ROCKY_NAMESPACE;
+
+namespace
+{
+    using uchar = unsigned char;
+
+    inline std::uint16_t to565(const float* c)
+    {
+        auto r = (unsigned)std::lround(std::clamp(c[0], 0.0f, 255.0f) * 31.0f / 255.0f);
+        auto g = (unsigned)std::lround(std::clamp(c[1], 0.0f, 255.0f) * 63.0f / 255.0f);
+        auto b = (unsigned)std::lround(std::clamp(c[2], 0.0f, 255.0f) * 31.0f / 255.0f);
+        return (std::uint16_t)((r << 11) | (g << 5) | b);
+    }
+
+    inline void from565(std::uint16_t v, int* c)
+    {
+        int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+        c[0] = (r << 3) | (r >> 2);
+        c[1] = (g << 2) | (g >> 4);
+        c[2] = (b << 3) | (b >> 2);
+    }
+
+    // Encodes the colors of a 4x4 block of RGBA pixels as a BC1 color block.
+    // Endpoints come from the block's bounding box, along whichever diagonal
+    // follows the colors' correlation, and are inset slightly since the
+    // interpolated palette entries cover the extremes.
+    void encodeColorBlock(const uchar* block, uchar* out)
+    {
+        float lo[3] = { 255.0f, 255.0f, 255.0f }, hi[3] = { 0.0f, 0.0f, 0.0f };
+        for (unsigned i = 0; i < 16; ++i)
+        {
+            for (unsigned c = 0; c < 3; ++c)
+            {
+                lo[c] = std::min(lo[c], (float)block[i * 4 + c]);
+                hi[c] = std::max(hi[c], (float)block[i * 4 + c]);
+            }
+        }
+
+        float center[3] = { 0.5f * (lo[0] + hi[0]), 0.5f * (lo[1] + hi[1]), 0.5f * (lo[2] + hi[2]) };
+        float cov_rb = 0.0f, cov_gb = 0.0f;
+        for (unsigned i = 0; i < 16; ++i)
+        {
+            float dr = (float)block[i * 4 + 0] - center[0];
+            float dg = (float)block[i * 4 + 1] - center[1];
+            float db = (float)block[i * 4 + 2] - center[2];
+            cov_rb += dr * db;
+            cov_gb += dg * db;
+        }
+        if (cov_rb < 0.0f) std::swap(lo[0], hi[0]);
+        if (cov_gb < 0.0f) std::swap(lo[1], hi[1]);
+
+        for (unsigned c = 0; c < 3; ++c)
+        {
+            float inset = (hi[c] - lo[c]) / 16.0f;
+            hi[c] -= inset;
+            lo[c] += inset;
+        }
+
+        // c0 > c1 selects the four-color mode
+        auto c0 = to565(hi), c1 = to565(lo);
+        if (c0 < c1)
+            std::swap(c0, c1);
+
+        std::uint32_t indices = 0;
+        if (c0 != c1)
+        {
+            int palette[4][3];
+            from565(c0, palette[0]);
+            from565(c1, palette[1]);
+            for (unsigned c = 0; c < 3; ++c)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+
+            for (unsigned i = 0; i < 16; ++i)
+            {
+                unsigned best = 0;
+                int bestError = std::numeric_limits<int>::max();
+                for (unsigned p = 0; p < 4; ++p)
+                {
+                    int dr = (int)block[i * 4 + 0] - palette[p][0];
+                    int dg = (int)block[i * 4 + 1] - palette[p][1];
+                    int db = (int)block[i * 4 + 2] - palette[p][2];
+                    int error = dr * dr + dg * dg + db * db;
+                    if (error < bestError)
+                        best = p, bestError = error;
+                }
+                indices |= best << (2 * i);
+            }
+        }
+
+        out[0] = (uchar)(c0 & 0xff);
+        out[1] = (uchar)(c0 >> 8);
+        out[2] = (uchar)(c1 & 0xff);
+        out[3] = (uchar)(c1 >> 8);
+        for (unsigned b = 0; b < 4; ++b)
+            out[4 + b] = (uchar)((indices >> (8 * b)) & 0xff);
+    }
+
+    // Encodes the alpha values of a 4x4 block of RGBA pixels as a BC3 alpha block.
+    void encodeAlphaBlock(const uchar* block, uchar* out)
+    {
+        int lo = 255, hi = 0;
+        for (unsigned i = 0; i < 16; ++i)
+        {
+            lo = std::min(lo, (int)block[i * 4 + 3]);
+            hi = std::max(hi, (int)block[i * 4 + 3]);
+        }
+
+        // a0 > a1 selects the eight-value mode
+        out[0] = (uchar)hi;
+        out[1] = (uchar)lo;
+
+        std::uint64_t indices = 0;
+        if (hi > lo)
+        {
+            int palette[8] = { hi, lo };
+            for (int p = 2; p < 8; ++p)
+                palette[p] = ((8 - p) * hi + (p - 1) * lo) / 7;
+
+            for (unsigned i = 0; i < 16; ++i)
+            {
+                unsigned best = 0;
+                int bestError = 256;
+                for (unsigned p = 0; p < 8; ++p)
+                {
+                    int error = std::abs((int)block[i * 4 + 3] - palette[p]);
+                    if (error < bestError)
+                        best = p, bestError = error;
+                }
+                indices |= (std::uint64_t)best << (3 * i);
+            }
+        }
+
+        for (unsigned b = 0; b < 6; ++b)
+            out[2 + b] = (uchar)((indices >> (8 * b)) & 0xff);
+    }
+
+    float srgbToLinear(uchar value)
+    {
+        static const auto table = []()
+            {
+                std::array<float, 256> t;
+                for (unsigned i = 0; i < 256; ++i)
+                {
+                    float c = (float)i / 255.0f;
+                    t[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+                }
+                return t;
+            }();
+        return table[value];
+    }
+
+    uchar linearToSrgb(float c)
+    {
+        c = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+        return (uchar)std::lround(std::clamp(c, 0.0f, 1.0f) * 255.0f);
+    }
+
+    // Halves an RGBA image with a box filter. sRGB colors are averaged in linear space.
+    std::vector<uchar> downsample(const std::vector<uchar>& src, unsigned width, unsigned height, bool srgb)
+    {
+        unsigned w = width / 2, h = height / 2;
+        std::vector<uchar> dst(w * h * 4);
+
+        for (unsigned y = 0; y < h; ++y)
+        {
+            for (unsigned x = 0; x < w; ++x)
+            {
+                const uchar* p[4] = {
+                    &src[((2 * y) * width + 2 * x) * 4],
+                    &src[((2 * y) * width + 2 * x + 1) * 4],
+                    &src[((2 * y + 1) * width + 2 * x) * 4],
+                    &src[((2 * y + 1) * width + 2 * x + 1) * 4] };
+
+                uchar* out = &dst[(y * w + x) * 4];
+
+                for (unsigned c = 0; c < 4; ++c)
+                {
+                    if (srgb && c < 3)
+                    {
+                        float sum = srgbToLinear(p[0][c]) + srgbToLinear(p[1][c]) + srgbToLinear(p[2][c]) + srgbToLinear(p[3][c]);
+                        out[c] = linearToSrgb(0.25f * sum);
+                    }
+                    else
+                    {
+                        out[c] = (uchar)((p[0][c] + p[1][c] + p[2][c] + p[3][c] + 2) / 4);
+                    }
+                }
+            }
+        }
+
+        return dst;
+    }
+}
+
+Result<std::shared_ptr<CompressedImage>>
+CompressedImage::create(const Image& image)
+{
+    auto format = image.pixelFormat();
+    bool rgba = format == Image::R8G8B8A8_UNORM || format == Image::R8G8B8A8_SRGB;
+    bool rgb = format == Image::R8G8B8_UNORM || format == Image::R8G8B8_SRGB;
+
+    if (!image.valid() || image.depth() != 1 || (!rgb && !rgba))
+        return Failure(Failure::ConfigurationError, "Only 8-bit RGB and RGBA images can be compressed");
+
+    unsigned width = image.width(), height = image.height();
+    if (width < 4 || height < 4 || width % 4 != 0 || height % 4 != 0)
+        return Failure(Failure::ConfigurationError, "Image dimensions must be multiples of 4 to compress");
+
+    // expand to RGBA so the rest only deals with one layout
+    unsigned channels = rgba ? 4 : 3;
+    const uchar* src = image.data<uchar>();
+    std::vector<uchar> level(width * height * 4);
+    bool opaque = true;
+
+    for (unsigned i = 0; i < width * height; ++i)
+    {
+        level[i * 4 + 0] = src[i * channels + 0];
+        level[i * 4 + 1] = src[i * channels + 1];
+        level[i * 4 + 2] = src[i * channels + 2];
+        level[i * 4 + 3] = rgba ? src[i * channels + 3] : 255;
+        opaque = opaque && level[i * 4 + 3] == 255;
+    }
+
+    auto result = std::make_shared<CompressedImage>();
+    result->format = opaque ? BC1 : BC3;
+    result->srgb = format == Image::R8G8B8_SRGB || format == Image::R8G8B8A8_SRGB;
+    result->width = width;
+    result->height = height;
+
+    unsigned w = width, h = height;
+    for(;;)
+    {
+        auto offset = result->data.size();
+        result->data.resize(offset + (w / 4) * (h / 4) * result->blockSize());
+        uchar* out = result->data.data() + offset;
+
+        uchar block[64];
+        for (unsigned by = 0; by < h / 4; ++by)
+        {
+            for (unsigned bx = 0; bx < w / 4; ++bx)
+            {
+                for (unsigned y = 0; y < 4; ++y)
+                    std::memcpy(&block[y * 16], &level[((by * 4 + y) * w + bx * 4) * 4], 16);
+
+                if (result->format == BC3)
+                {
+                    encodeAlphaBlock(block, out);
+                    out += 8;
+                }
+
+                encodeColorBlock(block, out);
+                out += 8;
+            }
+        }
+
+        ++result->mipLevels;
+
+        // stop before a level that would not be a whole number of blocks
+        if (w % 8 != 0 || h % 8 != 0)
+            break;
+
+        level = downsample(level, w, h, result->srgb);
+        w /= 2, h /= 2;
+    }
+
+    return result;
+}
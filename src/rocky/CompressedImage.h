@@ -0,0 +1,63 @@
+/**
+ * rocky c++
+ * Copyright 2025 Pelican Mapping
+ * MIT License
+ */
+#pragma once
+
+#include <rocky/Image.h>
+#include <rocky/Result.h>
+#include <vector>
+
+namespace ROCKY_NAMESPACE
+{
+    /**
+     * Color image prepared for the GPU: a full mip chain, block-compressed
+     * in 4x4 pixel blocks (BC1 when the image is opaque, BC3 otherwise).
+     * Compressed color takes 4-8x less GPU memory and upload bandwidth
+     * than the RGBA8 original.
+     */
+    class ROCKY_EXPORT CompressedImage
+    {
+    public:
+        enum Format
+        {
+            BC1, // RGB with 1-bit alpha, 8 bytes per block
+            BC3  // RGBA, 16 bytes per block
+        };
+
+        //! Block compression format
+        Format format = BC1;
+
+        //! Whether the color values are in the sRGB color space
+        bool srgb = false;
+
+        //! Width of the first mip level, in pixels
+        unsigned width = 0;
+
+        //! Height of the first mip level, in pixels
+        unsigned height = 0;
+
+        //! Number of mip levels in the data
+        unsigned mipLevels = 0;
+
+        //! Compressed blocks for all mip levels, largest first. Blocks in each
+        //! level are in rows starting at the top left.
+        std::vector<std::uint8_t> data;
+
+        //! Bytes per 4x4 block
+        inline unsigned blockSize() const {
+            return format == BC1 ? 8u : 16u;
+        }
+
+        //! Size of the compressed data, in bytes
+        inline std::size_t sizeInBytes() const {
+            return data.size();
+        }
+
+        //! Generates mip levels for an 8-bit RGB or RGBA image and compresses them.
+        //! The width and height must be multiples of 4. The mip chain stops at the
+        //! last level whose dimensions are still whole blocks.
+        static Result<std::shared_ptr<CompressedImage>> create(const Image& image);
+    };
+}
@@ -103,6 +103,11 @@ ContextImpl::ContextImpl()
     jobs::set_thread_name_function([](const char* value) {
         util::setThreadName(value);
         });
+
+    // Tell the weejobs library how to measure thread CPU time (for adaptive job pools)
+    jobs::set_thread_cpu_time_function([]() {
+        return util::getThreadCPUTime();
+        });
 }
 
 ContextImpl::~ContextImpl()
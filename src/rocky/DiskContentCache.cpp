@@ -0,0 +1,372 @@
+/**
+ * rocky c++
+ * Copyright 2025 Pelican Mapping
+ * MIT License
+ */
+#include "DiskContentCache.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <vector>
+
+using namespace ROCKY_NAMESPACE;
+
+namespace
+{
+    constexpr char MAGIC[4] = { 'R', 'K', 'Y', 'C' };
+    constexpr std::uint32_t VERSION = 2;
+
+    // Fixed-size header at the start of each entry file, followed by the URI,
+    // the content type, the ETag, the Last-Modified date, and the content data.
+    struct Header
+    {
+        char magic[4];
+        std::uint32_t version;
+        std::int64_t stored;  // milliseconds since the epoch
+        std::int64_t expires; // milliseconds since the epoch (zero = never)
+        std::uint32_t staleWhileRevalidate; // seconds
+        std::uint32_t mustRevalidate;
+        std::uint32_t uriSize;
+        std::uint32_t typeSize;
+        std::uint32_t etagSize;
+        std::uint32_t lastModifiedSize;
+        std::uint64_t dataSize;
+
+        std::uint64_t fileSize() const {
+            return sizeof(Header) + uriSize + typeSize + etagSize + lastModifiedSize + dataSize;
+        }
+    };
+
+    // FNV-1a; unlike std::hash it is the same from one build to the next,
+    // which matters since the hash names the files.
+    std::uint64_t hashOf(const std::string& uri)
+    {
+        std::uint64_t hash = 14695981039346656037ull;
+        for (unsigned char c : uri)
+        {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    std::string toHex(std::uint64_t hash)
+    {
+        std::ostringstream buf;
+        buf << std::hex << std::setw(16) << std::setfill('0') << hash;
+        return buf.str();
+    }
+}
+
+DiskContentCache::DiskContentCache(const Settings& settings) :
+    _settings(settings),
+    _root(settings.path)
+{
+    _instance = std::random_device()();
+}
+
+Result<std::shared_ptr<DiskContentCache>>
+DiskContentCache::create(const Settings& settings)
+{
+    if (settings.path.empty())
+        return Failure(Failure::ConfigurationError, "Disk cache requires a path");
+
+    std::error_code ec;
+    std::filesystem::create_directories(settings.path, ec);
+    if (ec)
+        return Failure(Failure::ResourceUnavailable, "Cannot create cache folder \"" + settings.path + "\" : " + ec.message());
+
+    auto cache = std::shared_ptr<DiskContentCache>(new DiskContentCache(settings));
+
+    // Rebuild the index from the entry files. Anything else is either a
+    // temporary file left by an interrupted write, or not ours.
+    for (auto i = std::filesystem::recursive_directory_iterator(cache->_root, ec);
+        !ec && i != std::filesystem::recursive_directory_iterator();
+        i.increment(ec))
+    {
+        if (!i->is_regular_file())
+            continue;
+
+        auto& path = i->path();
+        if (path.extension() == ".tmp")
+        {
+            std::error_code ignore;
+            std::filesystem::remove(path, ignore);
+        }
+        else if (path.extension() == ".blob")
+        {
+            auto name = path.stem().string();
+            if (name.size() == 16 && name.find_first_not_of("0123456789abcdef") == std::string::npos)
+            {
+                std::error_code ignore;
+                auto& entry = cache->_index[std::stoull(name, nullptr, 16)];
+                entry.bytes = i->file_size(ignore);
+                entry.lastUsed = i->last_write_time(ignore);
+                cache->_bytes += entry.bytes;
+            }
+        }
+    }
+
+    // in case the budget is smaller than last time
+    cache->evict();
+
+    return cache;
+}
+
+std::filesystem::path
+DiskContentCache::pathFor(std::uint64_t hash) const
+{
+    auto name = toHex(hash);
+    return _root / name.substr(0, 2) / (name + ".blob");
+}
+
+std::size_t
+DiskContentCache::count() const
+{
+    std::scoped_lock lock(_mutex);
+    return _index.size();
+}
+
+std::size_t
+DiskContentCache::capacity() const
+{
+    return (std::size_t)_settings.maxBytes;
+}
+
+std::size_t
+DiskContentCache::size() const
+{
+    std::scoped_lock lock(_mutex);
+    return (std::size_t)_bytes;
+}
+
+std::optional<Result<Content>>
+DiskContentCache::get(const std::string& uri)
+{
+    auto hash = hashOf(uri);
+    {
+        std::scoped_lock lock(_mutex);
+        if (_index.find(hash) == _index.end())
+        {
+            ++_misses;
+            return {};
+        }
+    }
+
+    auto path = pathFor(hash);
+
+    Header header;
+    Content content;
+    std::string storedURI;
+    bool valid = false;
+    std::error_code ec;
+    auto fileSize = std::filesystem::file_size(path, ec);
+
+    std::ifstream in(path, std::ios_base::in | std::ios_base::binary);
+    if (!ec && in && fileSize >= sizeof(Header) && in.read(reinterpret_cast<char*>(&header), sizeof(Header)))
+    {
+        // check the sizes before allocating anything, since the file could be damaged
+        valid =
+            std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 &&
+            header.version == VERSION &&
+            fileSize == header.fileSize();
+
+        if (valid)
+        {
+            storedURI.resize(header.uriSize);
+            content.type.resize(header.typeSize);
+            content.etag.resize(header.etagSize);
+            content.lastModified.resize(header.lastModifiedSize);
+            std::string data(header.dataSize, '\0');
+            valid =
+                in.read(storedURI.data(), storedURI.size()) &&
+                in.read(content.type.data(), content.type.size()) &&
+                in.read(content.etag.data(), content.etag.size()) &&
+                in.read(content.lastModified.data(), content.lastModified.size()) &&
+                in.read(data.data(), data.size());
+            content.data = std::move(data);
+        }
+    }
+    in.close();
+
+    if (!valid)
+    {
+        remove(hash);
+        ++_misses;
+        return {};
+    }
+
+    // a different URI with the same hash
+    if (storedURI != uri)
+    {
+        ++_misses;
+        return {};
+    }
+
+    content.timestamp = std::chrono::system_clock::time_point(std::chrono::milliseconds(header.stored));
+    content.expires = std::chrono::system_clock::time_point(std::chrono::milliseconds(header.expires));
+    content.staleWhileRevalidate = std::chrono::seconds(header.staleWhileRevalidate);
+    content.mustRevalidate = header.mustRevalidate != 0;
+
+    if (_settings.maxAge.count() > 0 && std::chrono::system_clock::now() - content.timestamp > _settings.maxAge)
+    {
+        remove(hash);
+        ++_misses;
+        return {};
+    }
+
+    // record the access in the file itself so the LRU order survives a restart
+    auto now = std::filesystem::file_time_type::clock::now();
+    {
+        std::scoped_lock lock(_mutex);
+        auto i = _index.find(hash);
+        if (i != _index.end())
+            i->second.lastUsed = now;
+    }
+    std::filesystem::last_write_time(path, now, ec);
+
+    ++_hits;
+    return Result<Content>(std::move(content));
+}
+
+void
+DiskContentCache::put(const std::string& uri, const Result<Content>& content)
+{
+    if (uri.empty() || content.failed())
+        return;
+
+    auto& value = content.value();
+    auto hash = hashOf(uri);
+    auto path = pathFor(hash);
+
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    if (ec)
+        return;
+
+    auto stored = value.timestamp.time_since_epoch().count() != 0 ? value.timestamp : std::chrono::system_clock::now();
+
+    Header header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.stored = std::chrono::duration_cast<std::chrono::milliseconds>(stored.time_since_epoch()).count();
+    header.expires = std::chrono::duration_cast<std::chrono::milliseconds>(value.expires.time_since_epoch()).count();
+    header.staleWhileRevalidate = (std::uint32_t)value.staleWhileRevalidate.count();
+    header.mustRevalidate = value.mustRevalidate ? 1 : 0;
+    header.uriSize = (std::uint32_t)uri.size();
+    header.typeSize = (std::uint32_t)value.type.size();
+    header.etagSize = (std::uint32_t)value.etag.size();
+    header.lastModifiedSize = (std::uint32_t)value.lastModified.size();
+    header.dataSize = (std::uint64_t)value.data.size();
+
+    // Write the whole entry to a file of our own and then rename it into place.
+    // Readers either see the old entry or the new one, and a crash mid-write
+    // leaves only a temporary file that the next startup deletes.
+    auto temp = path;
+    temp += "." + std::to_string(_instance) + "-" + std::to_string(++_writes) + ".tmp";
+    {
+        std::ofstream out(temp, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        out.write(uri.data(), uri.size());
+        out.write(value.type.data(), value.type.size());
+        out.write(value.etag.data(), value.etag.size());
+        out.write(value.lastModified.data(), value.lastModified.size());
+        out.write(value.data.data(), value.data.size());
+        out.close();
+
+        if (!out)
+        {
+            std::filesystem::remove(temp, ec);
+            return;
+        }
+    }
+
+    std::filesystem::rename(temp, path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(temp, ec);
+        return;
+    }
+
+    {
+        std::scoped_lock lock(_mutex);
+        auto& entry = _index[hash];
+        _bytes -= entry.bytes;
+        entry.bytes = header.fileSize();
+        entry.lastUsed = std::filesystem::file_time_type::clock::now();
+        _bytes += entry.bytes;
+    }
+
+    evict();
+}
+
+void
+DiskContentCache::remove(std::uint64_t hash)
+{
+    {
+        std::scoped_lock lock(_mutex);
+        auto i = _index.find(hash);
+        if (i == _index.end())
+            return;
+        _bytes -= i->second.bytes;
+        _index.erase(i);
+    }
+
+    std::error_code ec;
+    std::filesystem::remove(pathFor(hash), ec);
+}
+
+void
+DiskContentCache::evict()
+{
+    std::vector<std::uint64_t> victims;
+    {
+        std::scoped_lock lock(_mutex);
+        if (_bytes <= _settings.maxBytes)
+            return;
+
+        // evict to a bit under the budget so the next few puts don't each do this again
+        auto target = _settings.maxBytes - _settings.maxBytes / 10;
+
+        std::vector<std::pair<std::filesystem::file_time_type, std::uint64_t>> order;
+        order.reserve(_index.size());
+        for (auto& [hash, entry] : _index)
+            order.emplace_back(entry.lastUsed, hash);
+
+        std::sort(order.begin(), order.end());
+
+        for (auto& [lastUsed, hash] : order)
+        {
+            if (_bytes <= target)
+                break;
+            auto i = _index.find(hash);
+            _bytes -= i->second.bytes;
+            _index.erase(i);
+            victims.emplace_back(hash);
+        }
+    }
+
+    std::error_code ec;
+    for (auto hash : victims)
+        std::filesystem::remove(pathFor(hash), ec);
+}
+
+void
+DiskContentCache::clear()
+{
+    std::vector<std::uint64_t> victims;
+    {
+        std::scoped_lock lock(_mutex);
+        for (auto& [hash, entry] : _index)
+            victims.emplace_back(hash);
+        _index.clear();
+        _bytes = 0;
+    }
+
+    std::error_code ec;
+    for (auto hash : victims)
+        std::filesystem::remove(pathFor(hash), ec);
+}
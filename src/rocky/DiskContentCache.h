@@ -0,0 +1,100 @@
+/**
+ * rocky c++
+ * Copyright 2025 Pelican Mapping
+ * MIT License
+ */
+#pragma once
+
+#include <rocky/IOTypes.h>
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
+
+namespace ROCKY_NAMESPACE
+{
+    /**
+     * ContentCache that keeps its entries in a folder on disk, so content
+     * read in one session is still there in the next.
+     *
+     * Each entry is a file named for a hash of its URI. Writes go to a temporary
+     * file that is renamed into place when complete, so a crash never leaves a
+     * partial entry behind; the index is rebuilt from the folder on startup.
+     * When the entries outgrow the size budget, the least recently used ones
+     * are evicted.
+     */
+    class ROCKY_EXPORT DiskContentCache : public ContentCache
+    {
+    public:
+        struct Settings
+        {
+            //! Folder in which to store the entries; created if necessary
+            std::string path;
+
+            //! Total size of the entries to keep, in bytes
+            std::uint64_t maxBytes = 1024ull * 1024ull * 1024ull;
+
+            //! Entries older than this count as misses and are removed (zero = never)
+            std::chrono::seconds maxAge = std::chrono::hours(24 * 30);
+        };
+
+        //! Opens the cache in the settings' folder, creating the folder if it
+        //! does not exist, and indexes any entries already there.
+        static Result<std::shared_ptr<DiskContentCache>> create(const Settings& settings);
+
+        //! Settings this cache was created with
+        const Settings& settings() const {
+            return _settings;
+        }
+
+        //! Number of entries in the cache
+        std::size_t count() const;
+
+        //! Removes all entries
+        void clear();
+
+    public: // ContentCache
+
+        std::optional<Result<Content>> get(const std::string& uri) override;
+
+        //! Stores successful results only.
+        void put(const std::string& uri, const Result<Content>& content) override;
+
+        //! Size budget, in bytes
+        std::size_t capacity() const override;
+
+        //! Total size of the entries, in bytes
+        std::size_t size() const override;
+
+        std::uint32_t hits() const override {
+            return _hits;
+        }
+
+        std::uint32_t misses() const override {
+            return _misses;
+        }
+
+    private:
+        DiskContentCache(const Settings& settings);
+
+        struct Entry
+        {
+            std::uint64_t bytes = 0;
+            std::filesystem::file_time_type lastUsed;
+        };
+
+        Settings _settings;
+        std::filesystem::path _root;
+        mutable std::mutex _mutex;
+        std::unordered_map<std::uint64_t, Entry> _index;
+        std::uint64_t _bytes = 0;
+        std::atomic_uint32_t _hits = { 0 };
+        std::atomic_uint32_t _misses = { 0 };
+        std::atomic_uint32_t _writes = { 0 };
+        std::uint32_t _instance = 0;
+
+        std::filesystem::path pathFor(std::uint64_t hash) const;
+        void remove(std::uint64_t hash);
+        void evict();
+    };
+}
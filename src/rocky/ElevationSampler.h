@@ -5,6 +5,8 @@
  */
 #pragma once
 #include <rocky/ElevationLayer.h>
+#include <rocky/Threading.h>
+#include <iterator>
 
 namespace ROCKY_NAMESPACE
 {
@@ -122,6 +124,21 @@ namespace ROCKY_NAMESPACE
         template<class VEC3_ITER, class PREDICATE>
         inline bool clampRange(VEC3_ITER begin, VEC3_ITER end, PREDICATE&& pred) const;
 
+        //! Clamps a range of points like clampRange(), but splits ranges of at least
+        //! parallelThreshold points into chunks that run in the "weejobs::parallel" pool.
+        //! Each chunk uses its own copy of the session and fetches its own heightfields
+        //! on a worker thread, so this pays off when the tiles are likely to be cached.
+        //! The predicate must be safe to call from multiple threads.
+        template<class VEC3_ITER, class PREDICATE>
+        inline bool clampRangeParallel(VEC3_ITER begin, VEC3_ITER end, PREDICATE&& pred) const;
+
+        //! Clamps every point in a range like clampRange(), in parallel (see above).
+        template<class VEC3_ITER>
+        inline bool clampRangeParallel(VEC3_ITER begin, VEC3_ITER end) const;
+
+        //! Minimum number of points that clampRangeParallel() will split up.
+        static constexpr std::size_t parallelThreshold = 4096u;
+
         //! Force a cache purge if you changed the lod or resolution.
         inline void dirty() {
             _pw = -1.0;
@@ -258,23 +275,7 @@ namespace ROCKY_NAMESPACE
     template<class VEC3_ITER>
     bool ElevationSession::clampRange(VEC3_ITER begin, VEC3_ITER end) const
     {
-        if (!_sampler->layer || !_sampler->layer->status().ok())
-            return false;
-
-        if (begin == end)
-            return true;
-
-        bool result = true;
-
-        for (auto iter = begin; iter != end; ++iter)
-        {
-            if (transformAndClamp(iter->x, iter->y, iter->z))
-                _xform.inverse(iter->x, iter->y, iter->z);
-            else
-                result = false;
-        }
-
-        return result;
+        return clampRange(begin, end, [](const auto&) { return true; });
     }
 
     template<class VEC3_ITER, class PREDICATE>
@@ -304,4 +305,38 @@ namespace ROCKY_NAMESPACE
 
         return result;
     }
+
+    template<class VEC3_ITER>
+    bool ElevationSession::clampRangeParallel(VEC3_ITER begin, VEC3_ITER end) const
+    {
+        return clampRangeParallel(begin, end, [](const auto&) { return true; });
+    }
+
+    template<class VEC3_ITER, class PREDICATE>
+    bool ElevationSession::clampRangeParallel(VEC3_ITER begin, VEC3_ITER end, PREDICATE&& predicate) const
+    {
+        using category = typename std::iterator_traits<VEC3_ITER>::iterator_category;
+        static_assert(std::is_base_of_v<std::random_access_iterator_tag, category>,
+            "ElevationSession::clampRangeParallel() requires random-access iterators");
+
+        auto count = (std::size_t)(end - begin);
+        if (count < parallelThreshold || !_sampler->layer || !_sampler->layer->status().ok())
+            return clampRange(begin, end, predicate);
+
+        using diff_t = typename std::iterator_traits<VEC3_ITER>::difference_type;
+
+        // Each chunk gets its own copy of the session, since the tile cache
+        // is not thread-safe and SRS operations are bound to the thread that
+        // created them.
+        return jobs::parallel_reduce(std::size_t(0), count, true,
+            [&](std::size_t i0, std::size_t i1)
+            {
+                ElevationSession local(*this);
+                local._xform = SRSOperation();
+                local.dirty();
+                return local.clampRange(begin + (diff_t)i0, begin + (diff_t)i1, predicate);
+            },
+            [](bool a, bool b) { return a && b; },
+            parallelThreshold / 4u);
+    }
 }
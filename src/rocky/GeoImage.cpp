@@ -7,6 +7,7 @@
 #include "Math.h"
 #include "Image.h"
 #include "Heightfield.h"
+#include "Threading.h"
 
 #ifdef ROCKY_HAS_GDAL
 #include <gdal.h>
@@ -114,56 +115,58 @@ GeoImage::getPixel(double x, double y, int& s, int& t) const
 void
 GeoImage::composite(const std::vector<GeoImage>& sources, const std::vector<float>& opacities)
 {
-    double x, y;
-    glm::fvec4 pixel;
     bool have_opacities = opacities.size() == sources.size();
 
-    std::vector<SRSOperation> xforms;
-    xforms.reserve(sources.size());
-    for (auto& source : sources)
-        xforms.emplace_back(srs().to(source.srs()));
-
-    for (unsigned s = 0; s < _image->width(); ++s)
-    {
-        for (unsigned t = 0; t < _image->height(); ++t)
+    // Rows are independent, so composite them in parallel.
+    jobs::parallel_for(0u, _image->height(), [&](unsigned t0, unsigned t1)
         {
-            getCoord(s, t, x, y);
+            double x, y;
 
-            for (unsigned layer = 0; layer < _image->depth(); ++layer)
-            {
-                bool pixel_valid = false;
+            // SRS operations are bound to the thread that creates them
+            std::vector<SRSOperation> xforms;
+            xforms.reserve(sources.size());
+            for (auto& source : sources)
+                xforms.emplace_back(srs().to(source.srs()));
 
-                for (int i = 0; i < (int)sources.size(); ++i)
+            for (unsigned t = t0; t < t1; ++t)
+            {
+                for (unsigned s = 0; s < _image->width(); ++s)
                 {
-                    auto& source = sources[i];
-                    float opacity = have_opacities ? opacities[i] : 1.0f;
-                    auto r = source.read(xforms[i], x, y, layer);
-                    if (r.ok())
+                    getCoord(s, t, x, y);
+
+                    for (unsigned layer = 0; layer < _image->depth(); ++layer)
                     {
-                        if (!pixel_valid)
+                        glm::fvec4 pixel(0.0f, 0.0f, 0.0f, 0.0f);
+                        bool pixel_valid = false;
+
+                        for (int i = 0; i < (int)sources.size(); ++i)
                         {
-                            if (pixel.a > 0.0f)
+                            auto& source = sources[i];
+                            float opacity = have_opacities ? opacities[i] : 1.0f;
+                            auto r = source.read(xforms[i], x, y, layer);
+                            if (r.ok())
                             {
-                                pixel.a *= opacity;
-                                pixel_valid = true;
+                                if (!pixel_valid)
+                                {
+                                    if (r.value().a > 0.0f)
+                                    {
+                                        pixel = r.value();
+                                        pixel.a *= opacity;
+                                        pixel_valid = true;
+                                    }
+                                }
+                                else
+                                {
+                                    pixel = glm::mix(pixel, r.value(), r.value().a * opacity);
+                                }
                             }
-                            //if (source.read(pixel, xforms[i], x, y, layer) && pixel.a > 0.0f)
-                            //{
-                            //    pixel.a *= opacity;
-                            //    pixel_valid = true;
-                            //}
                         }
-                        else
-                        {
-                            pixel = glm::mix(pixel, r.value(), r.value().a * opacity);
-                        }
-                    }
 
-                    _image->write(pixel, s, t, layer);
+                        _image->write(pixel, s, t, layer);
+                    }
                 }
             }
-        }
-    }
+        });
 }
 
 GeoImage::ReadResult
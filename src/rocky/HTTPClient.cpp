@@ -0,0 +1,627 @@
+/**
+ * rocky c++
+ * Copyright 2025 Pelican Mapping
+ * MIT License
+ */
+#include "HTTPClient.h"
+#include "Utils.h"
+#include "Version.h"
+#include <algorithm>
+#include <atomic>
+
+#if defined(ROCKY_HAS_CURL)
+    #include <curl/curl.h>
+#elif defined(ROCKY_HAS_HTTPLIB)
+    #ifdef ROCKY_HAS_OPENSSL
+        #define CPPHTTPLIB_OPENSSL_SUPPORT
+    #endif
+    #include <httplib.h>
+#endif
+
+using namespace ROCKY_NAMESPACE;
+
+struct HTTPClient::Transfer
+{
+    Request request;
+    std::string key; // identical requests share a key, and one transfer (see get)
+    std::vector<jobs::future<Result<Response>>> promises; // everyone waiting for the response
+
+#if defined(ROCKY_HAS_CURL)
+    Response response;
+    std::string body;
+    CURL* handle = nullptr;
+    curl_slist* headers = nullptr;
+    char errorBuf[CURL_ERROR_SIZE] = { 0 };
+
+    ~Transfer()
+    {
+        if (handle)
+            curl_easy_cleanup(handle);
+        if (headers)
+            curl_slist_free_all(headers);
+    }
+
+#elif defined(ROCKY_HAS_HTTPLIB)
+    std::string host; // "scheme://host:port", which picks the connection pool
+    std::string path; // path and query
+    std::shared_ptr<httplib::Client> connection; // while it runs
+    std::atomic_bool abandoned = { false }; // everyone stopped waiting, so the connection was closed
+#endif
+
+    //! Whether everyone who asked for the response has stopped waiting for it
+    bool canceled() const
+    {
+        return std::all_of(promises.begin(), promises.end(), [](auto& p) { return p.canceled(); });
+    }
+
+    void resolve(const Result<Response>& result)
+    {
+        for (auto& p : promises)
+            p.resolve(result);
+    }
+};
+
+#ifdef ROCKY_HAS_CURL
+
+namespace
+{
+    size_t write_function(char* ptr, size_t size, size_t nmemb, void* data)
+    {
+        auto* body = static_cast<std::string*>(data);
+        body->append(ptr, size * nmemb);
+        return size * nmemb;
+    }
+
+    size_t header_function(char* ptr, size_t size, size_t nmemb, void* data)
+    {
+        auto* response = static_cast<HTTPClient::Response*>(data);
+        std::string header(ptr, size * nmemb);
+
+        // every response in a chain of redirects starts with a status line;
+        // keep only the headers of the last one.
+        if (util::startsWith(header, "HTTP/"))
+        {
+            response->headers.clear();
+            return size * nmemb;
+        }
+
+        auto colon = header.find(':');
+        if (colon != std::string::npos && colon > 0)
+        {
+            response->headers.emplace_back(
+                util::trim(header.substr(0, colon)),
+                util::trim(header.substr(colon + 1)));
+        }
+        return size * nmemb;
+    }
+}
+
+struct HTTPClient::Host { };
+
+#elif defined(ROCKY_HAS_HTTPLIB)
+
+struct HTTPClient::Host
+{
+    std::vector<std::shared_ptr<httplib::Client>> idle; // open connections ready for a request
+    unsigned busy = 0u; // connections running a request
+};
+
+namespace
+{
+    // "http://host:port/path?query" => "http://host:port" and "/path?query"
+    bool split_url(const std::string& url, std::string& host, std::string& path)
+    {
+        auto scheme = url.find("://");
+        if (scheme == std::string::npos)
+            return false;
+        auto slash = url.find('/', scheme + 3);
+        host = url.substr(0, slash);
+        path = slash != std::string::npos ? url.substr(slash) : "/";
+        return true;
+    }
+}
+
+#else
+
+struct HTTPClient::Host { };
+
+#endif
+
+std::shared_ptr<HTTPClient>
+HTTPClient::create()
+{
+    return create(Settings());
+}
+
+std::shared_ptr<HTTPClient>
+HTTPClient::create(const Settings& settings)
+{
+#if defined(ROCKY_HAS_CURL) || defined(ROCKY_HAS_HTTPLIB)
+    return std::shared_ptr<HTTPClient>(new HTTPClient(settings));
+#else
+    return nullptr;
+#endif
+}
+
+HTTPClient::HTTPClient(const Settings& settings) :
+    _settings(settings)
+{
+#ifdef ROCKY_HAS_CURL
+    auto* multi = curl_multi_init();
+    curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, (long)std::max(1u, settings.maxConnectionsPerHost));
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, settings.http2 ? CURLPIPE_MULTIPLEX : CURLPIPE_NOTHING);
+    _multi = multi;
+
+    _thread = std::thread([this]() { run(); });
+#elif defined(ROCKY_HAS_HTTPLIB)
+    // transfer threads start on demand (see get)
+    _thread = std::thread([this]() { run(); });
+#endif
+}
+
+HTTPClient::~HTTPClient()
+{
+#ifdef ROCKY_HAS_CURL
+    {
+        std::scoped_lock lock(_mutex);
+        _done = true;
+    }
+    curl_multi_wakeup(static_cast<CURLM*>(_multi));
+
+    if (_thread.joinable())
+        _thread.join();
+
+    curl_multi_cleanup(static_cast<CURLM*>(_multi));
+#elif defined(ROCKY_HAS_HTTPLIB)
+    {
+        std::scoped_lock lock(_mutex);
+        _done = true;
+    }
+    _wakeup.notify_all();
+    _ready.notify_all();
+
+    // run() stops the connections underway, so the workers finish right away
+    if (_thread.joinable())
+        _thread.join();
+    for (auto& worker : _workers)
+        worker.join();
+
+    for (auto& t : _queue)
+    {
+        t->resolve(Result<Response>(Failure_OperationCanceled));
+    }
+    _queue.clear();
+    _pending.clear();
+#endif
+}
+
+jobs::future<Result<HTTPClient::Response>>
+HTTPClient::get(const Request& request)
+{
+    jobs::future<Result<Response>> result;
+
+#if defined(ROCKY_HAS_CURL) || defined(ROCKY_HAS_HTTPLIB)
+    auto transfer = std::make_unique<Transfer>();
+    transfer->request = request;
+    transfer->promises.emplace_back(result);
+
+#ifdef ROCKY_HAS_HTTPLIB
+    if (!split_url(request.url, transfer->host, transfer->path))
+    {
+        result.resolve(Result<Response>(Failure(Failure::ConfigurationError, request.url)));
+        return result;
+    }
+#endif
+
+    transfer->key = request.url;
+    for (auto& [name, value] : request.headers)
+        transfer->key += "\n" + name + ": " + value;
+
+    {
+        std::scoped_lock lock(_mutex);
+        if (_done)
+        {
+            result.resolve(Result<Response>(Failure_OperationCanceled));
+            return result;
+        }
+
+        // the same request is already on its way; wait for that response too
+        auto& pending = _pending[transfer->key];
+        if (pending && !pending->canceled())
+        {
+            pending->promises.emplace_back(result);
+            ++_stats.coalesced;
+            return result;
+        }
+        pending = transfer.get();
+        _queue.emplace_back(std::move(transfer));
+
+#ifdef ROCKY_HAS_HTTPLIB
+        // more requests waiting than threads free to take them
+        if (_queue.size() > _idleWorkers && _workers.size() < std::max(1u, _settings.maxRequestsInFlight))
+            _workers.emplace_back([this]() { work(); });
+#endif
+    }
+
+#ifdef ROCKY_HAS_CURL
+    curl_multi_wakeup(static_cast<CURLM*>(_multi));
+#else
+    _ready.notify_one();
+#endif
+
+#else
+    result.resolve(Result<Response>(Failure(Failure::ServiceUnavailable, "HTTPClient requires curl or httplib")));
+#endif
+
+    return result;
+}
+
+HTTPClient::Stats
+HTTPClient::stats() const
+{
+    std::scoped_lock lock(_mutex);
+    Stats stats = _stats;
+    stats.inFlight = (unsigned)_active.size();
+    stats.queued = (unsigned)_queue.size();
+    return stats;
+}
+
+void
+HTTPClient::retire(Transfer& t)
+{
+    auto i = _pending.find(t.key);
+    if (i != _pending.end() && i->second == &t)
+        _pending.erase(i);
+}
+
+#ifdef ROCKY_HAS_CURL
+
+void
+HTTPClient::start(Transfer& t)
+{
+    auto* handle = curl_easy_init();
+    t.handle = handle;
+
+    curl_easy_setopt(handle, CURLOPT_URL, t.request.url.c_str());
+    curl_easy_setopt(handle, CURLOPT_PRIVATE, (void*)&t);
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, write_function);
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, (void*)&t.body);
+    curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, header_function);
+    curl_easy_setopt(handle, CURLOPT_HEADERDATA, (void*)&t.response);
+    curl_easy_setopt(handle, CURLOPT_ERRORBUFFER, t.errorBuf);
+    curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(handle, CURLOPT_MAXREDIRS, 5L);
+    curl_easy_setopt(handle, CURLOPT_FILETIME, 1L);
+    curl_easy_setopt(handle, CURLOPT_USERAGENT, "rocky/" ROCKY_VERSION_STRING);
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT_MS, (long)_settings.connectTimeout.count());
+
+    // An empty string enables all the encodings curl was built with.
+    curl_easy_setopt(handle, CURLOPT_ACCEPT_ENCODING, "");
+
+    // Disable peer certificate verification to allow us to access https servers
+    // where the peer certificate cannot be verified.
+    curl_easy_setopt(handle, CURLOPT_SSL_VERIFYPEER, 0L);
+
+    if (_settings.http2)
+    {
+        curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+
+        // wait for a connection that can multiplex rather than opening a new one
+        curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 1L);
+    }
+
+    for (auto& [name, value] : t.request.headers)
+    {
+        std::string header = name + ": " + value;
+        t.headers = curl_slist_append(t.headers, header.c_str());
+    }
+    curl_easy_setopt(handle, CURLOPT_HTTPHEADER, t.headers);
+
+    curl_multi_add_handle(static_cast<CURLM*>(_multi), handle);
+}
+
+void
+HTTPClient::run()
+{
+    util::setThreadName("rocky::http");
+
+    auto* multi = static_cast<CURLM*>(_multi);
+    auto maxInFlight = std::max(1u, _settings.maxRequestsInFlight);
+
+    for(;;)
+    {
+        {
+            std::scoped_lock lock(_mutex);
+            if (_done)
+                break;
+
+            // drop anything the caller has stopped waiting for
+            auto canceled = [&](auto& t)
+                {
+                    if (!t->canceled())
+                        return false;
+                    if (t->handle)
+                        curl_multi_remove_handle(multi, t->handle);
+                    retire(*t);
+                    ++_stats.canceled;
+                    return true;
+                };
+            _queue.erase(std::remove_if(_queue.begin(), _queue.end(), canceled), _queue.end());
+            _active.erase(std::remove_if(_active.begin(), _active.end(), canceled), _active.end());
+
+            while (!_queue.empty() && _active.size() < maxInFlight)
+            {
+                start(*_queue.front());
+                _active.emplace_back(std::move(_queue.front()));
+                _queue.pop_front();
+            }
+
+            _stats.peakInFlight = std::max(_stats.peakInFlight, (unsigned)_active.size());
+        }
+
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        int remaining = 0;
+        while (CURLMsg* msg = curl_multi_info_read(multi, &remaining))
+        {
+            if (msg->msg != CURLMSG_DONE)
+                continue;
+
+            Transfer* t = nullptr;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char**)&t);
+            auto code = msg->data.result;
+            curl_multi_remove_handle(multi, msg->easy_handle);
+
+            // count it before resolving, so whoever gets the result sees it in stats();
+            // from here on an identical request starts a transfer of its own.
+            {
+                std::scoped_lock lock(_mutex);
+                retire(*t);
+                ++_stats.completed;
+            }
+
+            if (code == CURLE_OK)
+            {
+                long status = 0;
+                curl_easy_getinfo(t->handle, CURLINFO_RESPONSE_CODE, &status);
+                t->response.status = (int)status;
+                t->response.data = std::move(t->body);
+                t->resolve(Result<Response>(std::move(t->response)));
+            }
+            else
+            {
+                // a missing connection is worth retrying; other errors are not
+                bool retry = code == CURLE_COULDNT_CONNECT || code == CURLE_OPERATION_TIMEDOUT;
+                std::string message = t->errorBuf[0] ? t->errorBuf : curl_easy_strerror(code);
+                t->resolve(Result<Response>(Failure(retry ? Failure::ServiceUnavailable : Failure::GeneralError, message)));
+            }
+
+            std::scoped_lock lock(_mutex);
+            _active.erase(std::find_if(_active.begin(), _active.end(), [t](auto& a) { return a.get() == t; }));
+        }
+
+        // sleep until there's network activity or a new request (see get),
+        // but wake up now and then to look for cancelations.
+        curl_multi_poll(multi, nullptr, 0, 100, nullptr);
+    }
+
+    // shutting down; nothing else will resolve these.
+    std::scoped_lock lock(_mutex);
+    for (auto& t : _active)
+    {
+        curl_multi_remove_handle(multi, t->handle);
+        t->resolve(Result<Response>(Failure_OperationCanceled));
+    }
+    for (auto& t : _queue)
+    {
+        t->resolve(Result<Response>(Failure_OperationCanceled));
+    }
+    _active.clear();
+    _queue.clear();
+    _pending.clear();
+}
+
+void
+HTTPClient::work()
+{
+    //nop
+}
+
+#elif defined(ROCKY_HAS_HTTPLIB)
+
+void
+HTTPClient::run()
+{
+    util::setThreadName("rocky::http");
+
+    // httplib only checks for cancelation while it reads a response body, so
+    // this thread looks for requests the caller has stopped waiting for and
+    // closes their connections.
+    std::unique_lock lock(_mutex);
+    while (!_done)
+    {
+        auto canceled = [&](auto& t)
+            {
+                if (!t->canceled())
+                    return false;
+                retire(*t);
+                ++_stats.canceled;
+                return true;
+            };
+        _queue.erase(std::remove_if(_queue.begin(), _queue.end(), canceled), _queue.end());
+
+        // the worker running it counts and discards it when it returns
+        for (auto& t : _active)
+        {
+            if (!t->abandoned && t->canceled())
+            {
+                t->abandoned = true;
+                retire(*t);
+                t->connection->stop();
+            }
+        }
+
+        _wakeup.wait_for(lock, std::chrono::milliseconds(100));
+    }
+
+    // shutting down; don't wait for anything still running.
+    for (auto& t : _active)
+    {
+        t->connection->stop();
+    }
+}
+
+void
+HTTPClient::start(Transfer& t)
+{
+    httplib::Headers headers;
+    for (auto& [name, value] : t.request.headers)
+        headers.emplace(name, value);
+
+    if (headers.count("User-Agent") == 0)
+        headers.emplace("User-Agent", "rocky/" ROCKY_VERSION_STRING);
+
+    // abort the transfer if the callers stop waiting for it partway through
+    auto progress = [&t](std::uint64_t, std::uint64_t) {
+        return !t.abandoned;
+    };
+
+    Result<Response> result = Failure_OperationCanceled;
+
+    auto res = t.connection->Get(t.path, headers, progress);
+    if (res)
+    {
+        Response response;
+        response.status = res->status;
+        for (auto& h : res->headers)
+            response.headers.emplace_back(h.first, h.second);
+        response.data = std::move(res->body);
+        result = std::move(response);
+    }
+    else if (res.error() != httplib::Error::Canceled)
+    {
+        // a missing connection is worth retrying; other errors are not
+        bool retry = !(
+            res.error() == httplib::Error::ExceedRedirectCount ||
+            res.error() == httplib::Error::SSLLoadingCerts ||
+            res.error() == httplib::Error::SSLServerVerification ||
+            res.error() == httplib::Error::SSLServerHostnameVerification ||
+            res.error() == httplib::Error::UnsupportedMultipartBoundaryChars ||
+            res.error() == httplib::Error::Compression);
+
+        result = Failure(retry ? Failure::ServiceUnavailable : Failure::GeneralError, httplib::to_string(res.error()));
+    }
+
+    bool reusable = res && !t.abandoned;
+
+    std::unique_ptr<Transfer> finished;
+    {
+        std::scoped_lock lock(_mutex);
+
+        auto& host = *_hosts[t.host];
+        --host.busy;
+        if (reusable && !_done)
+            host.idle.emplace_back(std::move(t.connection));
+
+        // shutting down stops the connection, so whatever failed is a cancelation
+        if (_done)
+            result = Failure_OperationCanceled;
+
+        auto i = std::find_if(_active.begin(), _active.end(), [&t](auto& a) { return a.get() == &t; });
+        finished = std::move(*i);
+        _active.erase(i);
+        retire(t);
+
+        // count it before resolving, so whoever gets the result sees it in stats()
+        if (t.canceled())
+            ++_stats.canceled;
+        else
+            ++_stats.completed;
+    }
+
+    // a connection is free for any request waiting on this host
+    _ready.notify_one();
+
+    finished->resolve(result);
+}
+
+void
+HTTPClient::work()
+{
+    util::setThreadName("rocky::http");
+
+    auto maxPerHost = std::max(1u, _settings.maxConnectionsPerHost);
+
+    std::unique_lock lock(_mutex);
+    for(;;)
+    {
+        // wait for a request to a host with a connection to spare
+        auto next = _queue.end();
+        ++_idleWorkers;
+        _ready.wait(lock, [&]()
+            {
+                next = std::find_if(_queue.begin(), _queue.end(), [&](auto& t)
+                    {
+                        auto host = _hosts.find(t->host);
+                        return host == _hosts.end() || host->second->busy < maxPerHost;
+                    });
+                return _done || next != _queue.end();
+            });
+        --_idleWorkers;
+
+        if (_done)
+            break;
+
+        auto& host = _hosts[(*next)->host];
+        if (!host)
+            host = std::make_shared<Host>();
+
+        Transfer& t = *next->get();
+        if (!host->idle.empty())
+        {
+            t.connection = std::move(host->idle.back());
+            host->idle.pop_back();
+        }
+        else
+        {
+            t.connection = std::make_shared<httplib::Client>(t.host);
+            t.connection->set_follow_location(true);
+            t.connection->enable_server_certificate_verification(false);
+            t.connection->set_keep_alive(true);
+            t.connection->set_connection_timeout(_settings.connectTimeout);
+        }
+        ++host->busy;
+
+        _active.emplace_back(std::move(*next));
+        _queue.erase(next);
+        _stats.peakInFlight = std::max(_stats.peakInFlight, (unsigned)_active.size());
+
+        lock.unlock();
+        start(t);
+        lock.lock();
+    }
+}
+
+#else
+
+void
+HTTPClient::run()
+{
+    //nop
+}
+
+void
+HTTPClient::start(Transfer&)
+{
+    //nop
+}
+
+void
+HTTPClient::work()
+{
+    //nop
+}
+
+#endif
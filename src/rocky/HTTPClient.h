@@ -0,0 +1,138 @@
+/**
+ * rocky c++
+ * Copyright 2025 Pelican Mapping
+ * MIT License
+ */
+#pragma once
+
+#include <rocky/Result.h>
+#include <rocky/Threading.h>
+#include <rocky/IOTypes.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ROCKY_NAMESPACE
+{
+    /**
+     * Pooled HTTP client. Callers submit a request and get a future back
+     * instead of each holding a blocked socket of their own, and the client
+     * keeps a pool of open connections per host that all requests share.
+     *
+     * With curl (ROCKY_HAS_CURL), a single thread runs every transfer at once
+     * through the curl "multi" interface, which also multiplexes requests over
+     * one connection when the server speaks HTTP/2. With httplib
+     * (ROCKY_HAS_HTTPLIB), the client runs each transfer on one of its own
+     * threads (up to maxRequestsInFlight) over a pooled keep-alive connection.
+     *
+     * URI::readAsync chains its work onto the future, so no other thread waits
+     * for the transfer; URI::read still waits on the future, holding the I/O
+     * pool thread that called it. Identical requests in flight at the same
+     * time share one transfer.
+     *
+     * create() returns nullptr when rocky is built with neither, and URI
+     * falls back to blocking requests.
+     */
+    class ROCKY_EXPORT HTTPClient
+    {
+    public:
+        using Headers = std::vector<std::pair<std::string, std::string>>;
+
+        struct Request
+        {
+            std::string url;
+            Headers headers;
+        };
+
+        struct Response
+        {
+            int status = 0;
+            SharedBuffer data;
+            Headers headers;
+        };
+
+        struct Settings
+        {
+            //! Most transfers to run at once; further requests wait in a queue
+            unsigned maxRequestsInFlight = 64u;
+
+            //! Most connections to open to any one host
+            unsigned maxConnectionsPerHost = 8u;
+
+            //! Whether to negotiate HTTP/2 (and multiplex requests) when the server supports it.
+            //! Only the curl client speaks HTTP/2.
+            bool http2 = true;
+
+            //! How long to wait for a connection before failing the request
+            std::chrono::milliseconds connectTimeout = std::chrono::seconds(10);
+        };
+
+        struct Stats
+        {
+            unsigned inFlight = 0u;     // transfers running now
+            unsigned queued = 0u;       // requests waiting for a free transfer slot
+            unsigned peakInFlight = 0u; // most transfers ever running at once
+            std::uint64_t completed = 0u;
+            std::uint64_t canceled = 0u;
+            std::uint64_t coalesced = 0u; // requests that shared the transfer of an identical one
+        };
+
+        //! Creates a client with default settings and starts its thread.
+        //! @return nullptr if rocky was built without curl or httplib
+        static std::shared_ptr<HTTPClient> create();
+
+        //! Creates a client and starts its thread.
+        //! @return nullptr if rocky was built without curl or httplib
+        static std::shared_ptr<HTTPClient> create(const Settings& settings);
+
+        //! Stops the threads; requests that have not finished fail as canceled.
+        ~HTTPClient();
+
+        //! Queues a GET request. The future resolves when the transfer finishes with
+        //! any HTTP status; it only fails if there was no response at all. A request
+        //! identical to one already underway shares its transfer and response.
+        //! Abandoning the future cancels the transfer once no one else is waiting for it.
+        jobs::future<Result<Response>> get(const Request& request);
+
+        //! Current statistics
+        Stats stats() const;
+
+        //! Settings this client was created with
+        const Settings& settings() const {
+            return _settings;
+        }
+
+    private:
+        struct Transfer;
+        struct Host;
+
+        HTTPClient(const Settings& settings);
+        void run();
+        void start(Transfer& transfer);
+        void work();
+        void retire(Transfer& transfer);
+
+        Settings _settings;
+        void* _multi = nullptr;
+        mutable std::mutex _mutex;
+        std::deque<std::unique_ptr<Transfer>> _queue;
+        std::vector<std::unique_ptr<Transfer>> _active;
+        std::unordered_map<std::string, Transfer*> _pending; // queued or active transfers that can take on more callers
+        Stats _stats;
+        bool _done = false;
+        std::thread _thread;
+
+        // httplib only: the threads running transfers, and the connections per host
+        std::vector<std::thread> _workers;
+        unsigned _idleWorkers = 0u;
+        std::condition_variable _ready;
+        std::condition_variable _wakeup;
+        std::unordered_map<std::string, std::shared_ptr<Host>> _hosts;
+    };
+}
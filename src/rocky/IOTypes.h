@@ -11,6 +11,7 @@
 #include <rocky/Cache.h>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <cstdint>
 
 /**
@@ -23,6 +24,7 @@ namespace ROCKY_NAMESPACE
     class Layer;
     class ContextImpl;
     class GeoExtent;
+    class HTTPClient;
 
     //! Service for reading an image from a URI
     using ReadImageURIService = std::function<
@@ -37,17 +39,102 @@ namespace ROCKY_NAMESPACE
         Result<>(std::shared_ptr<Image> image, std::ostream& stream, std::string contentType, const IOOptions& io)>;
 
     //! Service for tracking invalid request URIs
-    using DealpoolService = util::LRUCache<std::string, Failure>;
+    using DealpoolService = util::ShardedLRUCache<std::string, Failure>;
+
+    //! Immutable string of bytes whose copies all share the same memory, so
+    //! content can pass through caches and coalesced reads without being copied.
+    class SharedBuffer
+    {
+    public:
+        SharedBuffer() = default;
+
+        SharedBuffer(std::string value) :
+            _value(std::make_shared<const std::string>(std::move(value))) { }
+
+        SharedBuffer& operator = (std::string value) {
+            _value = std::make_shared<const std::string>(std::move(value));
+            return *this;
+        }
+
+        //! The bytes as a string
+        const std::string& str() const {
+            static const std::string empty;
+            return _value ? *_value : empty;
+        }
+
+        operator const std::string& () const { return str(); }
+        operator std::string_view() const { return str(); }
+
+        const char* data() const { return str().data(); }
+        const char* c_str() const { return str().c_str(); }
+        std::size_t size() const { return str().size(); }
+        bool empty() const { return str().empty(); }
+
+        bool operator == (const SharedBuffer& rhs) const { return str() == rhs.str(); }
+        bool operator == (const std::string& rhs) const { return str() == rhs; }
+        bool operator == (const char* rhs) const { return str() == rhs; }
+        template<typename T> bool operator != (const T& rhs) const { return !(*this == rhs); }
+
+    private:
+        std::shared_ptr<const std::string> _value;
+    };
 
     //! Holds a generic content buffer and its type.
     struct Content {
         std::string type;   // i.e., content-type or mime-type
-        std::string data;   // actual data buffer
-        std::chrono::system_clock::time_point timestamp;
+        SharedBuffer data;  // actual data buffer (shared by every copy of the content)
+        std::chrono::system_clock::time_point timestamp; // when the content was read
+
+        // HTTP caching information (see URI::read)
+        std::chrono::system_clock::time_point expires;  // when the content goes stale (zero = never)
+        std::chrono::seconds staleWhileRevalidate = {}; // how long past "expires" it may be used while it revalidates
+        bool mustRevalidate = false;                    // never use the content past "expires" without revalidating
+        std::string etag;                               // validators for a conditional request
+        std::string lastModified;
+    };
+
+    //! Content read from a URI, along with information about the read.
+    struct URIResponse
+    {
+        Content content;
+        std::int64_t lastModifiedTime = 0;
+        Duration duration;
+        bool fromCache = false;
+        std::string jsonMetadata;
+
+        URIResponse(const Content& in_content) :
+            content(in_content) {
+        }
+
+        URIResponse(Content&& in_content) :
+            content(std::move(in_content)) {
+        }
     };
 
     //! A cache that stores Content objects by URI.
-    using ContentCache = rocky::util::LRUCache<std::string, Result<Content>>;
+    using ContentCache = rocky::Cache<std::string, Result<Content>>;
+
+    //! ContentCache that holds up to a number of bytes of content in memory
+    //! (see also DiskContentCache)
+    class MemoryContentCache : public util::ShardedLRUCache<std::string, Result<Content>>
+    {
+    public:
+        //! @param maxBytes Total size of the content to keep
+        //! @param admission Whether to keep rarely requested content from displacing
+        //!    content in regular use (see ShardedLRUCache)
+        MemoryContentCache(std::size_t maxBytes, bool admission = false) :
+            ShardedLRUCache(maxBytes, bytesOf, admission) { }
+
+        //! Approximate memory used by an entry
+        static std::size_t bytesOf(const std::string& uri, const Result<Content>& content) {
+            std::size_t bytes = sizeof(Result<Content>) + uri.size();
+            if (content.ok())
+                bytes += content->type.size() + content->data.size() + content->etag.size() + content->lastModified.size();
+            else
+                bytes += content.error().message.size();
+            return bytes;
+        }
+    };
 
     /**
     * Collection of service available to rocky classes that perform IO operations.
@@ -70,8 +157,17 @@ namespace ROCKY_NAMESPACE
         //! Encodes an Image::Ptr to a std::ostream
         WriteImageStreamService writeImageToStream;
 
-        //! Serializes reads from identical URIs
-        util::Gate<std::string> uriGate;
+        //! Coalesces concurrent reads of the same URI into a single read
+        util::SingleFlight<std::string, Result<URIResponse>> uriFlights;
+
+        //! Background revalidations of stale cached URIs in progress
+        util::SingleFlight<std::string, Result<URIResponse>> uriRevalidations;
+
+        //! How long past its expiry time URI::read may return cached content
+        //! right away while it revalidates the content in the background
+        //! ("stale-while-revalidate"). With zero, stale content is revalidated
+        //! before it is returned, unless the server allowed otherwise.
+        std::chrono::seconds staleWhileRevalidate = std::chrono::seconds(0);
 
         //! Caches raw context coming from a URI (like a browser cache)
         std::shared_ptr<ContentCache> contentCache;
@@ -81,6 +177,24 @@ namespace ROCKY_NAMESPACE
 
         //! URI deadpool; URI will use this if available.
         std::shared_ptr<DealpoolService> deadpool;
+
+        //! Shared pooled HTTP client; URI will use this if available
+        //! instead of making its own requests (requires curl or httplib)
+        std::shared_ptr<HTTPClient> httpClient;
+
+        //! Name of the job pool that runs blocking I/O, and turns the shared
+        //! client's responses into content (see URI::readAsync)
+        std::string ioPoolName = "rocky::io";
+
+        //! Number of threads in the I/O job pool. These threads spend most of
+        //! their time waiting on the network, so this can be much larger than
+        //! the number of CPU cores.
+        unsigned ioPoolSize = 32u;
+
+        //! Job pool for running blocking I/O operations
+        jobs::jobpool* ioPool() const {
+            return jobs::get_pool(ioPoolName, ioPoolSize);
+        }
     };
 
     /**
@@ -252,9 +252,6 @@ ImageLayer::assembleTile(const TileKey& key, const IOOptions& io) const
                 layers = std::max(layers, source.image()->depth());
             }
 
-            // assume all tiles to mosaic are in the same SRS.
-            SRSOperation xform = key.extent().srs().to(sources[0].srs());
-
             // new output:
             output = Mosaic::create(sources[0].image()->pixelFormat(), cols, rows, layers);
 
@@ -272,76 +269,89 @@ ImageLayer::assembleTile(const TileKey& key, const IOOptions& io) const
             double dx = (maxx - minx) / (double)(cols);
             double dy = (maxy - miny) / (double)(rows);
 
-            // build a grid of sample points:
-            for (unsigned r = 0; r < rows; ++r)
-            {
-                double y = miny + (0.5*dy) + (dy * (double)r);
-                for (unsigned c = 0; c < cols; ++c)
-                {
-                    double x = minx + (0.5*dx) + (dx * (double)c);
-                    points[r * cols + c] = { x, y, 0.0 };
-                }
-            }
-
             // Working bounds of the SRS itself so we can clamp out-of-bounds points.
             // This is especially important when going from Mercator to Geographic
             // where there's no data beyond +/- 85 degrees.
             auto keyExtentInSourceSRS = key.extent().transform(sources[0].srs());
 
-            // transform the sample points to the SRS of our source data tiles:
-            if (xform.valid())
-            {
-                xform.transformArray(&points[0], points.size());
-
-                // clamp the transformed points to the profile SRS.
-                if (keyExtentInSourceSRS.valid())
+            // build a grid of sample points and transform them to the SRS of our
+            // source data tiles, a block of rows at a time:
+            jobs::parallel_for(0u, rows, [&](unsigned r0, unsigned r1)
                 {
-                    keyExtentInSourceSRS.clamp(points.begin(), points.end());
-                }
-            }
+                    for (unsigned r = r0; r < r1; ++r)
+                    {
+                        double y = miny + (0.5*dy) + (dy * (double)r);
+                        for (unsigned c = 0; c < cols; ++c)
+                        {
+                            double x = minx + (0.5*dx) + (dx * (double)c);
+                            points[r * cols + c] = { x, y, 0.0 };
+                        }
+                    }
+
+                    // assume all tiles to mosaic are in the same SRS.
+                    // (SRS operations are bound to the thread that creates them)
+                    SRSOperation xform = key.extent().srs().to(sources[0].srs());
+
+                    if (xform.valid())
+                    {
+                        auto first = points.begin() + r0 * cols;
+                        auto last = points.begin() + r1 * cols;
 
-            // Indirect indexing lets us do a basic "LRU" cache when looping through multiple images.
-            std::vector<unsigned> indexes(sources.size());
-            std::iota(indexes.begin(), indexes.end(), 0);
+                        xform.transformArray(&(*first), (r1 - r0) * cols);
+
+                        // clamp the transformed points to the profile SRS.
+                        if (keyExtentInSourceSRS.valid())
+                        {
+                            keyExtentInSourceSRS.clamp(first, last);
+                        }
+                    }
+                });
 
             // Mosaic our sources into a single output image.
             glm::fvec4 emptypixel(0.0f, 0.0f, 0.0f, 0.0f);
 
-            for (unsigned layer = 0; layer < layers; ++layer)
-            {
-                for (unsigned r = 0; r < rows; ++r)
+            jobs::parallel_for(0u, rows, [&](unsigned r0, unsigned r1)
                 {
-                    for (unsigned c = 0; c < cols; ++c)
+                    // Indirect indexing lets us do a basic "LRU" cache when looping through multiple images.
+                    std::vector<unsigned> indexes(sources.size());
+                    std::iota(indexes.begin(), indexes.end(), 0);
+
+                    for (unsigned layer = 0; layer < layers; ++layer)
                     {
-                        unsigned i = r * cols + c;
+                        for (unsigned r = r0; r < r1; ++r)
+                        {
+                            for (unsigned c = 0; c < cols; ++c)
+                            {
+                                unsigned i = r * cols + c;
 
-                        // check each source (high to low resolution) until we get a valid pixel.
-                        bool wrote = false;
+                                // check each source (high to low resolution) until we get a valid pixel.
+                                bool wrote = false;
 
-                        for(unsigned n = 0; n < indexes.size(); ++n)
-                        {
-                            unsigned k = useIndirectIndexing ? indexes[n] : n;
+                                for (unsigned n = 0; n < indexes.size(); ++n)
+                                {
+                                    unsigned k = useIndirectIndexing ? indexes[n] : n;
+
+                                    if (layer < sources[k].image()->depth())
+                                    {
+                                        auto pixel = sources[k].read(points[i].x, points[i].y, layer);
+                                        if (pixel.ok() && pixel.value().a > 0.0f)
+                                        {
+                                            output->write(pixel.value(), c, r, layer);
+                                            wrote = true;
+                                            std::swap(indexes[n], indexes[0]);
+                                            break;
+                                        }
+                                    }
+                                }
 
-                            if (layer < sources[k].image()->depth())
-                            {
-                                auto pixel = sources[k].read(points[i].x, points[i].y, layer);
-                                if (pixel.ok() && pixel.value().a > 0.0f)
+                                if (!wrote)
                                 {
-                                    output->write(pixel.value(), c, r, layer);
-                                    wrote = true;
-                                    std::swap(indexes[n], indexes[0]);
-                                    break;
+                                    output->write(emptypixel, c, r, layer);
                                 }
                             }
                         }
-
-                        if (!wrote)
-                        {
-                            output->write(emptypixel, c, r, layer);
-                        }
                     }
-                }
-            }
+                });
         }
     }
 
@@ -5,6 +5,8 @@
  */
 #pragma once
 #include <rocky/Common.h>
+#include <list>
+#include <vector>
 
 namespace ROCKY_NAMESPACE
 {
@@ -121,6 +123,46 @@ namespace ROCKY_NAMESPACE
                 _sentryptr = _list.begin();
             }
 
+            //! Like flush(), but visits the objects that were not updated since the
+            //! last flush from least to most recently updated, and stops as soon as
+            //! done() returns true. Objects not visited stay in the tracker, and keep
+            //! their place in line for the next call.
+            template<typename DONE, typename CALLABLE>
+            inline void flush_oldest(DONE&& done, CALLABLE&& dispose)
+            {
+                ListIterator i = _list.end();
+
+                while (i != _list.begin() && !done())
+                {
+                    --i;
+
+                    if (i == _sentryptr)
+                        break;
+
+                    if (dispose(i->_data))
+                    {
+                        // erase returns the following entry; the next decrement
+                        // moves on to the one before the erased entry.
+                        i = _list.erase(i);
+                        _size--;
+                    }
+                }
+
+                // reset the sentry.
+                _list.splice(_list.begin(), _list, _sentryptr);
+                _sentryptr = _list.begin();
+            }
+
+            //! Calls visit() on each object that was not updated since the last
+            //! flush, from most to least recently updated. Nothing is removed.
+            template<typename CALLABLE>
+            inline void for_each_stale(CALLABLE&& visit)
+            {
+                ListIterator i = _sentryptr;
+                for (++i; i != _list.end(); ++i)
+                    visit(i->_data);
+            }
+
             //! Snapshot of the object list (for debugging)
             std::vector<T> snapshot() const
             {
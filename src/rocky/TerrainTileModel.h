@@ -8,6 +8,7 @@
 #include <rocky/Common.h>
 #include <rocky/TileKey.h>
 #include <rocky/GeoImage.h>
+#include <rocky/CompressedImage.h>
 #include <vector>
 
 namespace ROCKY_NAMESPACE
@@ -33,6 +34,7 @@ namespace ROCKY_NAMESPACE
         struct ROCKY_EXPORT ColorLayer : public Tile
         {
             GeoImage image;
+            std::shared_ptr<CompressedImage> compressed; // GPU-ready version of the image, if requested
             std::shared_ptr<const Layer> layer;
             using Vector = std::vector<ColorLayer>;
         };
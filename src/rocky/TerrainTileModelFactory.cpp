@@ -7,6 +7,7 @@
 #include "Map.h"
 #include "ElevationLayer.h"
 #include "ImageLayer.h"
+#include <algorithm>
 
 #define LC "[TerrainTileModelFactory] "
 
@@ -28,72 +29,195 @@ namespace
             }
         }
     }
+
+    std::size_t count_nodata_values(const GeoImage& geohf)
+    {
+        const float* pixel = geohf.image()->data<float>();
+        auto size = geohf.image()->sizeInPixels();
+        std::size_t count = 0;
+        for (unsigned i = 0; i < size; ++i)
+            count += (pixel[i] == NO_DATA_VALUE);
+        return count;
+    }
+
+    // Fills the no-data heights in "dest" with the heights at the same positions
+    // in "source", and returns how many are still missing. Branch-free so the
+    // compiler can vectorize it.
+    std::size_t merge_heights(float* dest, const float* source, std::size_t size)
+    {
+        std::size_t missing = 0;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            float h = dest[i] == NO_DATA_VALUE ? source[i] : dest[i];
+            dest[i] = h;
+            missing += (h == NO_DATA_VALUE);
+        }
+        return missing;
+    }
+
+    // Fills the no-data heights in "dest" from a source heightfield in the
+    // same profile, which may be an ancestor tile or have a different size.
+    std::size_t merge_heights(GeoImage& dest, const GeoImage& source)
+    {
+        auto& d = *dest.image();
+        auto& s = *source.image();
+
+        if (source.extent() == dest.extent() && s.width() == d.width() && s.height() == d.height())
+        {
+            return merge_heights(d.data<float>(), s.data<float>(), d.sizeInPixels());
+        }
+
+        // map dest UVs to source UVs
+        auto& de = dest.extent();
+        auto& se = source.extent();
+        double scaleU = de.width() / se.width(), biasU = (de.xmin() - se.xmin()) / se.width();
+        double scaleV = de.height() / se.height(), biasV = (de.ymin() - se.ymin()) / se.height();
+
+        // a one-pixel row or column samples the source's edge
+        double du = (double)std::max(1u, d.width() - 1);
+        double dv = (double)std::max(1u, d.height() - 1);
+
+        std::size_t missing = 0;
+        for (unsigned t = 0; t < d.height(); ++t)
+        {
+            double v = (double)t / dv;
+            for (unsigned c = 0; c < d.width(); ++c)
+            {
+                float& h = d.value<float>(c, t);
+                if (h == NO_DATA_VALUE)
+                {
+                    double u = (double)c / du;
+                    h = s.read_bilinear((float)(u * scaleU + biasU), (float)(v * scaleV + biasV)).r;
+                    missing += (h == NO_DATA_VALUE);
+                }
+            }
+        }
+        return missing;
+    }
 }
 
 //.........................................................................
 
 
 TerrainTileModel
-TerrainTileModelFactory::createTileModel(const Map* map, const TileKey& key, const IOOptions& io) const
+TerrainTileModelFactory::createTileModel(const Map* map, const TileKey& key, const IOOptions& io,
+    const jobs::context& in_fetchContext) const
 {
     // Make a new model:
     TerrainTileModel model;
     model.key = key;
     model.revision = map->revision();
 
-    // assemble all the components:
-    addColorLayers(model, map, key, io);
+    jobs::context fetchContext(in_fetchContext);
+    if (!fetchContext.pool)
+        fetchContext.pool = io.services().ioPool();
 
-    unsigned border = 0u;
-    addElevation(model, map, key, io);
+    // assemble all the components. Color and elevation come from different
+    // layers (and usually different servers) so fetch them at the same time.
+    std::vector<std::function<void()>> tasks = {
+        [&]() { addColorLayers(model, map, key, io, fetchContext); },
+        [&]() { addElevation(model, map, key, io); }
+    };
+    util::runConcurrently(tasks, fetchContext, &io);
+
+    if (compressColor)
+        compressColorLayer(model, map, io);
 
     return model;
 }
 
+jobs::future<TerrainTileModel>
+TerrainTileModelFactory::createTileModelAsync(std::shared_ptr<const Map> map, const TileKey& key,
+    const IOOptions& io, const jobs::context& in_context) const
+{
+    jobs::context context(in_context);
+    if (!context.pool)
+        context.pool = io.services().ioPool();
+
+    // fetches share the load's priority
+    jobs::context fetchContext{ "fetch", io.services().ioPool(), context.priority };
+
+    auto create = [factory = *this, map, key, io, fetchContext](Cancelable& c)
+        {
+            return factory.createTileModel(map.get(), key, IOOptions(io, c), fetchContext);
+        };
+
+    return jobs::dispatch(create, context);
+}
+
 namespace
 {
+    std::string ancestorCacheKey(const ImageLayer& layer, const TileKey& key)
+    {
+        return std::to_string(layer.uid()) + '-' + std::to_string(layer.revision()) + '-' +
+            key.str() + '-' + std::to_string(key.profile.hash());
+    }
+
     // return: true if fallback occurred, false if not.
-    bool addImageLayer(const TileKey& startingKey, std::shared_ptr<ImageLayer> layer, bool fallback, TerrainTileModel& model, const IOOptions& io)
+    bool addImageLayer(const TileKey& startingKey, std::shared_ptr<ImageLayer> layer, bool fallback,
+        TerrainTileModelFactory::AncestorImageCache* ancestors, TerrainTileModel::ColorLayer& output, const IOOptions& io)
     {
         GeoImage geoimage;
         Status status;
         bool fell_back = false;
 
         TileKey key = startingKey;
-        if (fallback)
+        while (key.valid() && !geoimage.valid() && !io.canceled())
         {
-            while(key.valid() && !geoimage.valid())
+            // Siblings fall back on the same ancestors, so check whether one
+            // of them already fetched this key (or found nothing there).
+            std::string cacheKey;
+            std::optional<GeoImage> cached;
+            if (ancestors)
+            {
+                cacheKey = ancestorCacheKey(*layer, key);
+                cached = ancestors->get(cacheKey);
+            }
+
+            if (cached.has_value())
+            {
+                geoimage = cached.value();
+            }
+            else
             {
                 auto r = layer->createTile(key, io);
                 if (r.ok())
                 {
                     geoimage = r.release();
+
+                    // only keep images reached by falling back, since the
+                    // siblings will ask for the same ones:
+                    if (ancestors && fell_back)
+                        ancestors->put(cacheKey, geoimage);
                 }
                 else
                 {
                     status = r.error();
-                    key.makeParent();
-                    fell_back = true;
+                    if (ancestors && status.error().type == Failure::ResourceUnavailable)
+                        ancestors->put(cacheKey, GeoImage());
                 }
             }
-        }
-        else
-        {
-            auto r = layer->createTile(key, io);
-            if (r.ok())
-                geoimage = r.release();
-            else
-                status = r.error();
+
+            if (geoimage.valid() || !fallback)
+                break;
+
+            key.makeParent();
+            fell_back = true;
         }
 
         if (geoimage.valid())
         {
-            TerrainTileModel::ColorLayer m;
-            m.layer = layer;
-            m.revision = layer->revision();
-            m.image = std::move(geoimage);
-            m.key = key;
-            model.colorLayers.emplace_back(std::move(m));
+            output.layer = layer;
+            output.revision = layer->revision();
+            output.image = std::move(geoimage);
+            output.key = key;
+
+            // sub-view of the ancestor's image that covers the starting key
+            glm::dmat4 matrix(1.0);
+            for (TileKey k = startingKey; k.level > key.level; k.makeParent())
+                matrix = k.scaleBiasMatrix() * matrix;
+            output.matrix = glm::fmat4(matrix);
+
             //if (layer->dynamic())
             //{
             //    model.requiresUpdate = true;
@@ -116,7 +240,8 @@ namespace
 }
 
 void
-TerrainTileModelFactory::addColorLayers(TerrainTileModel& model, const Map* map, const TileKey& key, const IOOptions& io) const
+TerrainTileModelFactory::addColorLayers(TerrainTileModel& model, const Map* map, const TileKey& key, const IOOptions& io,
+    const jobs::context& fetchContext) const
 {
     struct Candidate {
         ImageLayer::Ptr layer;
@@ -160,19 +285,37 @@ TerrainTileModelFactory::addColorLayers(TerrainTileModel& model, const Map* map,
         {
             // if only one layer intersects we will not need to composite
             // so just get the raw data for this key if there is any.
-            addImageLayer(candidates.front().key, candidates.front().layer, no_fallback, model, io);
+            TerrainTileModel::ColorLayer layer;
+            addImageLayer(candidates.front().key, candidates.front().layer, no_fallback, ancestorImageCache.get(), layer, io);
+            if (layer.image.valid())
+                model.colorLayers.emplace_back(std::move(layer));
         }
 
         else if (candidates.size() > 1)
         {
+            // fetch all the layers at once so the tile takes about as long
+            // as its slowest layer instead of the sum of them all.
+            std::vector<TerrainTileModel::ColorLayer> results(candidates.size());
+            std::vector<char> fellBack(candidates.size(), 0);
+            std::vector<std::function<void()>> tasks;
+
+            for (std::size_t i = 0; i < candidates.size(); ++i)
+            {
+                tasks.emplace_back([&, i]() {
+                    fellBack[i] = addImageLayer(candidates[i].key, candidates[i].layer, yes_fallback, ancestorImageCache.get(), results[i], io); });
+            }
+
+            util::runConcurrently(tasks, fetchContext, &io);
+
             unsigned num_fallbacks = 0;
 
-            for (auto c : candidates)
+            for (std::size_t i = 0; i < candidates.size(); ++i)
             {
-                if (addImageLayer(c.key, c.layer, yes_fallback, model, io))
-                {
+                if (fellBack[i])
                     ++num_fallbacks;
-                }
+
+                if (results[i].image.valid())
+                    model.colorLayers.emplace_back(std::move(results[i]));
             }
 
             // now composite them (unless ALL tiles were fallbacks)
@@ -203,62 +346,172 @@ TerrainTileModelFactory::addColorLayers(TerrainTileModel& model, const Map* map,
                 TerrainTileModel::ColorLayer layer;
                 layer.key = key;
                 layer.revision = tile.revision;
-                layer.matrix = tile.matrix;
                 layer.image = image;
 
                 model.colorLayers.clear();
                 model.colorLayers.emplace_back(std::move(layer));
             }
 
-            else if (model.colorLayers.size() == 1 && model.colorLayers.front().key != key)
+            else if (std::none_of(model.colorLayers.begin(), model.colorLayers.end(), [&](auto& layer) { return layer.key == key; }))
             {
-                // on the off chance that we fell back on a layer, and it ended up
-                // being the only layer, throw it out.
+                // on the off chance that every layer we got is a fallback, throw them
+                // out; the tile already inherited its parent's composite.
                 model.colorLayers.clear();
             }
         }
     }
 }
 
+void
+TerrainTileModelFactory::compressColorLayer(TerrainTileModel& model, const Map* map, const IOOptions& io) const
+{
+    if (model.colorLayers.empty() || !model.colorLayers.front().image.valid() || io.canceled())
+        return;
+
+    auto& layer = model.colorLayers.front();
+
+    // The map revision changes whenever the layers do, so it identifies
+    // the composite along with the tile key.
+    std::string cacheKey;
+    if (compressedImageCache)
+    {
+        cacheKey = model.key.str() + ":" + layer.key.str() + ":" +
+            std::to_string(map->revision()) + ":" + std::to_string(layer.revision);
+
+        if (auto cached = compressedImageCache->get(cacheKey))
+        {
+            layer.compressed = cached.value();
+            return;
+        }
+    }
+
+    // images that can't be compressed go to the GPU as they are.
+    auto r = CompressedImage::create(*layer.image.image());
+    if (r.ok())
+    {
+        layer.compressed = r.value();
+
+        if (compressedImageCache)
+            compressedImageCache->put(cacheKey, layer.compressed);
+    }
+}
 
 bool
 TerrainTileModelFactory::addElevation(TerrainTileModel& model, const Map* map, const TileKey& key, const IOOptions& io) const
 {
+    struct Candidate {
+        ElevationLayer::Ptr layer;
+        TileKey key;
+    };
+
     auto layers = map->layers<ElevationLayer>([&](auto layer) {
         return layer->status().ok(); });
 
-    if (layers.empty())
+    // Collect the layers with data for this tile. Later layers take
+    // priority, the same way later image layers draw on top.
+    std::vector<Candidate> candidates;
+    bool mayHaveData = false;
+
+    for (auto i = layers.rbegin(); i != layers.rend(); ++i)
+    {
+        auto bestKey = (*i)->bestAvailableTileKey(key);
+        if (bestKey.valid())
+        {
+            candidates.emplace_back(Candidate{ *i, bestKey });
+            mayHaveData = mayHaveData || bestKey == key;
+        }
+    }
+
+    // nothing new at this LOD; the tile keeps what it inherited from its parent.
+    if (!mayHaveData)
         return false;
 
-    auto layer = layers.front();
+    // only fall back on ancestors when there's something to composite
+    bool fallback = candidates.size() > 1;
 
-    auto bestKey = layer->bestAvailableTileKey(key);
+    GeoImage heightfield;
+    bool ownsHeightfield = false;
+    std::size_t missing = 0;
 
-    if (bestKey == key)
+    for (auto& c : candidates)
     {
-        auto result = layer->createTile(key, io);
+        // stop once the higher-priority layers cover the whole tile
+        if ((heightfield.valid() && missing == 0) || io.canceled())
+            break;
 
-        if (result.ok())
+        GeoImage source;
+        Status status;
+
+        for (TileKey k = c.key; k.valid() && !source.valid() && !io.canceled(); k.makeParent())
         {
-            replace_nodata_values(result.value());
-
-            model.elevation.heightfield = std::move(result.value());
-            // compute the min/max values for the heightfield - the terrain engine
-            // will use this to make its bounding volume
-            model.elevation.heightfield.computeMinMax();
-            model.elevation.revision = layer->revision();
-            model.elevation.key = key;
+            auto r = c.layer->createTile(k, io);
+            if (r.ok())
+                source = r.release();
+            else
+                status = r.error();
+
+            if (!fallback)
+                break;
         }
 
-        // ResourceUnavailable just means the driver could not produce data
-        // for the tilekey; it is not an actual read error.
-        else if (
-            result.error().type != Failure::ResourceUnavailable &&
-            result.error().type != Failure::OperationCanceled)
+        if (!source.valid())
         {
-            Log()->warn("Problem getting data from \"" + layer->name + "\" : " + result.error().string());
+            // ResourceUnavailable just means the driver could not produce data
+            // for the tilekey; it is not an actual read error.
+            if (status.failed() &&
+                status.error().type != Failure::ResourceUnavailable &&
+                status.error().type != Failure::OperationCanceled)
+            {
+                Log()->warn("Problem getting data from \"" + c.layer->name + "\" : " + status.error().string());
+            }
+            continue;
+        }
+
+        if (!heightfield.valid() && source.extent() == key.extent())
+        {
+            // the common case: use the tile as-is.
+            heightfield = source;
+            missing = count_nodata_values(heightfield);
+            model.elevation.revision = c.layer->revision();
+        }
+        else
+        {
+            if (!heightfield.valid())
+            {
+                // start from an empty tile at the source's resolution
+                auto hf = Heightfield::create(source.image()->width(), source.image()->height());
+                hf.fill(NO_DATA_VALUE);
+                heightfield = GeoImage(hf.image, key.extent());
+                ownsHeightfield = true;
+                model.elevation.revision = c.layer->revision();
+            }
+            else if (!ownsHeightfield)
+            {
+                // copy before filling so we don't modify the layer's tile
+                heightfield = GeoImage(heightfield.image()->clone(), heightfield.extent());
+                ownsHeightfield = true;
+            }
+
+            missing = merge_heights(heightfield, source);
         }
     }
 
-    return model.elevation.heightfield.valid();
+    if (!heightfield.valid())
+        return false;
+
+    if (missing > 0)
+    {
+        if (!ownsHeightfield)
+            heightfield = GeoImage(heightfield.image()->clone(), heightfield.extent());
+
+        replace_nodata_values(heightfield);
+    }
+
+    model.elevation.heightfield = std::move(heightfield);
+    // compute the min/max values for the heightfield - the terrain engine
+    // will use this to make its bounding volume
+    model.elevation.heightfield.computeMinMax();
+    model.elevation.key = key;
+
+    return true;
 }
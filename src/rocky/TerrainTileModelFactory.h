@@ -6,6 +6,8 @@
 #pragma once
 
 #include <rocky/TerrainTileModel.h>
+#include <rocky/IOTypes.h>
+#include <rocky/Cache.h>
 
 namespace ROCKY_NAMESPACE
 {
@@ -24,6 +26,39 @@ namespace ROCKY_NAMESPACE
         //! Whether to composite all color layers into one
         bool compositeColorLayers = true;
 
+        //! Whether to generate mipmaps for the color layer and block-compress it
+        //! for the GPU (see CompressedImage). Happens on the loading thread.
+        bool compressColor = false;
+
+        //! Cache of compressed color images, so that reloading a tile skips the encoding
+        using CompressedImageCache = util::LRUCache<std::string, std::shared_ptr<CompressedImage>>;
+
+        //! Optional compressed image cache to use when compressColor is on
+        std::shared_ptr<CompressedImageCache> compressedImageCache;
+
+        //! Cache of ancestor tiles that children fell back on, holding up to a number
+        //! of bytes of imagery. Siblings that fall back on the same ancestor take it
+        //! from here instead of requesting it again. Empty images mark keys known
+        //! to have no data.
+        class AncestorImageCache : public util::ShardedLRUCache<std::string, GeoImage>
+        {
+        public:
+            //! @param maxBytes Total size of the images to keep
+            AncestorImageCache(std::size_t maxBytes) :
+                ShardedLRUCache(maxBytes, bytesOf) { }
+
+            //! Approximate memory used by an entry
+            static std::size_t bytesOf(const std::string& key, const GeoImage& geoimage) {
+                std::size_t bytes = sizeof(GeoImage) + key.size();
+                if (geoimage.valid())
+                    bytes += geoimage.image()->sizeInBytes();
+                return bytes;
+            }
+        };
+
+        //! Optional ancestor image cache
+        std::shared_ptr<AncestorImageCache> ancestorImageCache;
+
     public:
         TerrainTileModelFactory() = default;
 
@@ -31,12 +66,29 @@ namespace ROCKY_NAMESPACE
         //! @param map Map from which to read source data
         //! @param key Tile key for which to create the model
         //! @param io I/O options and cancelation callback
-        TerrainTileModel createTileModel(const Map* map, const TileKey& key, const IOOptions& io) const;
+        //! @param fetchContext Job context (pool and priority) for the fetches that run
+        //!   alongside each other; by default they run in the I/O pool (see Services::ioPool)
+        TerrainTileModel createTileModel(const Map* map, const TileKey& key, const IOOptions& io,
+            const jobs::context& fetchContext = {}) const;
+
+        //! Creates a tile model asynchronously by running the blocking
+        //! createTileModel() in a job. Abandoning the returned future
+        //! cancels the operation.
+        //! @param map Map from which to read source data
+        //! @param key Tile key for which to create the model
+        //! @param io I/O options
+        //! @param context Job context; if it has no pool, runs in the I/O pool (see Services::ioPool).
+        //!   The fetches take on its priority.
+        jobs::future<TerrainTileModel> createTileModelAsync(std::shared_ptr<const Map> map, const TileKey& key,
+            const IOOptions& io, const jobs::context& context = {}) const;
 
     protected:
 
-        void addColorLayers(TerrainTileModel& model,const Map* map,const TileKey& key,const IOOptions& io) const;
+        void addColorLayers(TerrainTileModel& model, const Map* map, const TileKey& key, const IOOptions& io,
+            const jobs::context& fetchContext) const;
 
         bool addElevation(TerrainTileModel& model, const Map* map, const TileKey& key, const IOOptions& io) const;
+
+        void compressColorLayer(TerrainTileModel& model, const Map* map, const IOOptions& io) const;
     };
 }
@@ -4,6 +4,8 @@
  * MIT License
  */
 #include "Threading.h"
+#include <atomic>
+#include <condition_variable>
 #include <cstdlib>
 #include <cstring>
 
@@ -14,6 +16,10 @@
 #   include <pthread.h>
 #endif
 
+#ifndef _WIN32
+#   include <time.h>
+#endif
+
 void
 rocky::util::setThreadName(const std::string& name)
 {
@@ -46,3 +52,97 @@ rocky::util::setThreadName(const std::string& name)
     }
 #endif
 }
+
+std::chrono::nanoseconds
+rocky::util::getThreadCPUTime()
+{
+#ifdef _WIN32
+    ::FILETIME creation, exit, kernel, user;
+    if (::GetThreadTimes(::GetCurrentThread(), &creation, &exit, &kernel, &user))
+    {
+        // FILETIME is in 100ns units
+        auto k = ((std::uint64_t)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+        auto u = ((std::uint64_t)user.dwHighDateTime << 32) | user.dwLowDateTime;
+        return std::chrono::nanoseconds((k + u) * 100);
+    }
+    return std::chrono::nanoseconds(0);
+
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+    ::timespec ts;
+    if (::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+    {
+        return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+    }
+    return std::chrono::nanoseconds(0);
+
+#else
+    return std::chrono::nanoseconds(0);
+#endif
+}
+
+void
+rocky::util::runConcurrently(const std::vector<std::function<void()>>& tasks, const jobs::context& in_context, const Cancelable* cancelable)
+{
+    auto canceled = [cancelable]() { return cancelable && cancelable->canceled(); };
+
+    if (tasks.size() < 2 || !in_context.pool)
+    {
+        for (auto& task : tasks)
+        {
+            if (!canceled())
+                task();
+        }
+        return;
+    }
+
+    // Each task runs on whichever thread claims it first. The state is shared
+    // because a queued job may only get to run (and find its task already
+    // claimed) after we return.
+    struct State
+    {
+        State(std::size_t n) : claimed(n), remaining(n) { }
+        std::vector<std::atomic_bool> claimed;
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::size_t remaining;
+    };
+    auto state = std::make_shared<State>(tasks.size());
+
+    auto run = [&tasks, canceled](State& s, std::size_t i)
+        {
+            if (!s.claimed[i].exchange(true))
+            {
+                if (!canceled())
+                    tasks[i]();
+
+                std::unique_lock lock(s.mutex);
+                if (--s.remaining == 0)
+                    s.finished.notify_all();
+            }
+        };
+
+    // the group identifies our helpers, so we can discard the ones nobody needs
+    jobs::context context(in_context);
+    if (context.name.empty())
+        context.name = "runConcurrently";
+    context.group = jobs::jobgroup::create();
+
+    for (std::size_t i = 1; i < tasks.size(); ++i)
+    {
+        jobs::dispatch([state, run, i]() { run(*state, i); }, context);
+    }
+
+    for (std::size_t i = 0; i < tasks.size(); ++i)
+    {
+        run(*state, i);
+    }
+
+    // only waits on tasks that are already running elsewhere:
+    {
+        std::unique_lock lock(state->mutex);
+        state->finished.wait(lock, [&]() { return state->remaining == 0; });
+    }
+
+    // every task is done, so any helper still in the queue would do nothing:
+    context.pool->cancel_group(context.group);
+}
@@ -8,6 +8,9 @@
 #include <rocky/weejobs.h>
 #include <vector>
 #include <list>
+#include <functional>
+#include <unordered_map>
+#include <array>
 
 namespace ROCKY_NAMESPACE
 {
@@ -18,6 +21,27 @@ namespace ROCKY_NAMESPACE
         //! Sets the name of the current thread
         extern ROCKY_EXPORT void setThreadName(const std::string& name);
 
+        //! CPU time consumed so far by the current thread
+        //! (or zero if the platform does not support it)
+        extern ROCKY_EXPORT std::chrono::nanoseconds getThreadCPUTime();
+
+        //! Runs a set of tasks concurrently in a job pool and returns once they
+        //! have all finished. The calling thread runs whichever tasks no worker
+        //! has started yet instead of waiting on them, so it is safe to call
+        //! from a job running in the same pool.
+        //! The helper jobs run in the context's pool with its name and priority
+        //! (give them the priority of the calling job, so they don't wait behind
+        //! other work); the context's group is not used. Helpers still queued when
+        //! this returns are discarded. Once the cancelable is canceled, tasks that
+        //! have not started yet are skipped.
+        extern ROCKY_EXPORT void runConcurrently(const std::vector<std::function<void()>>& tasks,
+            const WEEJOBS_NAMESPACE::context& context, const Cancelable* cancelable = nullptr);
+
+        //! Runs a set of tasks concurrently in a job pool, with no priority.
+        inline void runConcurrently(const std::vector<std::function<void()>>& tasks, WEEJOBS_NAMESPACE::jobpool* pool) {
+            runConcurrently(tasks, WEEJOBS_NAMESPACE::context{ "runConcurrently", pool });
+        }
+
         /** Per-thread data store */
         template<class T>
         struct ThreadLocal
@@ -127,6 +151,167 @@ namespace ROCKY_NAMESPACE
             Gate<T>* _gate = nullptr;
             T _key;
         };
+
+        /**
+         * Coalesces concurrent calls for the same key ("single flight").
+         * The first caller for a key runs the function; anyone else who asks
+         * for that key while it is running waits and receives the same result
+         * (one shared, immutable object) instead of running the function again.
+         *
+         * Keys are spread across independently locked shards, and each call
+         * waits on its own condition, so unrelated keys never contend.
+         */
+        template<typename K, typename V, unsigned SHARDS = 16u>
+        class SingleFlight
+        {
+        public:
+            SingleFlight() = default;
+
+            //! Runs func() for the key, or joins a call already running for it.
+            //! If func() throws, the exception goes to the caller that ran it, and
+            //! the callers waiting on it try again.
+            //! @param key Identity of the call
+            //! @param func Function returning a V; runs at most once per concurrent group
+            //! @param cancelable Lets a waiting caller stop waiting (see wake)
+            //! @return The result, or nullptr if the caller was canceled while waiting
+            template<typename FUNC>
+            std::shared_ptr<const V> run(const K& key, FUNC&& func, const Cancelable& cancelable)
+            {
+                auto& shard = _shards[std::hash<K>()(key) % SHARDS];
+
+                for (;;)
+                {
+                    std::shared_ptr<Flight> flight;
+                    bool leader = false;
+                    {
+                        std::scoped_lock lock(shard.mutex);
+                        auto& slot = shard.flights[key];
+                        if (!slot)
+                        {
+                            slot = std::make_shared<Flight>();
+                            leader = true;
+                        }
+                        flight = slot;
+                    }
+
+                    if (leader)
+                    {
+                        ++_executed;
+
+                        // if func() throws, take down the flight and tell the waiters
+                        struct Abort
+                        {
+                            Shard& shard;
+                            const K& key;
+                            Flight& flight;
+                            bool armed = true;
+                            ~Abort()
+                            {
+                                if (!armed)
+                                    return;
+                                {
+                                    std::scoped_lock lock(shard.mutex);
+                                    shard.flights.erase(key);
+                                }
+                                {
+                                    std::scoped_lock lock(flight.mutex);
+                                    flight.failed = true;
+                                }
+                                flight.done.notify_all();
+                            }
+                        } abort{ shard, key, *flight };
+
+                        auto value = std::make_shared<const V>(func());
+                        abort.armed = false;
+
+                        // after this no one else can join
+                        {
+                            std::scoped_lock lock(shard.mutex);
+                            shard.flights.erase(key);
+                        }
+                        {
+                            std::scoped_lock lock(flight->mutex);
+                            flight->value = value;
+                        }
+                        flight->done.notify_all();
+                        return value;
+                    }
+
+                    else
+                    {
+                        std::unique_lock lock(flight->mutex);
+                        while (!flight->value && !flight->failed)
+                        {
+                            if (cancelable.canceled())
+                                return {};
+                            flight->done.wait(lock);
+                        }
+
+                        // the leader threw, so there's nothing to share; start over
+                        if (flight->failed)
+                            continue;
+
+                        ++_coalesced;
+                        return flight->value;
+                    }
+                }
+            }
+
+            //! Wakes every waiting caller so it checks its cancelable again.
+            //! Waiters otherwise sleep until the call they joined finishes, so
+            //! call this after canceling work that might be waiting here.
+            void wake()
+            {
+                for (auto& shard : _shards)
+                {
+                    std::scoped_lock lock(shard.mutex);
+                    for (auto& [key, flight] : shard.flights)
+                    {
+                        // taking the flight's lock means a waiter is either asleep or
+                        // has yet to check its cancelable, so it can't miss the wakeup
+                        { std::scoped_lock flight_lock(flight->mutex); }
+                        flight->done.notify_all();
+                    }
+                }
+            }
+
+            //! Whether a call for the key is running right now
+            bool running(const K& key) const
+            {
+                auto& shard = _shards[std::hash<K>()(key) % SHARDS];
+                std::scoped_lock lock(shard.mutex);
+                return shard.flights.count(key) > 0;
+            }
+
+            //! Number of calls that actually ran their function
+            std::uint64_t executed() const {
+                return _executed;
+            }
+
+            //! Number of calls that received the result of another call instead
+            std::uint64_t coalesced() const {
+                return _coalesced;
+            }
+
+        private:
+            struct Flight
+            {
+                std::mutex mutex;
+                std::condition_variable done;
+                std::shared_ptr<const V> value;
+                bool failed = false;
+            };
+
+            struct Shard
+            {
+                mutable std::mutex mutex;
+                std::unordered_map<K, std::shared_ptr<Flight>> flights;
+            };
+
+            std::array<Shard, SHARDS> _shards;
+            std::atomic<std::uint64_t> _executed = { 0u };
+            std::atomic<std::uint64_t> _coalesced = { 0u };
+        };
     }
 
 } // namepsace rocky::util
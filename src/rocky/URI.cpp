@@ -11,6 +11,8 @@
 #include "Version.h"
 #include "json.h"
 
+#include <algorithm>
+#include <cstdio>
 #include <fstream>
 #include <sstream>
 #include <random>
@@ -115,32 +117,15 @@ namespace
             return "";
     }
     
-    struct KeyValuePair
-    {
-        std::string name;
-        std::string value;
-    };
-
-    struct HTTPRequest
-    {
-        std::string url;
-        std::vector<KeyValuePair> parameters;
-        std::vector<KeyValuePair> headers;
-    };
-
-    struct HTTPResponse
-    {
-        int status;
-        std::string data;
-        std::vector<KeyValuePair> headers;
-    };
+    using HTTPRequest = HTTPClient::Request;
+    using HTTPResponse = HTTPClient::Response;
 
-    std::string findHeader(const std::vector<KeyValuePair>& headers, const std::string& name)
+    std::string findHeader(const HTTPClient::Headers& headers, const std::string& name)
     {
-        for (auto& h : headers)
+        for (auto& [key, value] : headers)
         {
-            if (util::ciEquals(h.name, name))
-                return h.value;
+            if (util::ciEquals(key, name))
+                return value;
         }
         return {};
     }
@@ -191,18 +176,27 @@ namespace
 
         void writeHeader(const char* ptr, size_t realsize)
         {
-            std::string header(ptr);
+            std::string header(ptr, realsize);
+
+            // every response in a chain of redirects starts with a status line;
+            // keep only the headers of the last one.
+            if (util::startsWith(header, "HTTP/"))
+            {
+                headers.clear();
+                return;
+            }
+
             std::size_t colon = header.find_first_of(':');
             if (colon != std::string::npos && colon > 0 && colon < header.length() - 1)
             {
-                headers.emplace_back(KeyValuePair{
+                headers.emplace_back(
                     util::trim(header.substr(0, colon)),
-                    util::trim(header.substr(colon + 1)) });
+                    util::trim(header.substr(colon + 1)));
             }
         }
 
         std::stringstream stream;
-        std::vector<KeyValuePair> headers;
+        HTTPClient::Headers headers;
     };
 
     static size_t stream_object_write_function(void* ptr, size_t size, size_t nmemb, void* data)
@@ -221,6 +215,13 @@ namespace
         return realsize;
     }
 
+    // aborts a transfer when the operation that requested it is canceled
+    static int transfer_progress_function(void* data, curl_off_t, curl_off_t, curl_off_t, curl_off_t)
+    {
+        auto* io = (const IOOptions*)data;
+        return (io && io->canceled()) ? 1 : 0;
+    }
+
     struct CURLHandle
     {
         CURL* handle = nullptr;
@@ -264,6 +265,10 @@ namespace
             // where the peer certificate cannot be verified.
             curl_easy_setopt(handle, CURLOPT_SSL_VERIFYPEER, (void*)0);
 
+            // Check for cancelation periodically during the transfer.
+            curl_easy_setopt(handle, CURLOPT_XFERINFOFUNCTION, transfer_progress_function);
+            curl_easy_setopt(handle, CURLOPT_NOPROGRESS, 0L);
+
             basket.handle = handle;
         }
 
@@ -272,9 +277,9 @@ namespace
 
         // request headers:
         struct curl_slist* headers = nullptr;
-        for (auto& h : request.headers)
+        for (auto& [name, value] : request.headers)
         {
-            std::string header = h.name + ": " + h.value;
+            std::string header = name + ": " + value;
             headers = curl_slist_append(headers, header.c_str());
         }
         curl_easy_setopt(handle, CURLOPT_HTTPHEADER, headers);
@@ -283,6 +288,7 @@ namespace
         stream_object so;
         curl_easy_setopt(handle, CURLOPT_WRITEDATA, (void*)&so);
         curl_easy_setopt(handle, CURLOPT_HEADERDATA, (void*)&so);
+        curl_easy_setopt(handle, CURLOPT_XFERINFODATA, (void*)&io);
 
         char errorBuf[CURL_ERROR_SIZE];
         errorBuf[0] = 0;
@@ -306,8 +312,19 @@ namespace
                     std::this_thread::sleep_for(delay);
             }
 
+            if (io.canceled())
+            {
+                result = CURLE_ABORTED_BY_CALLBACK;
+                break;
+            }
+
             result = curl_easy_perform(handle);
 
+            if (result == CURLE_ABORTED_BY_CALLBACK)
+            {
+                break;
+            }
+
             if (result == CURLE_COULDNT_CONNECT || result == CURLE_OPERATION_TIMEDOUT)
             {
                 continue;
@@ -325,6 +342,19 @@ namespace
 
         //curl_easy_cleanup(handle);
 
+        curl_slist_free_all(headers);
+        curl_easy_setopt(handle, CURLOPT_HTTPHEADER, nullptr);
+        curl_easy_setopt(handle, CURLOPT_XFERINFODATA, nullptr);
+
+        if (result == CURLE_ABORTED_BY_CALLBACK)
+        {
+            if (httpDebug)
+            {
+                Log()->info(LC "(---) HTTP GET {} (canceled)", request.url);
+            }
+            return Failure_OperationCanceled;
+        }
+
         if (result == CURLE_OK)
         {
             response.data = so.stream.str();
@@ -339,7 +369,7 @@ namespace
                 Log()->info(LC "({} {:3d}ms {:6}b {}) HTTP GET {}", response.status, (int)dur_ms, response.data.size(), ct, request.url);
             }
 
-            if (response.status != 200)
+            if (response.status != 200 && response.status != 304) // 304 = NOT MODIFIED (see URI::fetchRemote)
             {
                 if (response.status == 404) // NOT FOUND (permanent)
                 {
@@ -360,14 +390,102 @@ namespace
     }
 #endif
 
+    // Turns a response from the shared client into an error unless it has content
+    // (or confirms that cached content is still good).
+    Result<HTTPResponse> http_status(HTTPResponse&& response, const std::string& url)
+    {
+        if (response.status != 200 && response.status != 304) // 304 = NOT MODIFIED (see URI::fetchRemote)
+        {
+            if (response.status == 404) // NOT FOUND (permanent)
+            {
+                return Failure(Failure::ResourceUnavailable, url);
+            }
+            else
+            {
+                return Failure(Failure::ResourceUnavailable, std::to_string(response.status));
+            }
+        }
+
+        return std::move(response);
+    }
+
+    // Submits the request to the shared client and waits for the result,
+    // with the same retry policy as http_get_curl.
+    Result<HTTPResponse> http_get_client(HTTPClient& client, const HTTPRequest& request, const IOOptions& io)
+    {
+        std::random_device device;
+        std::default_random_engine engine(device());
+        std::uniform_real_distribution distribution;
+
+        auto t0 = std::chrono::steady_clock::now();
+
+        Result<HTTPClient::Response> result = Failure_ServiceUnavailable;
+        auto max_attempts = std::max(1u, io.maxNetworkAttempts);
+        unsigned attempts = 0;
+        while (attempts++ < max_attempts)
+        {
+            if (attempts > 1)
+            {
+                auto delay = 1000ms * std::pow(2, attempts + distribution(engine));
+                if (!io.canceled())
+                    std::this_thread::sleep_for(delay);
+            }
+
+            if (io.canceled())
+                break;
+
+            // Wait for the transfer; if the operation is canceled first, leaving
+            // scope abandons the future, which cancels the transfer.
+            auto future = client.get(request);
+            if (!future.wait(io))
+                break;
+
+            result = future.value();
+
+            if (result.failed() && result.error().type == Failure::ServiceUnavailable)
+                continue;
+
+            if (result.ok() && result.value().status == 429) // TOO MANY REQUESTS (rate limiting)
+                continue;
+
+            break;
+        }
+
+        if (io.canceled())
+        {
+            if (httpDebug)
+            {
+                Log()->info(LC "(---) HTTP GET {} (canceled)", request.url);
+            }
+            return Failure_OperationCanceled;
+        }
+
+        if (result.failed())
+        {
+            return result.error();
+        }
+
+        HTTPResponse response = std::move(result.value());
+
+        if (httpDebug)
+        {
+            auto dur_ms = 1e-6 * (double)(std::chrono::steady_clock::now() - t0).count();
+            auto cti = findHeader(response.headers, "Content-Type");
+            auto ct = cti.empty() ? "unknown" : cti;
+            Log()->info(LC "({} {:3d}ms {:6}b {}) HTTP GET {}", response.status, (int)dur_ms, response.data.size(), ct, request.url);
+        }
+
+        return http_status(std::move(response), request.url);
+    }
+
 #ifdef ROCKY_HAS_HTTPLIB
     Result<HTTPResponse> http_get_httplib(const HTTPRequest& request, const IOOptions& io)
     {
         httplib::Headers headers;
 
-        for (auto& h : request.headers)
+        for (auto& [name, value] : request.headers)
         {
-            headers.insert(std::make_pair(h.name, h.value));
+            headers.insert(std::make_pair(name, value));
         }
 
         // insert a default User-Agent unless the user passed one in.
@@ -422,8 +540,13 @@ namespace
                 if (io.canceled())
                     return Failure_OperationCanceled;
                 
+                // abort the transfer if the operation is canceled along the way
+                auto progress = [&io](std::uint64_t, std::uint64_t) {
+                    return !io.canceled();
+                };
+
                 auto t0 = std::chrono::steady_clock::now();
-                auto res = client.Get(path, params, headers);
+                auto res = client.Get(path, params, headers, progress);
                 auto t1 = std::chrono::steady_clock::now();
 
                 if (res)
@@ -463,7 +586,7 @@ namespace
                             return Failure(Failure::ResourceUnavailable, httplib::status_message(res->status));
                         }
                     }
-                    else if (res->status != 200)
+                    else if (res->status != 200 && res->status != 304) // 304 = NOT MODIFIED (see URI::fetchRemote)
                     {
                         return Failure(Failure::GeneralError, httplib::status_message(res->status));
                     }
@@ -471,7 +594,7 @@ namespace
                     response.status = res->status;
 
                     for (auto& h : res->headers)
-                        response.headers.emplace_back(KeyValuePair{ h.first, h.second });
+                        response.headers.emplace_back(h.first, h.second);
 
                     response.data = std::move(res->body);
 
@@ -485,6 +608,11 @@ namespace
                         Log()->info(LC "(---) HTTP GET {:.2} ({})", request.url, httplib::to_string(res.error()));
                     }
 
+                    if (res.error() == httplib::Error::Canceled)
+                    {
+                        return Failure_OperationCanceled;
+                    }
+
                     constexpr auto unrecoverable = [](httplib::Error error) {
                         return
                             error == httplib::Error::ExceedRedirectCount ||
@@ -502,7 +630,8 @@ namespace
 
                     // retry on a missing connection
                     Log()->info(LC + httplib::to_string(res.error()) + " with " + proto_host_port + "; retrying..");
-                    std::this_thread::sleep_for(1s);
+                    if (!io.canceled())
+                        std::this_thread::sleep_for(1s);
                 }
             }
 
@@ -518,6 +647,9 @@ namespace
 
     Result<HTTPResponse> http_get(const HTTPRequest& request, const IOOptions& io)
     {
+        if (io.services().httpClient)
+            return http_get_client(*io.services().httpClient, request, io);
+
 #if defined(ROCKY_HAS_HTTPLIB)
         return http_get_httplib(request, io);
 #elif defined(ROCKY_HAS_CURL)
@@ -631,34 +763,100 @@ URI::findRotation()
 
 auto URI::read(const IOOptions& io) const -> Result<URIResponse>
 {
-    // protect against multiple threads trying to read the same URI at the same time
-    util::ScopedGate<std::string> gate(io.services().uriGate, full());
+    for(;;)
+    {
+        // Only one read of a URI runs at a time. Anyone else who wants it meanwhile
+        // waits for that read and shares its result, instead of repeating it.
+        auto result = io.services().uriFlights.run(full(), [&]() { return fetch(io); }, io);
+
+        if (!result)
+            return Failure_OperationCanceled;
 
+        // the read we joined was canceled by its own caller, but we still want it
+        if (result->failed() && result->error().type == Failure::OperationCanceled && !io.canceled())
+            continue;
+
+        // the content data is shared, so this copies only the response's metadata
+        return *result;
+    }
+}
+
+auto URI::fetchCached(const IOOptions& io, std::optional<Content>& stale) const -> std::optional<Result<URIResponse>>
+{
     if (io.services().contentCache)
     {
         auto cached = io.services().contentCache->get(full());
         if (cached.has_value() && cached->ok())
         {
-            Result<URIResponse> result(cached->value());
-            result->fromCache = true;
-            return result;
+            auto& content = cached->value();
+            auto now = std::chrono::system_clock::now();
+            bool expired = isRemote() && content.expires.time_since_epoch().count() != 0 && now >= content.expires;
+
+            if (!expired)
+            {
+                Result<URIResponse> result(content);
+                result->fromCache = true;
+                return result;
+            }
+
+            // Stale, but still inside the window in which we may use it while
+            // it revalidates in the background:
+            auto window = std::max(content.staleWhileRevalidate, io.services().staleWhileRevalidate);
+            if (!content.mustRevalidate && now < content.expires + window)
+            {
+                if (!io.services().uriRevalidations.running(full()))
+                {
+                    // The caller may be gone by the time this runs, so it must
+                    // not use the caller's cancelable.
+                    auto revalidate = [uri = *this, io, content]()
+                        {
+                            Cancelable never;
+                            IOOptions options(io, never);
+                            options.services().uriRevalidations.run(uri.full(), [&]() { return uri.fetchRemote(&content, options); }, never);
+                        };
+
+                    jobs::dispatch(revalidate, jobs::context{ "revalidate uri", io.services().ioPool() });
+                }
+
+                Result<URIResponse> result(content);
+                result->fromCache = true;
+                return result;
+            }
+
+            stale = std::move(content);
+            return {};
         }
     }
 
-    Content content;
-
     // check the dead pool, if available.
     if (io.services().deadpool)
     {
         if (auto r = io.services().deadpool->get(full()))
         {
-            return r.value();
+            return Result<URIResponse>(r.value());
         }
     }
 
+    return {};
+}
+
+auto URI::fetch(const IOOptions& io) const -> Result<URIResponse>
+{
+    std::optional<Content> stale;
+    if (auto result = fetchCached(io, stale))
+    {
+        return std::move(*result);
+    }
+
+    if (stale.has_value())
+    {
+        return fetchRemote(&stale.value(), io);
+    }
+
     if (std::filesystem::exists(full()))
     {
-        auto contentType = inferContentTypeFromFileExtension(full());
+        Content content;
+        content.type = inferContentTypeFromFileExtension(full());
 
         ROCKY_TODO("worry about text or binary open mode?");
 
@@ -666,43 +864,210 @@ auto URI::read(const IOOptions& io) const -> Result<URIResponse>
         std::stringstream buf;
         buf << in.rdbuf() << std::flush;
         content.data = buf.str();
-        content.type = contentType;
         in.close();
+
+        if (io.services().contentCache)
+        {
+            io.services().contentCache->put(full(), Result<Content>(content));
+        }
+
+        return URIResponse(std::move(content));
     }
 
     else if (isRemote())
     {
-        HTTPRequest request{ full() };
+        return fetchRemote(nullptr, io);
+    }
+
+    else
+    {
+        return Failure(Failure::ResourceUnavailable, full());
+    }
+}
+
+std::optional<std::chrono::system_clock::time_point>
+URI::parseHTTPDate(const std::string& value)
+{
+    char weekday[4] = { 0 }, month[4] = { 0 };
+    int day = 0, year = 0, hour = 0, minute = 0, second = 0;
+    if (std::sscanf(value.c_str(), "%3s, %d %3s %d %d:%d:%d", weekday, &day, month, &year, &hour, &minute, &second) != 7)
+        return {};
+
+    static const std::string months = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    auto m = months.find(month);
+    if (m == std::string::npos || m % 3 != 0)
+        return {};
+
+    // days since the epoch in the proleptic Gregorian calendar
+    int mon = (int)m / 3 + 1;
+    int y = year - (mon <= 2 ? 1 : 0);
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (mon > 2 ? mon - 3 : mon + 9) + 2) / 5 + day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    std::int64_t days = (std::int64_t)era * 146097 + doe - 719468;
+
+    return std::chrono::system_clock::time_point(std::chrono::seconds(days * 86400 + hour * 3600 + minute * 60 + second));
+}
+
+bool
+URI::readCachingHeaders(const Headers& headers, Content& content)
+{
+    using namespace std::chrono;
+
+    bool store = true;
+    bool noCache = false;
+    std::optional<seconds> maxAge;
+
+    auto cacheControl = findHeader(headers, "Cache-Control");
+    if (!cacheControl.empty())
+    {
+        content.staleWhileRevalidate = {};
+        content.mustRevalidate = false;
+
+        for (auto& directive : util::StringTokenizer().delim(",").tokenize(cacheControl))
+        {
+            auto eq = directive.find('=');
+            auto name = util::toLower(util::trim(directive.substr(0, eq)));
+            auto value = eq != std::string::npos ? util::trim(directive.substr(eq + 1)) : std::string();
+            auto number = seconds(std::atoll(value.c_str()));
+
+            if (name == "no-store")
+                store = false;
+            else if (name == "no-cache")
+                noCache = true;
+            else if (name == "max-age")
+                maxAge = number;
+            else if (name == "must-revalidate")
+                content.mustRevalidate = true;
+            else if (name == "stale-while-revalidate")
+                content.staleWhileRevalidate = number;
+        }
+    }
+
+    auto etag = findHeader(headers, "ETag");
+    if (!etag.empty())
+        content.etag = etag;
+
+    auto lastModified = findHeader(headers, "Last-Modified");
+    if (!lastModified.empty())
+        content.lastModified = lastModified;
+
+    auto expires = findHeader(headers, "Expires");
+    auto date = parseHTTPDate(findHeader(headers, "Date"));
+    auto modified = parseHTTPDate(lastModified);
+
+    if (noCache)
+    {
+        content.expires = content.timestamp;
+    }
+    else if (maxAge.has_value())
+    {
+        auto age = seconds(std::atoll(findHeader(headers, "Age").c_str()));
+        content.expires = content.timestamp + *maxAge - age;
+    }
+    else if (!expires.empty())
+    {
+        // measure from the server's own clock in case ours disagrees;
+        // an invalid date means already expired.
+        auto when = parseHTTPDate(expires);
+        if (!when.has_value())
+            content.expires = content.timestamp;
+        else if (date.has_value())
+            content.expires = content.timestamp + (*when - *date);
+        else
+            content.expires = *when;
+    }
+    else if (modified.has_value() && content.expires.time_since_epoch().count() == 0)
+    {
+        // no explicit lifetime; the usual heuristic is a tenth of the time
+        // since the last change, within reason.
+        auto since = date.value_or(content.timestamp) - *modified;
+        content.expires = content.timestamp + std::clamp(
+            duration_cast<seconds>(since / 10), seconds(0), duration_cast<seconds>(hours(24)));
+    }
+
+    return store;
+}
+
+auto URI::fetchRemote(const Content* cached, const IOOptions& io) const -> Result<URIResponse>
+{
+    auto request = remoteRequest(cached);
+    return readResponse(http_get(request, io), request.url, cached, io);
+}
+
+auto URI::remoteRequest(const Content* cached) const -> HTTPClient::Request
+{
+    HTTPRequest request{ full() };
+
+    for(auto& header : _context.headers)
+    {
+        request.headers.emplace_back(header.first, header.second);
+    }
+
+    // ask the server to send the content only if it changed since we cached it
+    if (cached && !cached->etag.empty())
+    {
+        request.headers.emplace_back("If-None-Match", cached->etag);
+    }
+    if (cached && !cached->lastModified.empty())
+    {
+        request.headers.emplace_back("If-Modified-Since", cached->lastModified);
+    }
+
+    // resolve a rotation:
+    static int rotator = 0;
+    if (_r0 != std::string::npos && _r1 != std::string::npos)
+    {
+        util::replaceInPlace(
+            request.url,
+            request.url.substr(_r0, _r1 - _r0 + 1),
+            request.url.substr(_r0 + 1 + (rotator++ % (_r1 - _r0 - 1)), 1));
+    }
+
+    return request;
+}
 
-        for(auto& header : _context.headers)
+auto URI::readResponse(Result<HTTPClient::Response> r, const std::string& url, const Content* cached, const IOOptions& io) const -> Result<URIResponse>
+{
+    if (r.failed())
+    {
+        // if the server is unreachable, stale content beats no content
+        if (cached && !cached->mustRevalidate && r.error().type == Failure::ServiceUnavailable)
         {
-            request.headers.push_back({ header.first, header.second });
+            Result<URIResponse> result(*cached);
+            result->fromCache = true;
+            return result;
         }
 
-        // resolve a rotation:
-        static int rotator = 0;
-        if (_r0 != std::string::npos && _r1 != std::string::npos)
+        // if the error is unrecoverable, deadpool it.
+        if (io.services().deadpool && r.error().type == Failure::ResourceUnavailable)
         {
-            util::replaceInPlace(
-                request.url,
-                request.url.substr(_r0, _r1 - _r0 + 1),
-                request.url.substr(_r0 + 1 + (rotator++ % (_r1 - _r0 - 1)), 1));
+            io.services().deadpool->put(full(), r.error());
         }
 
-        // make the actual request:
-        auto r = http_get(request, io);
+        return r.error();
+    }
 
-        if (r.failed())
-        {
-            // if the error is unrecoverable, deadpool it.
-            if (io.services().deadpool && r.error().type == Failure::ResourceUnavailable)
-            {
-                io.services().deadpool->put(full(), r.error());
-            }
+    Content content;
+    bool notModified = r.value().status == 304;
 
-            return r.error();
+    if (notModified)
+    {
+        if (!cached)
+        {
+            return Failure(Failure::GeneralError, "Unexpected 304 Not Modified for " + full());
         }
 
+        // same content; keep its validators and lifetime unless the server updated them
+        content = *cached;
+        auto now = std::chrono::system_clock::now();
+        if (content.expires.time_since_epoch().count() != 0)
+            content.expires = now + (content.expires - content.timestamp);
+        content.timestamp = now;
+    }
+    else
+    {
         std::string contentType = findHeader(r.value().headers, "Content-Type");
 
         if (contentType.empty())
@@ -712,25 +1077,77 @@ auto URI::read(const IOOptions& io) const -> Result<URIResponse>
 
         if (contentType.empty())
         {
-            auto p = request.url.find_first_of('?');
-            auto url_path = p != std::string::npos ? request.url.substr(0, p) : request.url;
+            auto p = url.find_first_of('?');
+            auto url_path = p != std::string::npos ? url.substr(0, p) : url;
             contentType = inferContentTypeFromFileExtension(url_path);
         }
 
         content.type = std::move(contentType);
         content.data = std::move(r.value().data);
+        content.timestamp = std::chrono::system_clock::now();
     }
-    else
+
+    bool store = readCachingHeaders(r.value().headers, content);
+
+    if (store && io.services().contentCache)
     {
-        return Failure(Failure::ResourceUnavailable, full());
+        io.services().contentCache->put(full(), Result<Content>(content));
     }
 
-    if (io.services().contentCache)
+    URIResponse response(std::move(content));
+    response.fromCache = notModified;
+    return response;
+}
+
+auto URI::readAsync(const IOOptions& io) const -> jobs::future<Result<URIResponse>>
+{
+    auto client = io.services().httpClient;
+
+    // Without the shared client there is nothing to wait on but a blocking read.
+    if (!client || !isRemote())
     {
-        io.services().contentCache->put(full(), Result<Content>(content));
+        auto read = [uri = *this, io](Cancelable& c)
+            {
+                return uri.read(IOOptions(io, c));
+            };
+
+        return jobs::dispatch(read, jobs::context{ "read uri", io.services().ioPool() });
     }
 
-    return URIResponse(content);
+    std::optional<Content> stale;
+    if (auto result = fetchCached(io, stale))
+    {
+        jobs::future<Result<URIResponse>> future;
+        future.resolve(std::move(*result));
+        return future;
+    }
+
+    // No thread waits for the transfer; the client resolves the request's future
+    // and only then does a pool thread turn the response into content. An identical
+    // request already in flight (from read() or another readAsync) is shared by the client.
+    auto request = remoteRequest(stale.has_value() ? &stale.value() : nullptr);
+
+    auto process = [uri = *this, io, url = request.url, stale = std::move(stale)](const Result<HTTPResponse>& r, Cancelable& c)
+        {
+            IOOptions options(io, c);
+            auto cached = stale.has_value() ? &stale.value() : nullptr;
+
+            // the server is busy or unreachable; retry the way read() would, on this thread
+            bool retry =
+                (r.failed() && r.error().type == Failure::ServiceUnavailable) ||
+                (r.ok() && r.value().status == 429); // TOO MANY REQUESTS (rate limiting)
+
+            if (retry && options.maxNetworkAttempts > 1 && !options.canceled())
+                return uri.fetchRemote(cached, options);
+
+            if (r.failed())
+                return uri.readResponse(r.error(), url, cached, options);
+
+            auto response = r.value();
+            return uri.readResponse(http_status(std::move(response), url), url, cached, options);
+        };
+
+    return client->get(request).then(process, jobs::context{ "read uri", io.services().ioPool() });
 }
 
 bool
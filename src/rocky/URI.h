@@ -7,29 +7,15 @@
 
 #include <rocky/Common.h>
 #include <rocky/IOTypes.h>
+#include <rocky/HTTPClient.h>
 
+#include <chrono>
+#include <optional>
 #include <string>
 #include <vector>
 
 namespace ROCKY_NAMESPACE
 {
-    struct URIResponse
-    {
-        Content content;
-        std::int64_t lastModifiedTime = 0;
-        Duration duration;
-        bool fromCache = false;
-        std::string jsonMetadata;
-
-        URIResponse(const Content& in_content) :
-            content(in_content) {
-        }
-
-        URIResponse(Content&& in_content) :
-            content(std::move(in_content)) {
-        }
-    };
-
     /**
      * Represents the location of a resource, providing the raw (original, possibly
      * relative) and absolute forms.
@@ -123,9 +109,17 @@ namespace ROCKY_NAMESPACE
         /** Whether the object of the URI is cacheable. */
         bool isRemote() const;
 
-        //! Reads the URI into a data buffer
+        //! Reads the URI into a data buffer. Blocks the calling thread (usually
+        //! an I/O pool thread) until the transfer finishes or is canceled, even
+        //! when the request goes through the shared HTTPClient.
         Result<URIResponse> read(const IOOptions& io) const;
 
+        //! Reads the URI into a data buffer asynchronously. A remote URI with the shared
+        //! HTTPClient available goes straight to the client, and no thread waits for the
+        //! transfer; otherwise this runs the blocking read() on an I/O job pool thread
+        //! (see Services::ioPool). Abandoning the returned future cancels the read.
+        jobs::future<Result<URIResponse>> readAsync(const IOOptions& io) const;
+
     public:
 
         bool operator < (const URI& rhs) const { 
@@ -158,6 +152,28 @@ namespace ROCKY_NAMESPACE
 
         void set(std::string_view location, const URI::Context& context);
         void findRotation();
+        Result<URIResponse> fetch(const IOOptions& io) const;
+        Result<URIResponse> fetchRemote(const Content* cached, const IOOptions& io) const;
+
+        //! The answer from the content cache or dead pool, if they have one. Otherwise
+        //! returns nothing, and sets stale to any expired content worth revalidating.
+        std::optional<Result<URIResponse>> fetchCached(const IOOptions& io, std::optional<Content>& stale) const;
+
+        //! The HTTP request for this URI, resolving any rotation; asks the server to send
+        //! the content only if it changed since it was cached.
+        HTTPClient::Request remoteRequest(const Content* cached) const;
+
+        //! Turns the result of an HTTP request for this URI into content. A 304 (Not
+        //! Modified) refreshes the cached content, and whatever the server allows is cached.
+        Result<URIResponse> readResponse(Result<HTTPClient::Response> r, const std::string& url, const Content* cached, const IOOptions& io) const;
+
+        //! Parses an HTTP date, e.g. "Sun, 06 Nov 1994 08:49:37 GMT"
+        static std::optional<std::chrono::system_clock::time_point> parseHTTPDate(const std::string& value);
+
+        //! Reads the HTTP caching headers of a response into the content, whose timestamp
+        //! is the time of the response. Freshness the headers don't mention is left as is.
+        //! Returns false if the server does not allow the content to be cached at all.
+        static bool readCachingHeaders(const Headers& headers, Content& content);
     };
 
     /**
@@ -1155,6 +1155,8 @@ MapManipulator::apply(vsg::FrameEvent& frame)
 
     bool camera_changed = updateCamera();
 
+    requestPrefetch(frame.time);
+
     _previousTime = frame.time;
 
     // if anything caused the camera's matrix to change, dirty the instance to
@@ -1169,6 +1171,77 @@ MapManipulator::apply(vsg::FrameEvent& frame)
     }
 }
 
+void
+MapManipulator::requestPrefetch(const vsg::time_point& now)
+{
+    auto mapNode = getMapNode();
+    if (!mapNode || !mapNode->terrainNode)
+        return;
+
+    // nothing to do unless the terrain prefetches; forget the motion so that
+    // turning it on later does not see a jump
+    if (!mapNode->terrainNode->prefetch.value())
+    {
+        _motion.valid = false;
+        return;
+    }
+
+    // track the (smoothed) velocity of the focal point and the zoom:
+    double dt = to_seconds(now - _previousTime);
+    if (_motion.valid && dt > 0.0 && dt < 1.0)
+    {
+        const double smoothing = 0.5;
+        auto velocity = (_state.center - _motion.center) / dt;
+        auto distanceRate = (_state.distance - _motion.distance) / dt;
+        _motion.velocity = _motion.velocity * smoothing + velocity * (1.0 - smoothing);
+        _motion.distanceRate = _motion.distanceRate * smoothing + distanceRate * (1.0 - smoothing);
+    }
+    else
+    {
+        _motion.velocity.set(0.0, 0.0, 0.0);
+        _motion.distanceRate = 0.0;
+    }
+    _motion.center = _state.center;
+    _motion.distance = _state.distance;
+    _motion.valid = true;
+
+    float viewportHeight = 1080.0f;
+    vsg::ref_ptr<vsg::Camera> camera = _camera_weakptr;
+    if (camera && camera->getViewport().height > 0.0f)
+        viewportHeight = camera->getViewport().height;
+
+    std::vector<TerrainPrefetchHint> hints;
+
+    // the destination of a viewpoint transition:
+    if (isSettingViewpoint() && !isTethering())
+    {
+        auto& vp = _state.setVP1.value();
+        hints.emplace_back(TerrainPrefetchHint{ vp.position(), vp.range->as(Units::METERS), viewportHeight });
+    }
+
+    // where the camera will be shortly if it keeps moving the way it is.
+    // A focal point that moves less than 1% of the view distance per second is "still".
+    double speed = vsg::length(_motion.velocity);
+    bool moving =
+        speed > 0.01 * _state.distance ||
+        std::abs(_motion.distanceRate) > 0.01 * _state.distance;
+
+    if (moving && settings.prefetchLookahead > 0.0)
+    {
+        for (double t : { 0.5 * settings.prefetchLookahead, settings.prefetchLookahead })
+        {
+            auto center = _state.center + _motion.velocity * t;
+            auto distance = clamp(_state.distance + _motion.distanceRate * t, settings.minDistance, settings.maxDistance);
+            hints.emplace_back(TerrainPrefetchHint{ GeoPoint(mapNode->srs(), center.x, center.y, center.z), distance, viewportHeight });
+        }
+    }
+
+    if (!hints.empty())
+    {
+        mapNode->terrainNode->requestPrefetch(hints);
+    }
+}
+
 bool
 MapManipulator::updateCamera()
 {
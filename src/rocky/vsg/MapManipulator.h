@@ -295,6 +295,11 @@ namespace ROCKY_NAMESPACE
             //! Maximum duration time when autoVPDuration = true (seconds)
             double maxVPDuration = 8.0;
 
+            //! How far ahead to predict camera motion when asking the terrain to
+            //! prefetch data (seconds). Zero disables motion-based prefetching; the
+            //! destination of a setViewpoint transition is always prefetched.
+            double prefetchLookahead = 0.5;
+
             //! Whtehr to zoom towards the mouse cursor when zooming
             bool zoomToMouse = true;
 
@@ -547,6 +552,20 @@ namespace ROCKY_NAMESPACE
         // rendering required b/c something changed.
         bool _dirty;
 
+        // camera motion tracking for terrain prefetch
+        struct Motion
+        {
+            bool valid = false;
+            vsg::dvec3 center;
+            double distance = 0.0;
+            vsg::dvec3 velocity;       // focal point, world units per second
+            double distanceRate = 0.0; // camera distance, meters per second
+        };
+        Motion _motion;
+
+        //! Estimates where the camera is heading and tells the terrain to prefetch there.
+        void requestPrefetch(const vsg::time_point&);
+
         bool withinRenderArea(const vsg::PointerEvent& pointerEvent) const;
 
         vsg::dvec2 ndc(const vsg::PointerEvent&) const;
@@ -257,7 +257,7 @@ PagedNode::startLoading() const
     ROCKY_SOFT_ASSERT_AND_RETURN(pager, void());
 
     jobs::context jc;
-    jc.name = key.str();
+    jc.name = "load node";
     jc.pool = jobs::get_pool(pager->poolName, 4);
     jc.priority = [&]() { return priority; };
 
@@ -5,6 +5,8 @@
  */
 #include "VSGContext.h"
 #include "VSGUtils.h"
+#include <rocky/DiskContentCache.h>
+#include <rocky/HTTPClient.h>
 #include <rocky/Image.h>
 #include <rocky/URI.h>
 #include <filesystem>
@@ -185,12 +187,15 @@ namespace
     }    
     
     /**
-    * An update operation that maintains a priroity queue for update tasks.
-    * This sits in the VSG viewer's update operations queue indefinitely
-    * and runs once per frame. It chooses the highest priority task in its
-    * queue and runs it. It will run one task per frame so that we do not
-    * risk frame drops. It will automatically discard any tasks that have
-    * been abandoned (no Future exists).
+    * Update operation that holds a queue of prioritized tasks
+    * and runs once per frame. It runs tasks in priority order until it
+    * exhausts its time budget for the frame (but always runs at least one)
+    * so that we do not risk frame drops. It will automatically discard any
+    * tasks that have been abandoned (no Future exists).
+    *
+    * Tasks live in a heap keyed on a cached priority. New tasks go in with a
+    * fresh priority; the whole queue re-evaluates its priorities (and
+    * re-heapifies) at most once per refresh interval.
     */
     struct PriorityUpdateQueue : public vsg::Inherit<vsg::Operation, PriorityUpdateQueue>
     {
@@ -199,51 +204,95 @@ namespace
         struct Task {
             vsg::ref_ptr<vsg::Operation> function;
             std::function<float()> get_priority;
+            float priority = FLT_MAX;
+
+            inline void refresh() {
+                priority = get_priority ? get_priority() : FLT_MAX;
+            }
+            inline bool canceled() const {
+                auto po = dynamic_cast<Cancelable*>(function.get());
+                return po != nullptr && po->canceled();
+            }
         };
+
+        // max-heap on the cached priority
+        static bool lower_priority(const Task& lhs, const Task& rhs) {
+            return lhs.priority < rhs.priority;
+        }
+
         std::vector<Task> _queue;
+        std::chrono::steady_clock::time_point _lastRefresh;
+        VSGContextImpl* _context = nullptr;
+        std::chrono::microseconds _budget = std::chrono::microseconds(4000);
+        std::chrono::milliseconds _refreshInterval = std::chrono::milliseconds(100);
+        VSGContextImpl::UpdateQueueStats _stats;
+
+        PriorityUpdateQueue(VSGContextImpl* context) : _context(context) { }
+
+        void push(Task&& task)
+        {
+            task.refresh();
+            std::scoped_lock lock(_mutex);
+            _queue.emplace_back(std::move(task));
+            std::push_heap(_queue.begin(), _queue.end(), lower_priority);
+        }
 
-        // runs one task per frame.
+        // runs tasks in priority order until the frame budget is spent.
         void run() override
         {
-            if (!_queue.empty())
+            auto t0 = std::chrono::steady_clock::now();
+            unsigned ran = 0, discarded = 0;
+
+            std::unique_lock lock(_mutex);
+
+            if (!_queue.empty() && t0 - _lastRefresh >= _refreshInterval)
             {
-                Task task;
-                {
-                    std::scoped_lock lock(_mutex);
-
-                    // sort from low to high priority
-                    std::sort(_queue.begin(), _queue.end(),
-                        [](const Task& lhs, const Task& rhs)
-                        {
-                            if (lhs.get_priority == nullptr)
-                                return false;
-                            else if (rhs.get_priority == nullptr)
-                                return true;
-                            else
-                                return lhs.get_priority() < rhs.get_priority();
-                        }
-                    );
-
-                    while (!_queue.empty())
-                    {
-                        // pop the highest priority off the back.
-                        task = _queue.back();
-                        _queue.pop_back();
-
-                        // check for cancelation - if the task is already canceled, 
-                        // discard it and fetch the next one.
-                        auto po = dynamic_cast<Cancelable*>(task.function.get());
-                        if (po == nullptr || !po->canceled())
-                            break;
-                        else
-                            task = { };
-                    }
-                }
+                // drop canceled tasks and re-evaluate everyone else's priority:
+                auto end = std::remove_if(_queue.begin(), _queue.end(), [](const Task& task) { return task.canceled(); });
+                discarded += (unsigned)(_queue.end() - end);
+                _queue.erase(end, _queue.end());
 
-                if (task.function)
+                for (auto& task : _queue)
+                    task.refresh();
+
+                std::make_heap(_queue.begin(), _queue.end(), lower_priority);
+                _lastRefresh = t0;
+            }
+
+            auto now = t0;
+            while (!_queue.empty() && (ran == 0 || now - t0 < _budget))
+            {
+                // pop the highest priority task off the heap.
+                std::pop_heap(_queue.begin(), _queue.end(), lower_priority);
+                Task task = std::move(_queue.back());
+                _queue.pop_back();
+
+                // check for cancelation - if the task is already canceled,
+                // discard it and fetch the next one.
+                if (task.canceled())
                 {
-                    task.function->run();
+                    ++discarded;
+                    continue;
                 }
+
+                // run it without the lock so other threads can keep queuing.
+                lock.unlock();
+                task.function->run();
+                ++ran;
+                now = std::chrono::steady_clock::now();
+                lock.lock();
+            }
+
+            _stats.queued = _queue.size();
+            _stats.ran = ran;
+            _stats.discarded = discarded;
+            _stats.budget = _budget;
+            _stats.used = std::chrono::duration_cast<std::chrono::microseconds>(now - t0);
+
+            // more to do next frame?
+            if (!_queue.empty() && _context)
+            {
+                _context->requestFrame();
             }
         }
     };
@@ -290,7 +339,7 @@ VSGContextImpl::ctor(int& argc, char** argv)
 
     shaderCompileSettings = vsg::ShaderCompileSettings::create();
 
-    _priorityUpdateQueue = PriorityUpdateQueue::create();
+    _priorityUpdateQueue = PriorityUpdateQueue::create(this);
 
     // initialize the deferred deletion collection.
     // a large number of frames ensures objects will be safely destroyed and
@@ -477,14 +526,36 @@ VSGContextImpl::ctor(int& argc, char** argv)
             return Failure(Failure::ServiceUnavailable, "No image reader for \"" + contentType + "\"");
         };
 
-    // caches URI request results
-    io.services().contentCache = std::make_shared<ContentCache>(256);
+    // caches URI request results, on disk if there's a cache folder so they
+    // survive a restart
+    auto cachePath = util::getEnvVar("ROCKY_CACHE_PATH");
+    if (!cachePath.empty())
+    {
+        DiskContentCache::Settings cacheSettings;
+        cacheSettings.path = cachePath;
+
+        auto maxSize = util::getEnvVar("ROCKY_CACHE_MAX_SIZE_MB");
+        if (!maxSize.empty())
+            cacheSettings.maxBytes = std::strtoull(maxSize.c_str(), nullptr, 10) * 1024ull * 1024ull;
+
+        auto r = DiskContentCache::create(cacheSettings);
+        if (r.ok())
+            io.services().contentCache = r.value();
+        else
+            Log()->warn("Disk cache unavailable: " + r.error().string());
+    }
+
+    if (!io.services().contentCache)
+        io.services().contentCache = std::make_shared<MemoryContentCache>(64 * 1024 * 1024);
 
     // weak cache of resident image (and elevation) rasters
     io.services().residentImageCache = std::make_shared<util::ResidentCache<std::string, Image, GeoExtent>>();
 
     // remembers failed URI requests so we don't repeat them
     io.services().deadpool = std::make_shared<DealpoolService>(4096);
+
+    // runs all HTTP requests over pooled connections (null without curl or httplib)
+    io.services().httpClient = HTTPClient::create();
 }
 
 vsg::ref_ptr<vsg::Device>
@@ -517,19 +588,56 @@ VSGContextImpl::onNextUpdate(vsg::ref_ptr<vsg::Operation> function, std::functio
     auto pq = dynamic_cast<PriorityUpdateQueue*>(_priorityUpdateQueue.get());
     if (pq)
     {
-        std::scoped_lock lock(pq->_mutex);
-
-        if (pq->referenceCount() == 1)
         {
-            viewer->updateOperations->add(_priorityUpdateQueue, vsg::UpdateOperations::ALL_FRAMES);
+            std::scoped_lock lock(pq->_mutex);
+
+            if (pq->referenceCount() == 1)
+            {
+                viewer->updateOperations->add(_priorityUpdateQueue, vsg::UpdateOperations::ALL_FRAMES);
+            }
         }
 
-        pq->_queue.push_back({ function, get_priority });
+        pq->push({ function, get_priority });
 
         requestFrame();
     }
 }
 
+void
+VSGContextImpl::setUpdateBudget(std::chrono::microseconds value)
+{
+    auto pq = dynamic_cast<PriorityUpdateQueue*>(_priorityUpdateQueue.get());
+    if (pq)
+    {
+        std::scoped_lock lock(pq->_mutex);
+        pq->_budget = std::max(value, std::chrono::microseconds(0));
+    }
+}
+
+std::chrono::microseconds
+VSGContextImpl::updateBudget() const
+{
+    auto pq = dynamic_cast<PriorityUpdateQueue*>(_priorityUpdateQueue.get());
+    if (pq)
+    {
+        std::scoped_lock lock(pq->_mutex);
+        return pq->_budget;
+    }
+    return {};
+}
+
+VSGContextImpl::UpdateQueueStats
+VSGContextImpl::updateQueueStats() const
+{
+    auto pq = dynamic_cast<PriorityUpdateQueue*>(_priorityUpdateQueue.get());
+    if (pq)
+    {
+        std::scoped_lock lock(pq->_mutex);
+        return pq->_stats;
+    }
+    return {};
+}
+
 void
 VSGContextImpl::onNextUpdate(std::function<void()> function)
 {
@@ -546,6 +654,10 @@ VSGContextImpl::compile(vsg::ref_ptr<vsg::Object> compilable)
     ROCKY_SOFT_ASSERT(viewer.valid(), "Developer: failure to set VSGContext->viewer");
     ROCKY_SOFT_ASSERT_AND_RETURN(compilable.valid(), void());
 
+    // a viewer without a window (e.g., a headless simulation) has no device to compile for
+    if (!viewer->compileManager)
+        return;
+
     // note: this can block (with a fence) until a compile traversal is available.
     // Be sure to group as many compiles together as possible for maximum performance.
     auto cr = viewer->compileManager->compile(compilable);
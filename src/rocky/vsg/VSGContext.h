@@ -90,6 +90,22 @@ namespace ROCKY_NAMESPACE
         //! or compiling vulkan objects
         void onNextUpdate(std::function<void()> function);
 
+        //! Time the update pass may spend each frame running prioritized
+        //! operations (see onNextUpdate). At least one runs per frame regardless.
+        void setUpdateBudget(std::chrono::microseconds value);
+        std::chrono::microseconds updateBudget() const;
+
+        //! Statistics from the most recent run of the prioritized update queue
+        struct UpdateQueueStats
+        {
+            std::size_t queued = 0;        // operations still waiting
+            unsigned ran = 0;              // operations run
+            unsigned discarded = 0;        // abandoned operations thrown out
+            std::chrono::microseconds used = {};   // time spent running operations
+            std::chrono::microseconds budget = {}; // time allowed
+        };
+        UpdateQueueStats updateQueueStats() const;
+
         //! Compiles the Vulkan primitives for an object. This is a thread-safe
         //! operation. Each call to compile() might block the viewer to access
         //! a compile manager, so it is always a good idea to batch together as
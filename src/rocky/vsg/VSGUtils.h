@@ -8,6 +8,7 @@
 #include <rocky/vsg/Common.h>
 #include <rocky/Threading.h>
 #include <rocky/Image.h>
+#include <rocky/CompressedImage.h>
 #include <rocky/Math.h>
 #include <rocky/Result.h>
 #include <rocky/weejobs.h>
@@ -235,6 +236,37 @@ namespace ROCKY_NAMESPACE
             return data;
         }
 
+        //! Wraps a block-compressed image, including its mip levels, in a VSG Data object.
+        //! Data is shared, so the source must outlive the upload.
+        inline vsg::ref_ptr<vsg::Data> wrapCompressedImageInVSG(std::shared_ptr<CompressedImage> image)
+        {
+            if (!image || image->data.empty())
+                return {};
+
+            vsg::Data::Properties props;
+            props.origin = vsg::TOP_LEFT;
+            props.blockWidth = 4;
+            props.blockHeight = 4;
+            props.maxNumMipmaps = (std::uint8_t)image->mipLevels;
+            props.allocatorType = vsg::ALLOCATOR_TYPE_NO_DELETE;
+
+            // dimensions are in blocks
+            unsigned width = image->width / 4, height = image->height / 4;
+
+            if (image->format == CompressedImage::BC1)
+            {
+                props.format = image->srgb ? VK_FORMAT_BC1_RGBA_SRGB_BLOCK : VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+                auto data = reinterpret_cast<vsg::block64*>(image->data.data());
+                return vsg::block64Array2D::create(width, height, data, props);
+            }
+            else
+            {
+                props.format = image->srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+                auto data = reinterpret_cast<vsg::block128*>(image->data.data());
+                return vsg::block128Array2D::create(width, height, data, props);
+            }
+        }
+
         //! Returns a vsg::Data structure containing the data in an image, taking
         //! ownership of the data and reseting the image.
         template<typename T>
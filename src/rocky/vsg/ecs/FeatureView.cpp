@@ -141,10 +141,10 @@ namespace
                 // tessellate:
                 auto tessellated = tessellate_linestring(part.points, feature.srs, feature.interpolation, max_span);
 
-                // clamp:
+                // clamp; a finely tessellated line has enough points to split up:
                 if (clamper)
                 {
-                    clamper.clampRange(tessellated.begin(), tessellated.end());
+                    clamper.clampRangeParallel(tessellated.begin(), tessellated.end());
                 }
 
                 // transform:
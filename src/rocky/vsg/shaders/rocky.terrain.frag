@@ -4,6 +4,7 @@
 
 #pragma import_defines(ROCKY_LIGHTING)
 #pragma import_defines(ROCKY_HAS_VK_BARYCENTRIC_EXTENSION)
+#pragma import_defines(ROCKY_TEXTURE_ARRAYS)
 
 layout(push_constant) uniform PushConstants {
     mat4 projection;
@@ -27,8 +28,47 @@ layout(set = 0, binding = 9) uniform TerrainData
     bool wireOverlay;
 } settings;
 
+#if defined(ROCKY_TEXTURE_ARRAYS)
+
+// see rocky::TerrainTextureArray
+#define TEXTURE_ARRAY_PAGES 8
+layout(set = 0, binding = 11) uniform sampler2DArray color_tex[TEXTURE_ARRAY_PAGES];
+
+// page and layer of the color texture
+layout(location = 4) flat in ivec2 color_slot;
+
+// sample the color array. Pages are indexed with constants so we
+// don't depend on the dynamic indexing feature. Implicit derivatives are
+// undefined in the (non-uniform) switch, so take them up front.
+vec4 terrain_sample_color(in vec2 uv)
+{
+    vec3 uvw = vec3(uv, float(color_slot.y));
+    vec2 ddx = dFdx(uv);
+    vec2 ddy = dFdy(uv);
+    switch(color_slot.x)
+    {
+    case 1: return textureGrad(color_tex[1], uvw, ddx, ddy);
+    case 2: return textureGrad(color_tex[2], uvw, ddx, ddy);
+    case 3: return textureGrad(color_tex[3], uvw, ddx, ddy);
+    case 4: return textureGrad(color_tex[4], uvw, ddx, ddy);
+    case 5: return textureGrad(color_tex[5], uvw, ddx, ddy);
+    case 6: return textureGrad(color_tex[6], uvw, ddx, ddy);
+    case 7: return textureGrad(color_tex[7], uvw, ddx, ddy);
+    default: return textureGrad(color_tex[0], uvw, ddx, ddy);
+    }
+}
+
+#else
+
 layout(set = 0, binding = 11) uniform sampler2D color_tex;
 
+vec4 terrain_sample_color(in vec2 uv)
+{
+    return texture(color_tex, uv);
+}
+
+#endif
+
 #if defined(ROCKY_LIGHTING)
 #include "rocky.lighting.frag.glsl"
 #endif
@@ -47,7 +87,7 @@ vec3 get_normal()
 
 void main()
 {
-    vec4 texel = texture(color_tex, varyings.uv);
+    vec4 texel = terrain_sample_color(varyings.uv);
     out_color = mix(varyings.color, clamp(texel, 0, 1), texel.a);
 
     if (gl_FrontFacing == false)
@@ -1,6 +1,26 @@
 #version 450
 #pragma import_defines(ROCKY_LIGHTING)
 #pragma import_defines(ROCKY_ATMOSPHERE)
+#pragma import_defines(ROCKY_TEXTURE_ARRAYS)
+#pragma import_defines(ROCKY_COMPACT_TERRAIN)
+
+#if defined(ROCKY_TEXTURE_ARRAYS)
+
+// see rocky::TerrainTextureArray
+#define TEXTURE_ARRAY_PAGES 8
+layout(set = 0, binding = 10) uniform sampler2DArray elevation_tex[TEXTURE_ARRAY_PAGES];
+
+layout(push_constant) uniform PushConstants
+{
+    mat4 projection;
+    mat4 modelview;
+    // see rocky::TerrainTileDescriptors::PushConstants
+    vec4 elevation_scale_bias;
+    vec4 color_scale_bias;
+    ivec4 slots;
+} pc;
+
+#else
 
 layout(set = 0, binding = 10) uniform sampler2D elevation_tex;
 
@@ -16,12 +36,24 @@ layout(set = 0, binding = 13) uniform TileData
     mat4 elevation_matrix;
     mat4 color_matrix;
     mat4 model_matrix;
+    vec4 elevation_range; // x = offset, y = scale
 } tile;
 
+#endif
+
 // input vertex attributes
+#if defined(ROCKY_COMPACT_TERRAIN)
+// 16-bit normalized; see rocky::GeometryPool
+layout(location = 0) in vec3 in_vertex_unit; // relative to the geometry's bounding box
+layout(location = 1) in vec3 in_normal_snorm;
+layout(location = 2) in vec3 in_uvw_unorm;
+layout(location = 3) in vec3 in_vertex_scale; // per instance
+layout(location = 4) in vec3 in_vertex_bias; // per instance
+#else
 layout(location = 0) in vec3 in_vertex;
 layout(location = 1) in vec3 in_normal;
 layout(location = 2) in vec3 in_uvw;
+#endif
 
 // inter-stage interface block
 struct RockyVaryings {
@@ -34,6 +66,11 @@ struct RockyVaryings {
 // output varyings
 layout(location = 0) out RockyVaryings varyings;
 
+#if defined(ROCKY_TEXTURE_ARRAYS)
+// page and layer of the color texture
+layout(location = 4) flat out ivec2 color_slot;
+#endif
+
 #if defined(ROCKY_ATMOSPHERE)
 #include "rocky.atmo.ground.vert.glsl"
 #endif
@@ -43,6 +80,44 @@ out gl_PerVertex {
     vec4 gl_Position;
 };
 
+#if defined(ROCKY_TEXTURE_ARRAYS)
+
+// sample the elevation array. Pages are indexed with constants so we
+// don't depend on the dynamic indexing feature.
+float terrain_sample_elevation(in vec2 uv)
+{
+    vec3 uvw = vec3(uv, float(pc.slots.y));
+    switch(pc.slots.x)
+    {
+    case 1: return texture(elevation_tex[1], uvw).r;
+    case 2: return texture(elevation_tex[2], uvw).r;
+    case 3: return texture(elevation_tex[3], uvw).r;
+    case 4: return texture(elevation_tex[4], uvw).r;
+    case 5: return texture(elevation_tex[5], uvw).r;
+    case 6: return texture(elevation_tex[6], uvw).r;
+    case 7: return texture(elevation_tex[7], uvw).r;
+    default: return texture(elevation_tex[0], uvw).r;
+    }
+}
+
+// sample the elevation data at a UV tile coordinate
+float terrain_get_elevation(in vec2 uv)
+{
+    float size = float(textureSize(elevation_tex[0], 0).x);
+    vec2 coeff = vec2((size - 1.0) / size, 0.5 / size);
+
+    // Texel-level scale and bias allow us to sample the elevation texture
+    // on texel center instead of edge.
+    vec2 elevc = uv
+        * coeff.x * pc.elevation_scale_bias.x // scale
+        + coeff.x * pc.elevation_scale_bias.yz // bias
+        + coeff.y;
+
+    return terrain_sample_elevation(elevc);
+}
+
+#else
+
 // sample the elevation data at a UV tile coordinate
 float terrain_get_elevation(in vec2 uv)
 {
@@ -56,11 +131,20 @@ float terrain_get_elevation(in vec2 uv)
         + coeff.x * tile.elevation_matrix[3].st // bias
         + coeff.y;
 
-    return texture(elevation_tex, elevc).r;
+    // 16-bit elevation is normalized to the tile's height range
+    return tile.elevation_range.x + texture(elevation_tex, elevc).r * tile.elevation_range.y;
 }
 
+#endif
+
 void main()
 {
+#if defined(ROCKY_COMPACT_TERRAIN)
+    vec3 in_vertex = in_vertex_unit * in_vertex_scale + in_vertex_bias;
+    vec3 in_normal = normalize(in_normal_snorm);
+    vec3 in_uvw = vec3(in_uvw_unorm.st, in_uvw_unorm.z * 65535.0);
+#endif
+
     float elevation = terrain_get_elevation(in_uvw.st);
     vec3 position = in_vertex + in_normal*elevation;
     vec4 position_view = pc.modelview * vec4(position, 1.0);
@@ -73,7 +157,12 @@ void main()
     varyings.up_view = normal_matrix * in_normal;
     
     varyings.color = vec4(0.5); // placeholder
+#if defined(ROCKY_TEXTURE_ARRAYS)
+    varyings.uv = in_uvw.st * pc.color_scale_bias.xy + pc.color_scale_bias.zw;
+    color_slot = pc.slots.zw;
+#else
     varyings.uv = (tile.color_matrix * vec4(in_uvw.st, 0, 1)).st;
+#endif
     varyings.vertex_view = position_view.xyz / position_view.w;
     
     gl_Position = pc.projection * position_view;
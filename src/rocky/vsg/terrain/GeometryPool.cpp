@@ -235,6 +235,60 @@ namespace
         }
     };
 
+    // Quantizes the vertex attributes for the GPU to 16 bits per component.
+    // Positions are normalized to their bounding box, whose size and origin
+    // follow as per-instance attributes so the shader can restore them.
+    vsg::DataList quantize(const vsg::vec3Array& verts, const vsg::vec3Array& normals, const vsg::vec3Array& uvs)
+    {
+        vsg::vec3 lo = verts.at(0), hi = verts.at(0);
+        for (auto& v : verts)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                lo[c] = std::min(lo[c], v[c]);
+                hi[c] = std::max(hi[c], v[c]);
+            }
+        }
+
+        vsg::vec3 size = hi - lo;
+        for (int c = 0; c < 3; ++c)
+            if (size[c] <= 0.0f)
+                size[c] = 1.0f;
+
+        auto unorm16 = [](float v) { return (std::uint16_t)std::lround(std::clamp(v, 0.0f, 1.0f) * 65535.0f); };
+        auto snorm16 = [](float v) { return (std::int16_t)std::lround(std::clamp(v, -1.0f, 1.0f) * 32767.0f); };
+
+        auto q_verts = vsg::usvec4Array::create(verts.size());
+        auto q_normals = vsg::svec4Array::create(normals.size());
+        auto q_uvs = vsg::usvec4Array::create(uvs.size());
+
+        for (std::size_t i = 0; i < verts.size(); ++i)
+        {
+            auto& v = verts.at(i);
+            auto& n = normals.at(i);
+            auto& uv = uvs.at(i);
+
+            q_verts->set(i, vsg::usvec4(
+                unorm16((v.x - lo.x) / size.x),
+                unorm16((v.y - lo.y) / size.y),
+                unorm16((v.z - lo.z) / size.z),
+                0));
+
+            q_normals->set(i, vsg::svec4(snorm16(n.x), snorm16(n.y), snorm16(n.z), 0));
+
+            // the marker bits go through unchanged, so the shader sees them divided by 65535
+            q_uvs->set(i, vsg::usvec4(unorm16(uv.x), unorm16(uv.y), (std::uint16_t)uv.z, 0));
+        }
+
+        auto scale = vsg::vec3Array::create(1);
+        scale->set(0, size);
+
+        auto bias = vsg::vec3Array::create(1);
+        bias->set(0, lo);
+
+        return { q_verts, q_normals, q_uvs, scale, bias };
+    }
+
     inline void expandSphereToInclude(vsg::dsphere& sphere, const vsg::dvec3& p)
     {
         auto dv = p - sphere.center;
@@ -360,13 +414,24 @@ GeometryPool::createGeometry(const TileKey& tileKey, const Settings& settings, C
         // the geometry:
         auto geom = SharedGeometry::create();
 
-        vsg::DataList arrays = { verts, normals, uvs };
-        
-        if (neighbors)
-            arrays.emplace_back(neighbors);
+        // The GPU gets its own copy of the compact attributes; the
+        // float originals stay around for the proxy geometry.
+        vsg::DataList arrays;
 
-        if (neighborNormals)
-            arrays.emplace_back(neighborNormals);
+        if (settings.compact)
+        {
+            arrays = quantize(*verts, *normals, *uvs);
+        }
+        else
+        {
+            arrays = { verts, normals, uvs };
+
+            if (neighbors)
+                arrays.emplace_back(neighbors);
+
+            if (neighborNormals)
+                arrays.emplace_back(neighborNormals);
+        }
 
         geom->assignArrays(arrays);
 
@@ -125,6 +125,7 @@ namespace ROCKY_NAMESPACE
             uint32_t tileSize = 17u;
             float skirtRatio = 0.0f;
             bool morphing = false;
+            bool compact = false; // 16-bit vertex attributes (see TerrainSettings::compactTerrain)
         };
 
         //! Gets the Geometry associated with a tile key, creating a new one if
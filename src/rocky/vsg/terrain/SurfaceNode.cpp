@@ -6,7 +6,6 @@
 #include "SurfaceNode.h"
 #include "GeometryPool.h"
 #include <rocky/vsg/VSGUtils.h>
-#include <rocky/Heightfield.h>
 
 using namespace ROCKY_NAMESPACE;
 using namespace ROCKY_NAMESPACE::util;
@@ -26,10 +25,11 @@ SurfaceNode::SurfaceNode(const TileKey& tilekey, const SRS& worldSRS) :
 }
 
 void
-SurfaceNode::setElevation(Image::Ptr raster, const glm::fmat4& scaleBias)
+SurfaceNode::setElevation(Image::Ptr raster, const glm::fmat4& scaleBias, const glm::fvec2& range)
 {
     _elevationRaster = raster;
     _elevationMatrix = scaleBias;
+    _elevationRange = range;
     _boundsDirty = true;
     recomputeBound();
 }
@@ -69,8 +69,6 @@ SurfaceNode::recomputeBound()
 
     if (_elevationRaster)
     {
-        Heightfield hf(_elevationRaster);
-
         double
             scaleU = _elevationMatrix[0][0],
             scaleV = _elevationMatrix[1][1],
@@ -83,9 +81,11 @@ SurfaceNode::recomputeBound()
         {
             if (((int)geom->uvs->at(i).z & VERTEX_HAS_ELEVATION) == 0)
             {
-                float h = hf.heightAtUV(
+                float value = _elevationRaster->read_bilinear(
                     clamp(geom->uvs->at(i).x * scaleU + biasU, 0.0, 1.0),
-                    clamp(geom->uvs->at(i).y * scaleV + biasV, 0.0, 1.0));
+                    clamp(geom->uvs->at(i).y * scaleV + biasV, 0.0, 1.0)).r;
+
+                float h = _elevationRange.x + value * _elevationRange.y;
 
                 auto& vert = geom->verts->at(i);
                 auto& norm = geom->normals->at(i);
@@ -183,3 +183,11 @@ SurfaceNode::recomputeBound()
 
     return worldBoundingSphere;
 }
+
+std::size_t
+SurfaceNode::sizeInBytes() const
+{
+    return
+        (_proxyVerts ? _proxyVerts->dataSize() : 0u) +
+        _worldPoints.size() * sizeof(vsg::dvec3);
+}
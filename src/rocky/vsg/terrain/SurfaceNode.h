@@ -23,8 +23,10 @@ namespace ROCKY_NAMESPACE
     public:
         SurfaceNode(const TileKey& tilekey, const SRS& worldSRS);
 
-        //! Update the elevation raster associated with this tile
-        void setElevation(Image::Ptr raster, const glm::fmat4& scaleBias);
+        //! Update the elevation raster associated with this tile.
+        //! Range is the offset and scale that turn raster values into heights,
+        //! for rasters holding normalized values.
+        void setElevation(Image::Ptr raster, const glm::fmat4& scaleBias, const glm::fvec2& range = { 0.0f, 1.0f });
 
         //! Elevation raster representing this surface
         std::shared_ptr<Image> getElevationRaster() const {
@@ -35,6 +37,11 @@ namespace ROCKY_NAMESPACE
         const glm::fmat4& getElevationMatrix() const {
             return _elevationMatrix;
         }
+
+        //! Offset and scale of the elevation raster's values
+        const glm::fvec2& getElevationRange() const {
+            return _elevationRange;
+        }
         
         //! World-space visibility check (includes bounding box
         //! and horizon checks)
@@ -43,6 +50,10 @@ namespace ROCKY_NAMESPACE
         //! Force a recompute of the bounding box and culling information
         const vsg::dsphere& recomputeBound();
 
+        //! Memory held by this surface's own geometry (not counting the
+        //! pooled tile geometry), in bytes
+        std::size_t sizeInBytes() const;
+
         vsg::dsphere worldBoundingSphere;
         vsg::dbox localbbox;
 
@@ -67,6 +78,7 @@ namespace ROCKY_NAMESPACE
         int _lastFramePassedCull = 0;
         std::shared_ptr<Image> _elevationRaster;
         glm::fmat4 _elevationMatrix;
+        glm::fvec2 _elevationRange{ 0.0f, 1.0f };
         std::vector<vsg::dvec3> _worldPoints;
         bool _boundsDirty = true;
         vsg::dvec3 _horizonCullingPoint;
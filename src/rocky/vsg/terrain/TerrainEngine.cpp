@@ -35,7 +35,11 @@ TerrainEngine::TerrainEngine(
     ROCKY_SOFT_ASSERT(map, "Map is required");
     ROCKY_SOFT_ASSERT(profile.valid(), "Valid profile required");
 
-    jobs::get_pool(loadSchedulerName)->set_concurrency(settings.concurrency);
+    auto pool = jobs::get_pool(loadSchedulerName);
+    if (settings.adaptiveConcurrency)
+        pool->set_adaptive_concurrency(settings.concurrency, settings.maxConcurrency);
+    else
+        pool->set_concurrency(settings.concurrency);
 
     // geometry pooling not supported for QSC yet.
     if (new_profile.srs().isQSC())
@@ -52,7 +56,8 @@ TerrainEngine::createTile(const TileKey& key, vsg::ref_ptr<TerrainTileNode> pare
     {
         settings.tileSize,
         settings.skirtRatio,
-        false // morphing
+        false, // morphing
+        stateFactory.usingCompactVertices() // must match the pipeline
     };
 
     // Get a shared geometry from the pool that corresponds to this tile key:
@@ -93,7 +98,18 @@ bool TerrainEngine::update(VSGContext context)
     geometryPool.sweep(context);
 
     auto pool = jobs::get_pool(loadSchedulerName);
-    if (pool->concurrency() != settings.concurrency)
+    if (settings.adaptiveConcurrency)
+    {
+        auto minThreads = std::max((unsigned)settings.concurrency, 1u);
+        auto maxThreads = std::max((unsigned)settings.maxConcurrency, minThreads);
+        std::pair<unsigned, unsigned> range{ minThreads, maxThreads };
+        if (!pool->adaptive() || pool->adaptive_range() != range)
+        {
+            pool->set_adaptive_concurrency(range.first, range.second);
+            changes = true;
+        }
+    }
+    else if (pool->adaptive() || pool->concurrency() != settings.concurrency)
     {
         pool->set_concurrency(settings.concurrency);
         changes = true;
@@ -215,7 +215,7 @@ Result<>
 TerrainNode::createProfiles(VSGContext context)
 {
     // create the graphics pipeline to render this map
-    if (!terrainState.setupTerrainStateGroup(*this, context))
+    if (!terrainState.setupTerrainStateGroup(*this, *this, context))
     {
         return Failure("Failed to set up terrain state group");
     }
@@ -250,9 +250,56 @@ TerrainNode::update(VSGContext context)
     // check for settings change
     terrainState.updateSettings(*this);
 
+    // upload any new tile textures (texture array mode)
+    terrainState.updateTextureArrays(context);
+
     return changes;
 }
 
+void
+TerrainNode::requestPrefetch(const std::vector<TerrainPrefetchHint>& hints)
+{
+    if (hints.empty() || !prefetch.value())
+        return;
+
+    for (auto& child : children)
+    {
+        if (auto c = child.cast<TerrainProfileNode>())
+            c->tiles().prefetch(hints);
+    }
+}
+
+TerrainTilePager::Stats
+TerrainNode::pagerStats() const
+{
+    TerrainTilePager::Stats total;
+    for (auto& child : children)
+    {
+        if (auto c = child.cast<TerrainProfileNode>())
+        {
+            auto stats = c->tiles().stats();
+            total.tiles += stats.tiles;
+            total.loaded += stats.loaded;
+            total.pendingLeaves += stats.pendingLeaves;
+            total.refinements += stats.refinements;
+            total.canceledLoads += stats.canceledLoads;
+            total.placeholderLoads += stats.placeholderLoads;
+            total.offscreenTiles += stats.offscreenTiles;
+            total.evictions += stats.evictions;
+            total.residentBytes += stats.residentBytes;
+            total.peakBytes += stats.peakBytes;
+            total.lastTimeToFinalDetail = std::max(total.lastTimeToFinalDetail, stats.lastTimeToFinalDetail);
+            total.maxTimeToFinalDetail = std::max(total.maxTimeToFinalDetail, stats.maxTimeToFinalDetail);
+            total.prefetch.issued += stats.prefetch.issued;
+            total.prefetch.hits += stats.prefetch.hits;
+            total.prefetch.wasted += stats.prefetch.wasted;
+            total.prefetch.canceled += stats.prefetch.canceled;
+            total.prefetch.pending += stats.prefetch.pending;
+        }
+    }
+    return total;
+}
+
 const TerrainSettings&
 TerrainProfileNode::settings() const
 {
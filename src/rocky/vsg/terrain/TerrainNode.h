@@ -59,6 +59,10 @@ namespace ROCKY_NAMESPACE
             return _tiles;
         }
 
+        const TerrainTilePager& tiles() const {
+            return _tiles;
+        }
+
     private:
 
         //! Tracks and updates state for terrain tiles
@@ -98,6 +102,13 @@ namespace ROCKY_NAMESPACE
         //! @return true if any updates were applied
         bool update(VSGContext context);
 
+        //! Tells the terrain where the camera is likely to be soon (for example, from
+        //! the MapManipulator's motion) so it can start loading data for those places.
+        void requestPrefetch(const std::vector<TerrainPrefetchHint>& hints);
+
+        //! Combined paging statistics for all tiling profiles
+        TerrainTilePager::Stats pagerStats() const;
+
         //! Map containing data model for the terrain
         std::shared_ptr<const Map> map;
 
@@ -25,7 +25,17 @@ TerrainSettings::from_json(std::string_view JSON)
     get_to(j, "skirtRatio", skirtRatio);
     get_to(j, "color", color);
     get_to(j, "concurrency", concurrency);
+    get_to(j, "adaptiveConcurrency", adaptiveConcurrency);
+    get_to(j, "maxConcurrency", maxConcurrency);
     get_to(j, "wireOverlay", wireOverlay);
+    get_to(j, "skipLOD", skipLOD);
+    get_to(j, "prefetch", prefetch);
+    get_to(j, "maxPrefetchTiles", maxPrefetchTiles);
+    get_to(j, "residencyBudget", residencyBudget);
+    get_to(j, "textureArrays", textureArrays);
+    get_to(j, "textureArraySlots", textureArraySlots);
+    get_to(j, "compressTextures", compressTextures);
+    get_to(j, "compactTerrain", compactTerrain);
 
     return ResultVoidOK;
 }
@@ -43,6 +53,16 @@ TerrainSettings::to_json() const
     set(j, "skirtRatio", skirtRatio);
     set(j, "color", color);
     set(j, "concurrency", concurrency);
+    set(j, "adaptiveConcurrency", adaptiveConcurrency);
+    set(j, "maxConcurrency", maxConcurrency);
     set(j, "wireOverlay", wireOverlay);
+    set(j, "skipLOD", skipLOD);
+    set(j, "prefetch", prefetch);
+    set(j, "maxPrefetchTiles", maxPrefetchTiles);
+    set(j, "residencyBudget", residencyBudget);
+    set(j, "textureArrays", textureArrays);
+    set(j, "textureArraySlots", textureArraySlots);
+    set(j, "compressTextures", compressTextures);
+    set(j, "compactTerrain", compactTerrain);
     return j.dump();
 }
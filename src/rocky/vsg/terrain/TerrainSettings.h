@@ -55,11 +55,62 @@ namespace ROCKY_NAMESPACE
         option<Color> color = Color::White;
 
         //! Number of threads dedicated to loading terrain data
+        //! (the minimum number when adaptiveConcurrency is on)
         option<unsigned> concurrency = 6;
 
+        //! Whether the terrain loader adjusts its thread count between concurrency
+        //! and maxConcurrency, based on how much time loading jobs spend waiting on I/O
+        option<bool> adaptiveConcurrency = false;
+
+        //! Maximum number of terrain loading threads when adaptiveConcurrency is on
+        option<unsigned> maxConcurrency = 32;
+
         //! Whether to render a wireframe overlay on the terrain
         option<bool> wireOverlay = false;
 
+        //! Whether to page in the terrain's final level of detail directly, instead
+        //! of loading each level of detail before the next. Intermediate tiles are
+        //! still created, but only as placeholders that do not load data.
+        option<bool> skipLOD = false;
+
+        //! Whether to load data ahead of time for tiles the camera is predicted
+        //! to need (see TerrainNode::prefetch)
+        option<bool> prefetch = false;
+
+        //! Maximum number of prefetched tiles to load or hold at once
+        option<unsigned> maxPrefetchTiles = 64;
+
+        //! Memory, in megabytes, that terrain tiles may occupy before the pager starts
+        //! releasing the ones the camera is no longer using. Until then, off-screen tiles
+        //! stay resident so that returning to a previous view is instant. Zero (the
+        //! default) means release off-screen tiles right away.
+        option<unsigned> residencyBudget = 0;
+
+        //! Whether to store the terrain's color and elevation textures in shared
+        //! texture arrays, so that all tiles render with one descriptor set and each
+        //! tile only pushes the indices of its textures. Avoids creating and compiling
+        //! a descriptor set for every tile update. Takes effect when the map is set.
+        option<bool> textureArrays = false;
+
+        //! Number of textures of each kind (color, elevation) the shared texture
+        //! arrays can hold at once when textureArrays is on. The arrays reserve
+        //! memory for all of them, on both the CPU and the GPU, up front. When they
+        //! run low, the pager releases off-screen tiles even within residencyBudget.
+        option<unsigned> textureArraySlots = 512;
+
+        //! Whether to build mipmaps for color tiles and block-compress them on the
+        //! loading threads, so they take less GPU memory and upload faster.
+        //! (Otherwise VSG generates the mipmaps on the GPU during upload.)
+        //! Does not apply when textureArrays is on.
+        option<bool> compressTextures = false;
+
+        //! Whether to store tile elevation textures as 16-bit values normalized to
+        //! each tile's height range, and tile geometry as 16-bit vertex attributes.
+        //! Roughly halves the terrain's memory use at a small cost in precision.
+        //! With textureArrays on, only the geometry is compacted.
+        //! Takes effect when the map is set.
+        option<bool> compactTerrain = false;
+
     public: // internal runtime settings, not serialized.
 
         //! TEMPORARY.
@@ -17,6 +17,10 @@
 #include <vsg/state/BindDescriptorSet.h>
 #include <vsg/state/ViewDependentState.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
 #define TERRAIN_VERT_SHADER "shaders/rocky.terrain.vert"
 #define TERRAIN_FRAG_SHADER "shaders/rocky.terrain.frag"
 
@@ -35,14 +39,91 @@
 #define TILE_UBO_NAME "tile"
 #define TILE_UBO_BINDING 13
 
+// texture array mode (see TerrainSettings::textureArrays)
+#define TEXTURE_ARRAYS_DEFINE "ROCKY_TEXTURE_ARRAYS"
+#define ELEVATION_ARRAY_TILE_SIZE 257
+
+// 16-bit vertex attributes (see TerrainSettings::compactTerrain)
+#define COMPACT_TERRAIN_DEFINE "ROCKY_COMPACT_TERRAIN"
+
+// per-tile push constants follow VSG's projection and modelview matrices
+#define TILE_PUSH_CONSTANTS_OFFSET 128
+
+// state stack slot for the per-tile push constants, above the slots VSG
+// uses for the pipeline and the descriptor sets
+#define TILE_PUSH_CONSTANTS_SLOT 3
+
 #define ATTR_VERTEX "in_vertex"
 #define ATTR_NORMAL "in_normal"
 #define ATTR_UV "in_uvw"
+#define ATTR_VERTEX_SCALE "in_vertex_scale"
+#define ATTR_VERTEX_BIAS "in_vertex_bias"
 #define ATTR_VERTEX_NEIGHBOR "in_vertex_neighbor"
 #define ATTR_NORMAL_NEIGHBOR "in_normal_neighbor"
 
 using namespace ROCKY_NAMESPACE;
 
+namespace
+{
+    // Pushes a tile's texture slots and scale/bias values (texture array mode).
+    // There's nothing to compile, so tiles can swap these out freely.
+    class PushTileConstants : public vsg::Inherit<vsg::StateCommand, PushTileConstants>
+    {
+    public:
+        PushTileConstants(vsg::ref_ptr<vsg::PipelineLayout> in_layout, const TerrainTileDescriptors::PushConstants& in_values) :
+            Inherit(TILE_PUSH_CONSTANTS_SLOT),
+            layout(in_layout),
+            values(in_values) { }
+
+        vsg::ref_ptr<vsg::PipelineLayout> layout;
+        TerrainTileDescriptors::PushConstants values;
+
+        void record(vsg::CommandBuffer& commandBuffer) const override
+        {
+            vkCmdPushConstants(commandBuffer, layout->vk(commandBuffer.deviceID), VK_SHADER_STAGE_VERTEX_BIT,
+                TILE_PUSH_CONSTANTS_OFFSET, sizeof(values), &values);
+        }
+    };
+
+    TerrainTileDescriptors::PushConstants makePushConstants(const TerrainTileRenderModel& model,
+        const TerrainTextureArray& colors, const TerrainTextureArray& elevations)
+    {
+        auto& em = model.elevation.matrix;
+        auto& cm = model.color.matrix;
+        auto& es = model.elevation.slot ? *model.elevation.slot : *elevations.defaultSlot;
+        auto& cs = model.color.slot ? *model.color.slot : *colors.defaultSlot;
+
+        TerrainTileDescriptors::PushConstants pc;
+        pc.elevation_scale_bias = glm::fvec4(em[0][0], em[3][0], em[3][1], 0.0f);
+        pc.color_scale_bias = glm::fvec4(cm[0][0], cm[1][1], cm[3][0], cm[3][1]);
+        pc.slots = glm::ivec4(es.page, es.layer, cs.page, cs.layer);
+        return pc;
+    }
+
+    // Converts a heightfield to 16-bit values normalized to its height range,
+    // and outputs the offset and scale that restore the heights.
+    std::shared_ptr<Image> quantizeHeightfield(const GeoImage& heightfield, glm::fvec2& range)
+    {
+        float minHeight = heightfield.minValue(), maxHeight = heightfield.maxValue();
+        if (!(maxHeight >= minHeight))
+            minHeight = maxHeight = 0.0f;
+
+        range = { minHeight, maxHeight - minHeight };
+
+        auto& source = *heightfield.image();
+        auto image = Image::create(Image::R16_UNORM, source.width(), source.height());
+
+        const float* in = source.data<float>();
+        auto* out = image->data<std::uint16_t>();
+        float scale = range.y > 0.0f ? 65535.0f / range.y : 0.0f;
+
+        for (unsigned i = 0; i < source.sizeInPixels(); ++i)
+            out[i] = (std::uint16_t)std::lround(std::clamp((in[i] - minHeight) * scale, 0.0f, 65535.0f));
+
+        return image;
+    }
+}
+
 TerrainState::TerrainState(VSGContext context)
 {
     // set up the texture samplers and placeholder images we will use to render terrain.
@@ -68,7 +149,8 @@ TerrainState::createDefaultDescriptors(VSGContext& context)
 
     // color channel
     // TODO: more than one - make this an array?
-    // TODO: activate mipmapping
+    // maxLod > 0 makes VSG generate mipmaps when it uploads uncompressed color;
+    // compressed color (TerrainSettings::compressTextures) brings its own.
     texturedefs.color = { COLOR_TEX_NAME, COLOR_TEX_BINDING, vsg::Sampler::create(), {} };
     texturedefs.color.sampler->minFilter = VK_FILTER_LINEAR;
     texturedefs.color.sampler->magFilter = VK_FILTER_LINEAR;
@@ -180,24 +262,45 @@ TerrainState::createShaderSet(VSGContext& context) const
     shaderSet = vsg::ShaderSet::create(shaderStages);
 
     // "binding" (3rd param) must match "layout(location=X) in" in the vertex shader
-    shaderSet->addAttributeBinding(ATTR_VERTEX, "", 0, VK_FORMAT_R32G32B32_SFLOAT, vsg::vec3Array::create(1));
-    shaderSet->addAttributeBinding(ATTR_NORMAL, "", 1, VK_FORMAT_R32G32B32_SFLOAT, vsg::vec3Array::create(1));
-    shaderSet->addAttributeBinding(ATTR_UV, "", 2, VK_FORMAT_R32G32B32_SFLOAT, vsg::vec3Array::create(1));
+    if (_compactVertices)
+    {
+        // see GeometryPool for the layout
+        shaderSet->addAttributeBinding(ATTR_VERTEX, "", 0, VK_FORMAT_R16G16B16A16_UNORM, vsg::usvec4Array::create(1));
+        shaderSet->addAttributeBinding(ATTR_NORMAL, "", 1, VK_FORMAT_R16G16B16A16_SNORM, vsg::svec4Array::create(1));
+        shaderSet->addAttributeBinding(ATTR_UV, "", 2, VK_FORMAT_R16G16B16A16_UNORM, vsg::usvec4Array::create(1));
+        shaderSet->addAttributeBinding(ATTR_VERTEX_SCALE, "", 3, VK_FORMAT_R32G32B32_SFLOAT, vsg::vec3Array::create(1));
+        shaderSet->addAttributeBinding(ATTR_VERTEX_BIAS, "", 4, VK_FORMAT_R32G32B32_SFLOAT, vsg::vec3Array::create(1));
+    }
+    else
+    {
+        shaderSet->addAttributeBinding(ATTR_VERTEX, "", 0, VK_FORMAT_R32G32B32_SFLOAT, vsg::vec3Array::create(1));
+        shaderSet->addAttributeBinding(ATTR_NORMAL, "", 1, VK_FORMAT_R32G32B32_SFLOAT, vsg::vec3Array::create(1));
+        shaderSet->addAttributeBinding(ATTR_UV, "", 2, VK_FORMAT_R32G32B32_SFLOAT, vsg::vec3Array::create(1));
+    }
     //shaderSet->addAttributeBinding(ATTR_VERTEX_NEIGHBOR, "", 3, VK_FORMAT_R32G32B32A32_SFLOAT, vsg::vec3Array::create(1));
     //shaderSet->addAttributeBinding(ATTR_NORMAL_NEIGHBOR, "", 4, VK_FORMAT_R32G32B32A32_SFLOAT, vsg::vec3Array::create(1));
 
+    // In texture array mode, each texture binding is an array of pages.
+    uint32_t textureCount = usingTextureArrays() ? TerrainTextureArray::pages : 1;
+
     // "binding" (4th param) must match "layout(location=X) uniform" in the shader
-    shaderSet->addDescriptorBinding(texturedefs.elevation.name, "", 0, texturedefs.elevation.uniform_binding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_VERTEX_BIT, {});
-    shaderSet->addDescriptorBinding(texturedefs.color.name, "", 0, texturedefs.color.uniform_binding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, {});
+    shaderSet->addDescriptorBinding(texturedefs.elevation.name, "", 0, texturedefs.elevation.uniform_binding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, textureCount, VK_SHADER_STAGE_VERTEX_BIT, {});
+    shaderSet->addDescriptorBinding(texturedefs.color.name, "", 0, texturedefs.color.uniform_binding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, textureCount, VK_SHADER_STAGE_FRAGMENT_BIT, {});
     //shaderSet->addDescriptorBinding(texturedefs.normal.name, "", 0, texturedefs.normal.uniform_binding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, {});
-    shaderSet->addDescriptorBinding(TILE_UBO_NAME, "", 0, TILE_UBO_BINDING, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, {});
+    if (!usingTextureArrays())
+        shaderSet->addDescriptorBinding(TILE_UBO_NAME, "", 0, TILE_UBO_BINDING, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, {});
     shaderSet->addDescriptorBinding(SETTINGS_UBO_NAME, "", 0, SETTINGS_UBO_BINDING, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, {});
     
     PipelineUtils::addViewDependentData(shaderSet, VK_SHADER_STAGE_FRAGMENT_BIT);
 
     // Note: 128 is the maximum size required by the Vulkan spec, 
     // so don't increase it :)
-    shaderSet->addPushConstantRange("pc", "", VK_SHADER_STAGE_VERTEX_BIT, 0, 128);
+    // Texture array mode appends the per-tile values, but only after
+    // checking that the device supports the larger size.
+    uint32_t pushConstantsSize = usingTextureArrays() ?
+        TILE_PUSH_CONSTANTS_OFFSET + sizeof(TerrainTileDescriptors::PushConstants) : 128;
+
+    shaderSet->addPushConstantRange("pc", "", VK_SHADER_STAGE_VERTEX_BIT, 0, pushConstantsSize);
 
     return shaderSet;
 }
@@ -213,19 +316,46 @@ TerrainState::createPipelineConfig(VSGContext& context) const
     auto config = vsg::GraphicsPipelineConfig::create(shaderSet);
 
     // Apply any custom compile settings / defines:
-    config->shaderHints = context->shaderCompileSettings;
+    if (usingTextureArrays() || _compactVertices)
+    {
+        // copy the shared settings so the defines stay with this pipeline
+        config->shaderHints = vsg::ShaderCompileSettings::create(*context->shaderCompileSettings);
+
+        if (usingTextureArrays())
+            config->shaderHints->defines.insert(TEXTURE_ARRAYS_DEFINE);
+
+        if (_compactVertices)
+            config->shaderHints->defines.insert(COMPACT_TERRAIN_DEFINE);
+    }
+    else
+    {
+        config->shaderHints = context->shaderCompileSettings;
+    }
 
-    // activate the arrays we intend to use
-    config->enableArray(ATTR_VERTEX, VK_VERTEX_INPUT_RATE_VERTEX, 12);
-    config->enableArray(ATTR_NORMAL, VK_VERTEX_INPUT_RATE_VERTEX, 12);
-    config->enableArray(ATTR_UV, VK_VERTEX_INPUT_RATE_VERTEX, 12);
+    // activate the arrays we intend to use, in the order GeometryPool supplies them
+    if (_compactVertices)
+    {
+        config->enableArray(ATTR_VERTEX, VK_VERTEX_INPUT_RATE_VERTEX, 8);
+        config->enableArray(ATTR_NORMAL, VK_VERTEX_INPUT_RATE_VERTEX, 8);
+        config->enableArray(ATTR_UV, VK_VERTEX_INPUT_RATE_VERTEX, 8);
+        config->enableArray(ATTR_VERTEX_SCALE, VK_VERTEX_INPUT_RATE_INSTANCE, 12);
+        config->enableArray(ATTR_VERTEX_BIAS, VK_VERTEX_INPUT_RATE_INSTANCE, 12);
+    }
+    else
+    {
+        config->enableArray(ATTR_VERTEX, VK_VERTEX_INPUT_RATE_VERTEX, 12);
+        config->enableArray(ATTR_NORMAL, VK_VERTEX_INPUT_RATE_VERTEX, 12);
+        config->enableArray(ATTR_UV, VK_VERTEX_INPUT_RATE_VERTEX, 12);
+    }
 
     // activate the descriptors we intend to use
     config->enableTexture(texturedefs.elevation.name);
     config->enableTexture(texturedefs.color.name);
     //config->enableTexture(texturedefs.normal.name);
 
-    config->enableDescriptor(TILE_UBO_NAME);
+    if (!usingTextureArrays())
+        config->enableDescriptor(TILE_UBO_NAME);
+
     config->enableDescriptor(SETTINGS_UBO_NAME);
 
     PipelineUtils::enableViewDependentData(config);
@@ -252,10 +382,28 @@ TerrainState::createPipelineConfig(VSGContext& context) const
 }
 
 bool
-TerrainState::setupTerrainStateGroup(vsg::StateGroup& stateGroup, VSGContext& context)
+TerrainState::setupTerrainStateGroup(vsg::StateGroup& stateGroup, const TerrainSettings& settings, VSGContext& context)
 {
     ROCKY_SOFT_ASSERT_AND_RETURN(status.ok(), false);
 
+    // Switching texture modes or vertex formats changes the shader interface,
+    // so rebuild the shader set when that happens.
+    if (settings.textureArrays.value() != usingTextureArrays() ||
+        settings.compactTerrain.value() != _compactVertices)
+    {
+        _colorArray = nullptr;
+        _elevationArray = nullptr;
+
+        if (settings.textureArrays.value())
+            createTextureArrays(settings, context);
+
+        _compactVertices = settings.compactTerrain.value();
+        _compactElevation = _compactVertices && supportsCompactElevation(context);
+
+        shaderSet = createShaderSet(context);
+        ROCKY_SOFT_ASSERT_AND_RETURN(shaderSet, false);
+    }
+
     // create the configurator object:
     pipelineConfig = createPipelineConfig(context);
 
@@ -277,16 +425,110 @@ TerrainState::setupTerrainStateGroup(vsg::StateGroup& stateGroup, VSGContext& co
     // Descriptors are the global terrain uniform buffer and the VSG view-dependent buffer.
     stateGroup.add(pipelineConfig->bindGraphicsPipeline);
     stateGroup.add(vsg::BindViewDescriptorSets::create(VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineConfig->layout, VSG_VIEW_DEPENDENT_DESCRIPTOR_SET_INDEX));
+
+    if (usingTextureArrays())
+    {
+        // In texture array mode, every tile shares one descriptor set holding
+        // the texture arrays and the settings UBO, so we bind it once here.
+        auto elevation = vsg::DescriptorImage::create(
+            _elevationArray->imageInfos(texturedefs.elevation.sampler),
+            texturedefs.elevation.uniform_binding,
+            0, // array element
+            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+
+        auto color = vsg::DescriptorImage::create(
+            _colorArray->imageInfos(texturedefs.color.sampler),
+            texturedefs.color.uniform_binding,
+            0, // array element
+            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+
+        auto descriptorSet = vsg::DescriptorSet::create(
+            pipelineConfig->layout->setLayouts[0],
+            vsg::Descriptors{ elevation, color, _terrainDescriptors.ubo });
+
+        stateGroup.add(vsg::BindDescriptorSet::create(
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            pipelineConfig->layout,
+            0, // first set
+            descriptorSet));
+
+        // Placeholder tile values. Each tile pushes its own on top of these.
+        stateGroup.add(PushTileConstants::create(
+            pipelineConfig->layout,
+            makePushConstants(TerrainTileRenderModel(), *_colorArray, *_elevationArray)));
+    }
     
     return true;
 }
 
+bool
+TerrainState::createTextureArrays(const TerrainSettings& settings, VSGContext& context)
+{
+    unsigned capacity = std::max(settings.textureArraySlots.value(), TerrainTextureArray::pages);
+    unsigned layersPerPage = (capacity + TerrainTextureArray::pages - 1) / TerrainTextureArray::pages;
+    uint32_t pushConstantsSize = TILE_PUSH_CONSTANTS_OFFSET + sizeof(TerrainTileDescriptors::PushConstants);
+
+    if (auto device = context->device())
+    {
+        auto& limits = device->getPhysicalDevice()->getProperties().limits;
+        if (limits.maxPushConstantsSize < pushConstantsSize || limits.maxImageArrayLayers < layersPerPage)
+        {
+            Log()->warn("Terrain texture arrays are not supported on this device; using per-tile textures instead");
+            return false;
+        }
+    }
+
+    unsigned colorSize = std::max((unsigned)settings.tilePixelSize.value(), 1u);
+
+    _colorArray = std::make_shared<TerrainTextureArray>(
+        Image::R8G8B8A8_UNORM, colorSize, capacity, Color("#08AEE0"));
+
+    _elevationArray = std::make_shared<TerrainTextureArray>(
+        Image::R32_SFLOAT, ELEVATION_ARRAY_TILE_SIZE, capacity, Image::Pixel(0.0f));
+
+    return true;
+}
+
+bool
+TerrainState::supportsCompactElevation(VSGContext& context) const
+{
+    // linear filtering of 16-bit textures is optional in Vulkan
+    if (auto device = context->device())
+    {
+        auto properties = device->getPhysicalDevice()->getFormatProperties(VK_FORMAT_R16_UNORM);
+        if ((properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) == 0)
+        {
+            Log()->warn("16-bit terrain elevation is not supported on this device; using 32-bit elevation instead");
+            return false;
+        }
+    }
+    return true;
+}
+
+void
+TerrainState::updateTextureArrays(VSGContext& context)
+{
+    if (!usingTextureArrays())
+        return;
+
+    auto frameStamp = context->viewer->getFrameStamp();
+    auto frame = frameStamp ? frameStamp->frameCount : 0;
+
+    _colorArray->update(frame);
+    _elevationArray->update(frame);
+}
+
 TerrainTileRenderModel
 TerrainState::updateRenderModel(const TerrainTileRenderModel& oldRenderModel, const TerrainTileModel& dataModel, VSGContext& runtime) const
 {
     ROCKY_SOFT_ASSERT_AND_RETURN(status.ok(), oldRenderModel);
     ROCKY_SOFT_ASSERT_AND_RETURN(pipelineConfig.valid(), oldRenderModel);
 
+    if (usingTextureArrays())
+    {
+        return updateArrayRenderModel(oldRenderModel, dataModel);
+    }
+
     // Copy the old one
     TerrainTileRenderModel renderModel = oldRenderModel;
     TerrainTileDescriptors& descriptors = renderModel.descriptors;
@@ -296,11 +538,23 @@ TerrainState::updateRenderModel(const TerrainTileRenderModel& oldRenderModel, co
         auto& layer = dataModel.colorLayers[0];
 
         renderModel.color.name = "color " + layer.key.str();
-        renderModel.color.image = layer.image.image();
         renderModel.color.matrix = layer.matrix;
 
-        // TODO: evaluate this 'clone' operation...
-        auto data = util::wrapImageInVSG(renderModel.color.image);
+        // Keep only one copy of the color around: the compressed one when we have it.
+        vsg::ref_ptr<vsg::Data> data;
+        if (layer.compressed)
+        {
+            renderModel.color.image = nullptr;
+            renderModel.color.compressed = layer.compressed;
+            data = util::wrapCompressedImageInVSG(renderModel.color.compressed);
+        }
+        else
+        {
+            renderModel.color.image = layer.image.image();
+            renderModel.color.compressed = nullptr;
+            data = util::wrapImageInVSG(renderModel.color.image);
+        }
+
         if (data)
         {
             // queue the old data for safe disposal
@@ -326,9 +580,18 @@ TerrainState::updateRenderModel(const TerrainTileRenderModel& oldRenderModel, co
     if (dataModel.elevation.heightfield.valid())
     {
         renderModel.elevation.name = "elevation " + dataModel.elevation.key.str();
-        renderModel.elevation.image = dataModel.elevation.heightfield.image();
         renderModel.elevation.matrix = dataModel.elevation.matrix;
 
+        if (_compactElevation)
+        {
+            renderModel.elevation.image = quantizeHeightfield(dataModel.elevation.heightfield, renderModel.elevation.range);
+        }
+        else
+        {
+            renderModel.elevation.image = dataModel.elevation.heightfield.image();
+            renderModel.elevation.range = { 0.0f, 1.0f };
+        }
+
         auto data = util::wrapImageInVSG(renderModel.elevation.image);
         if (data)
         {
@@ -358,6 +621,7 @@ TerrainState::updateRenderModel(const TerrainTileRenderModel& oldRenderModel, co
     uniforms.elevation_matrix = renderModel.elevation.matrix;
     uniforms.color_matrix = renderModel.color.matrix;
     uniforms.model_matrix = renderModel.modelMatrix;
+    uniforms.elevation_range = glm::fvec4(renderModel.elevation.range, 0.0f, 0.0f);
     descriptors.uniforms = vsg::DescriptorBuffer::create(ubo, TILE_UBO_BINDING);
 
     // make the descriptor set, and include the terrain settings UBO
@@ -382,6 +646,47 @@ TerrainState::updateRenderModel(const TerrainTileRenderModel& oldRenderModel, co
     return renderModel;
 }
 
+TerrainTileRenderModel
+TerrainState::updateArrayRenderModel(const TerrainTileRenderModel& oldRenderModel, const TerrainTileModel& dataModel) const
+{
+    // Copy the old one
+    TerrainTileRenderModel renderModel = oldRenderModel;
+
+    // When an array is full, the tile keeps the texture it already has.
+    if (dataModel.colorLayers.size() > 0 && dataModel.colorLayers[0].image.valid())
+    {
+        auto& layer = dataModel.colorLayers[0];
+
+        if (auto slot = _colorArray->store(layer.image.image()))
+        {
+            renderModel.color.name = "color " + layer.key.str();
+            renderModel.color.image = layer.image.image();
+            renderModel.color.matrix = layer.matrix;
+            renderModel.color.slot = slot;
+        }
+    }
+
+    if (dataModel.elevation.heightfield.valid())
+    {
+        if (auto slot = _elevationArray->store(dataModel.elevation.heightfield.image()))
+        {
+            renderModel.elevation.name = "elevation " + dataModel.elevation.key.str();
+            renderModel.elevation.image = dataModel.elevation.heightfield.image();
+            renderModel.elevation.matrix = dataModel.elevation.matrix;
+            renderModel.elevation.slot = slot;
+        }
+    }
+
+    // The textures are already bound, so all the tile needs is its push constants.
+    // Nothing here needs compiling.
+    renderModel.descriptors = { };
+    renderModel.descriptors.bind = PushTileConstants::create(
+        pipelineConfig->layout,
+        makePushConstants(renderModel, *_colorArray, *_elevationArray));
+
+    return renderModel;
+}
+
 void
 TerrainState::updateSettings(const TerrainSettings& settings)
 {    
@@ -393,3 +698,189 @@ TerrainState::updateSettings(const TerrainSettings& settings)
         _terrainDescriptors.data->dirty();
     }
 }
+
+
+
+TerrainTextureArray::TerrainTextureArray(Image::PixelFormat format, unsigned size, unsigned capacity, const Image::Pixel& placeholder) :
+    _format(format),
+    _size(size)
+{
+    _layersPerPage = std::max((capacity + pages - 1) / pages, 1u);
+
+    vsg::Data::Properties props;
+    props.format = util::toVkPixelFormat(format);
+    props.origin = vsg::TOP_LEFT;
+    props.maxNumMipmaps = 1;
+    props.imageViewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+    // pages are rewritten (and re-uploaded) as tiles come and go
+    props.dataVariance = vsg::DYNAMIC_DATA;
+
+    for (unsigned p = 0; p < pages; ++p)
+    {
+        vsg::ref_ptr<vsg::Data> page;
+        if (format == Image::R32_SFLOAT)
+            page = vsg::floatArray3D::create(size, size, _layersPerPage, props);
+        else
+            page = vsg::ubvec4Array3D::create(size, size, _layersPerPage, props);
+
+        std::memset(page->dataPointer(), 0, page->dataSize());
+        _pages.emplace_back(page);
+
+        // hand out the low layers first
+        auto& free = _free.emplace_back();
+        for (unsigned layer = _layersPerPage; layer > 0; --layer)
+            free.push_back(layer - 1);
+    }
+
+    // The placeholder lives in the first layer for the life of the array.
+    defaultSlot = std::make_shared<TextureSlot>();
+    _free[0].pop_back();
+    _inUse = 1;
+
+    Image layer(format, size, size);
+    layer.fill(placeholder);
+    std::memcpy(_pages[0]->dataPointer(), layer.data<std::uint8_t>(), layer.sizeInBytes());
+}
+
+std::shared_ptr<TextureSlot>
+TerrainTextureArray::store(std::shared_ptr<Image> image)
+{
+    if (!image)
+        return {};
+
+    // resample anything that doesn't fit a layer as-is
+    if (image->pixelFormat() != _format || image->width() != _size || image->height() != _size)
+    {
+        auto fitted = std::make_shared<Image>(_format, _size, _size);
+        float step = _size > 1 ? 1.0f / (float)(_size - 1) : 0.0f;
+
+        for (unsigned t = 0; t < _size; ++t)
+            for (unsigned s = 0; s < _size; ++s)
+                fitted->write(image->read_bilinear((float)s * step, (float)t * step), s, t);
+
+        image = fitted;
+    }
+
+    std::scoped_lock lock(_mutex);
+
+    auto slot = allocate();
+    if (slot)
+    {
+        _staged.emplace_back(Staged{ slot, image });
+    }
+    else if (!_warnedFull)
+    {
+        Log()->warn("Terrain texture array is full; consider increasing TerrainSettings::textureArraySlots");
+        _warnedFull = true;
+    }
+
+    return slot;
+}
+
+std::shared_ptr<TextureSlot>
+TerrainTextureArray::allocate()
+{
+    // recycle slots that no frame in flight can still be using
+    while (!_retired.empty() && _frame >= _retired.front().frame + retireFrames)
+    {
+        auto& slot = _retired.front().slot;
+        _free[slot.page].push_back(slot.layer);
+        _retired.pop_front();
+    }
+
+    // Keep filling the page we used last, so a burst of new tiles uploads as
+    // few pages as possible. When it's full, move on to the emptiest one.
+    if (_free[_lastPage].empty())
+    {
+        unsigned best = 0;
+        for (unsigned p = 1; p < pages; ++p)
+        {
+            if (_free[p].size() > _free[best].size())
+                best = p;
+        }
+
+        if (_free[best].empty())
+            return {};
+
+        _lastPage = best;
+    }
+
+    TextureSlot value{ _lastPage, _free[_lastPage].back() };
+    _free[_lastPage].pop_back();
+    ++_inUse;
+
+    std::weak_ptr<TerrainTextureArray> weak = weak_from_this();
+
+    return std::shared_ptr<TextureSlot>(new TextureSlot(value), [weak](TextureSlot* slot)
+        {
+            if (auto array = weak.lock())
+                array->release(*slot);
+            delete slot;
+        });
+}
+
+void
+TerrainTextureArray::release(const TextureSlot& slot)
+{
+    std::scoped_lock lock(_mutex);
+    _retired.emplace_back(Retired{ slot, _frame });
+    --_inUse;
+}
+
+void
+TerrainTextureArray::update(std::uint64_t frame)
+{
+    std::vector<Staged> staged;
+    {
+        std::scoped_lock lock(_mutex);
+        _frame = std::max(_frame, frame);
+        staged.swap(_staged);
+    }
+
+    // Note: no lock from here on, since dropping the last reference
+    // to a slot releases it.
+    std::vector<bool> touched(pages, false);
+
+    for (auto& entry : staged)
+    {
+        // skip textures whose tiles went away before we got to them
+        auto slot = entry.slot.lock();
+        if (!slot)
+            continue;
+
+        auto bytes = entry.image->sizeInBytes();
+        auto* dest = static_cast<std::uint8_t*>(_pages[slot->page]->dataPointer()) + (std::size_t)slot->layer * bytes;
+        std::memcpy(dest, entry.image->data<std::uint8_t>(), bytes);
+
+        touched[slot->page] = true;
+    }
+
+    for (unsigned p = 0; p < pages; ++p)
+    {
+        if (touched[p])
+            _pages[p]->dirty();
+    }
+}
+
+vsg::ImageInfoList
+TerrainTextureArray::imageInfos(vsg::ref_ptr<vsg::Sampler> sampler) const
+{
+    vsg::ImageInfoList result;
+    for (auto& page : _pages)
+        result.emplace_back(vsg::ImageInfo::create(sampler, page, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL));
+    return result;
+}
+
+unsigned
+TerrainTextureArray::slotsInUse() const
+{
+    std::scoped_lock lock(_mutex);
+    return _inUse;
+}
+
+bool
+TerrainTextureArray::needsSpace() const
+{
+    std::scoped_lock lock(_mutex);
+    return _inUse + std::max(capacity() / 8u, 1u) > capacity();
+}
@@ -7,6 +7,8 @@
 
 #include <rocky/vsg/VSGContext.h>
 #include <rocky/vsg/terrain/TerrainTileNode.h>
+#include <deque>
+#include <mutex>
 
 namespace ROCKY_NAMESPACE
 {
@@ -27,6 +29,94 @@ namespace ROCKY_NAMESPACE
         vsg::ref_ptr<vsg::Descriptor> ubo;
     };
 
+    /**
+     * Shared texture array that holds one terrain texture per layer, so that all
+     * tiles can render with the same descriptor set and select their textures by
+     * index (see TerrainSettings::textureArrays).
+     *
+     * The layers are split across a fixed number of pages (one Vulkan image each)
+     * so that storing a texture only uploads the page it lands in.
+     */
+    class ROCKY_VSG_INTERNAL TerrainTextureArray : public std::enable_shared_from_this<TerrainTextureArray>
+    {
+    public:
+        //! Number of pages in each array. Must match the terrain shaders.
+        static constexpr unsigned pages = 8;
+
+        //! Frames a released slot waits before it's reused, so that frames
+        //! still in flight never sample a texture that was replaced under them
+        static constexpr unsigned retireFrames = 3;
+
+        //! Construct an array.
+        //! @param format Pixel format of each layer (R8G8B8A8_UNORM or R32_SFLOAT)
+        //! @param size Width and height of each layer, in pixels
+        //! @param capacity Number of layers across all pages
+        //! @param placeholder Value of the default texture
+        TerrainTextureArray(Image::PixelFormat format, unsigned size, unsigned capacity, const Image::Pixel& placeholder);
+
+        //! Stages an image for copying into a free layer and returns its slot,
+        //! or nullptr if the array is full. Images that don't match the layer
+        //! format or size are resampled. Safe to call from any thread.
+        std::shared_ptr<TextureSlot> store(std::shared_ptr<Image> image);
+
+        //! Copies staged images into their layers and schedules the pages they
+        //! touched for upload. Call from the update thread; calling more than
+        //! once in a frame is harmless.
+        void update(std::uint64_t frame);
+
+        //! One image info per page, for a descriptor
+        vsg::ImageInfoList imageInfos(vsg::ref_ptr<vsg::Sampler> sampler) const;
+
+        //! Number of layers in each page
+        unsigned layersPerPage() const {
+            return _layersPerPage;
+        }
+
+        //! Number of slots currently holding a texture (including the placeholder)
+        unsigned slotsInUse() const;
+
+        //! Number of layers across all pages (including the placeholder)
+        unsigned capacity() const {
+            return _layersPerPage * pages;
+        }
+
+        //! Whether fewer than 1/8 of the slots are left, meaning that tiles
+        //! should be released before new ones find the array full
+        bool needsSpace() const;
+
+        //! Slot holding the placeholder texture tiles use before they have data
+        std::shared_ptr<TextureSlot> defaultSlot;
+
+    private:
+        struct Staged
+        {
+            std::weak_ptr<TextureSlot> slot;
+            std::shared_ptr<Image> image;
+        };
+
+        struct Retired
+        {
+            TextureSlot slot;
+            std::uint64_t frame;
+        };
+
+        Image::PixelFormat _format;
+        unsigned _size;
+        unsigned _layersPerPage;
+        std::vector<vsg::ref_ptr<vsg::Data>> _pages;
+        mutable std::mutex _mutex;
+        std::vector<std::vector<unsigned>> _free; // free layers, per page
+        std::deque<Retired> _retired;
+        std::vector<Staged> _staged;
+        unsigned _lastPage = 0;
+        unsigned _inUse = 0;
+        std::uint64_t _frame = 0;
+        bool _warnedFull = false;
+
+        std::shared_ptr<TextureSlot> allocate();
+        void release(const TextureSlot&);
+    };
+
     /**
      * TerrainState creates all the Vulkan state necessary to
      * render the terrain.
@@ -43,7 +133,7 @@ namespace ROCKY_NAMESPACE
         TerrainState(VSGContext);
 
         //! Configures an existing stategroup for rendering terrain
-        bool setupTerrainStateGroup(vsg::StateGroup& stateGroup, VSGContext& context);
+        bool setupTerrainStateGroup(vsg::StateGroup& stateGroup, const TerrainSettings& settings, VSGContext& context);
 
         //! Integrates data from the new data model into an existing render model,
         //! and creates or updates all the necessary descriptors and commands.
@@ -56,6 +146,27 @@ namespace ROCKY_NAMESPACE
 
         void updateSettings(const TerrainSettings&);
 
+        //! Uploads textures staged by updateRenderModel when using shared
+        //! texture arrays. Call from the update thread before the new render
+        //! models are installed.
+        void updateTextureArrays(VSGContext& context);
+
+        //! Whether tiles use shared texture arrays (see TerrainSettings::textureArrays)
+        bool usingTextureArrays() const {
+            return _colorArray != nullptr;
+        }
+
+        //! Whether a shared texture array is running out of slots. The pager
+        //! then releases tiles as if it were over its residency budget.
+        bool textureArraysNeedSpace() const {
+            return usingTextureArrays() && (_colorArray->needsSpace() || _elevationArray->needsSpace());
+        }
+
+        //! Whether tile geometry uses 16-bit vertex attributes (see TerrainSettings::compactTerrain)
+        bool usingCompactVertices() const {
+            return _compactVertices;
+        }
+
         //! Status of the factory.
         Status status;
 
@@ -116,5 +227,24 @@ namespace ROCKY_NAMESPACE
 
         // terrain-wide settings, etc.
         TerrainDescriptors _terrainDescriptors;
+
+        // shared texture arrays, when TerrainSettings::textureArrays is on
+        std::shared_ptr<TerrainTextureArray> _colorArray;
+        std::shared_ptr<TerrainTextureArray> _elevationArray;
+
+        // TerrainSettings::compactTerrain
+        bool _compactVertices = false;
+        bool _compactElevation = false;
+
+        //! Sets up the shared texture arrays if the device supports them
+        bool createTextureArrays(const TerrainSettings&, VSGContext&);
+
+        //! Whether the device can filter 16-bit elevation textures
+        bool supportsCompactElevation(VSGContext&) const;
+
+        //! updateRenderModel for when tiles use the shared texture arrays
+        TerrainTileRenderModel updateArrayRenderModel(
+            const TerrainTileRenderModel& oldRenderModel,
+            const TerrainTileModel& newDataModel) const;
     };
 }
@@ -10,6 +10,8 @@
 #include <rocky/Math.h>
 #include <rocky/vsg/VSGUtils.h>
 
+#include <algorithm>
+
 using namespace ROCKY_NAMESPACE;
 
 #define LC "[TerrainTileNode] "
@@ -50,12 +52,90 @@ TerrainTileNode::accept(vsg::ConstVisitor& visitor) const
     }
 }
 
+namespace
+{
+    // Adapts a record traversal for TerrainTileNode::traverseTile
+    struct RecordView
+    {
+        vsg::RecordTraversal& rv;
+
+        inline std::uint64_t frame() const { return rv.getFrameStamp()->frameCount; }
+        inline vsg::time_point time() const { return rv.getFrameStamp()->time; }
+        inline double range(const vsg::dvec3& p) const { return distanceTo(p, rv.getState()); }
+        inline bool visible(const SurfaceNode& surface) const { return surface.isVisible(rv); }
+        inline double lodDistance(const vsg::dsphere& bound) const { return rv.getState()->lodDistance(bound); }
+        inline double viewportHeight() const {
+            return rv.getState()->_commandBuffer->viewDependentState->viewportData->at(0)[3];
+        }
+        inline vsg::RecordTraversal& record() const { return rv; }
+        inline void payload(const vsg::Node& node) const { node.accept(rv); }
+        inline void subtiles(const vsg::Node& quad) const { quad.accept(rv); }
+    };
+
+    // Adapts a simulated view for TerrainTileNode::traverseTile
+    struct SimulatedView
+    {
+        TerrainTileSimulatedView& view;
+
+        inline std::uint64_t frame() const { return view.frame; }
+        inline vsg::time_point time() const { return view.time; }
+        inline double range(const vsg::dvec3& p) const {
+            return glm::distance(view.eye, glm::dvec3(p.x, p.y, p.z));
+        }
+        inline bool visible(const SurfaceNode& surface) const
+        {
+            auto& bs = surface.worldBoundingSphere;
+            glm::dvec3 center(bs.center.x, bs.center.y, bs.center.z);
+
+            if (!view.horizon.isVisible(center, bs.radius))
+                return false;
+
+            // is the bounding sphere inside the view cone?
+            auto to_center = center - view.eye;
+            auto d = glm::length(to_center);
+            if (d <= bs.radius)
+                return true;
+
+            // half-angle of the cone that encloses the frustum (through its corners)
+            auto half_fov = std::atan(std::tan(0.5 * util::deg2rad(view.fovy)) * std::sqrt(1.0 + view.aspectRatio * view.aspectRatio));
+            auto angle = std::acos(std::clamp(glm::dot(to_center / d, view.lookVector), -1.0, 1.0));
+            return angle - std::asin(bs.radius / d) <= half_fov;
+        }
+        inline double lodDistance(const vsg::dsphere& bound) const { return range(bound.center); }
+        inline double viewportHeight() const { return view.viewportHeight; }
+        inline vsg::RecordTraversal& record() const { return *view.record; }
+        inline void payload(const vsg::Node&) const { ++view.tilesDrawn; }
+        inline void subtiles(const vsg::Node& quad) const
+        {
+            for (auto& child : static_cast<const vsg::QuadGroup&>(quad).children)
+                static_cast<const TerrainTileNode*>(child.get())->simulate(view);
+        }
+    };
+}
+
 void
 TerrainTileNode::accept(vsg::RecordTraversal& rv) const
+{
+    RecordView view{ rv };
+    traverseTile(view);
+}
+
+void
+TerrainTileNode::simulate(TerrainTileSimulatedView& in_view) const
+{
+    ROCKY_SOFT_ASSERT_AND_RETURN(in_view.record != nullptr, void());
+
+    SimulatedView view{ in_view };
+    traverseTile(view);
+}
+
+template<class VIEW>
+void
+TerrainTileNode::traverseTile(VIEW& view) const
 {
     ROCKY_SOFT_ASSERT_AND_RETURN(host != nullptr, void());
 
-    auto frame = rv.getFrameStamp()->frameCount;
+    auto frame = view.frame();
 
     // is this a new frame (since the last time we were here)?
     auto new_frame = lastTraversalFrame.exchange(frame) != frame;
@@ -63,20 +143,18 @@ TerrainTileNode::accept(vsg::RecordTraversal& rv) const
     // swap out the range; used for page out
     lastTraversalRange.exchange(std::min(
         (float)(new_frame ? FLT_MAX : (float)lastTraversalRange),
-        (float)distanceTo(bound.center, rv.getState())));
+        (float)view.range(bound.center)));
 
     // swap out the time; used for page out
-    lastTraversalTime.exchange(rv.getFrameStamp()->time);
+    lastTraversalTime.exchange(view.time());
 
     if (subtilesExist())
     {
         needsSubtiles = false;
     }
 
-    if (surface->isVisible(rv))
+    if (view.visible(*surface))
     {
-        auto state = rv.getState();
-
         // should we subdivide?
         bool subdivisionPossible = key.level < host->settings().maxLevel;
         bool subtilesInRange = false;
@@ -84,9 +162,8 @@ TerrainTileNode::accept(vsg::RecordTraversal& rv) const
 
         if (subdivisionPossible)
         {
-            auto& vp = state->_commandBuffer->viewDependentState->viewportData->at(0);
-            auto min_screen_height_ratio = (host->settings().tilePixelSize + host->settings().pixelError) / vp[3];
-            auto d = state->lodDistance(bound);
+            auto min_screen_height_ratio = (host->settings().tilePixelSize + host->settings().pixelError) / view.viewportHeight();
+            auto d = view.lodDistance(bound);
             subtilesInRange = (d > 0.0) && (bound.r > (d * min_screen_height_ratio));
 
             // TODO: someday, when we support orthographic cameras, look at this approach 
@@ -99,15 +176,15 @@ TerrainTileNode::accept(vsg::RecordTraversal& rv) const
                 traversePayload = false;
 
                 // children are available, traverse them now.
-                children[1]->accept(rv);
+                view.subtiles(*children[1]);
 
 #ifdef AGGRESSIVE_PAGEOUT
                 // always ping all children at once so the system can never
                 // delete one of a quad.
-                host->ping(subTile(0), this, rv);
-                host->ping(subTile(1), this, rv);
-                host->ping(subTile(2), this, rv);
-                host->ping(subTile(3), this, rv);
+                host->ping(subTile(0), this, view.record());
+                host->ping(subTile(1), this, view.record());
+                host->ping(subTile(2), this, view.record());
+                host->ping(subTile(3), this, view.record());
 #endif
             }
         }
@@ -115,7 +192,8 @@ TerrainTileNode::accept(vsg::RecordTraversal& rv) const
         if (traversePayload)
         {
             // children do not exist or are out of range; use this tile's geometry
-            children[0]->accept(rv);
+            view.payload(*children[0]);
+            lastPayloadFrame.exchange(frame);
 
             if (subtilesInRange && subtilesLoader.empty())
             {
@@ -129,17 +207,17 @@ TerrainTileNode::accept(vsg::RecordTraversal& rv) const
     {
         // always ping all children at once so the system can never
         // delete one of a quad.
-        host->ping(subTile(0), this, rv);
-        host->ping(subTile(1), this, rv);
-        host->ping(subTile(2), this, rv);
-        host->ping(subTile(3), this, rv);
+        host->ping(subTile(0), this, view.record());
+        host->ping(subTile(1), this, view.record());
+        host->ping(subTile(2), this, view.record());
+        host->ping(subTile(3), this, view.record());
     }
 #endif
 
     // keep this tile alive if requested
     if (doNotExpire)
     {
-        host->ping(const_cast<TerrainTileNode*>(this), nullptr, rv);
+        host->ping(const_cast<TerrainTileNode*>(this), nullptr, view.record());
     }
 }
 
@@ -157,7 +235,7 @@ TerrainTileNode::inheritFrom(vsg::ref_ptr<TerrainTileNode> parent)
     revision = parent->revision;
 
     // copy the parent's elevation data and recompute the bounding sphere
-    surface->setElevation(renderModel.elevation.image, renderModel.elevation.matrix);
+    surface->setElevation(renderModel.elevation.image, renderModel.elevation.matrix, renderModel.elevation.range);
 
     renderModel.modelMatrix = to_glm(surface->matrix);
 }
@@ -11,6 +11,8 @@
 #include <rocky/Threading.h>
 #include <rocky/TileKey.h>
 #include <rocky/Image.h>
+#include <rocky/CompressedImage.h>
+#include <rocky/Horizon.h>
 
 #include <vsg/nodes/QuadGroup.h>
 #include <vsg/nodes/CullGroup.h>
@@ -28,11 +30,23 @@ namespace ROCKY_NAMESPACE
     class TerrainSettings;
     class Runtime;
 
+    //! Location of a texture in one of the terrain's shared texture arrays
+    //! (see TerrainSettings::textureArrays). Tiles that share a texture share its
+    //! slot, and the slot goes back to the array once the last of them lets go.
+    struct TextureSlot
+    {
+        unsigned page = 0;
+        unsigned layer = 0;
+    };
+
     struct TextureData
     {
         std::string name;
         std::shared_ptr<Image> image;
+        std::shared_ptr<CompressedImage> compressed; // replaces image when present
         glm::dmat4 matrix{ 1 };
+        glm::fvec2 range{ 0.0f, 1.0f }; // offset and scale that restore normalized values (16-bit elevation)
+        std::shared_ptr<TextureSlot> slot;
     };
 
     enum TextureType
@@ -51,6 +65,14 @@ namespace ROCKY_NAMESPACE
             glm::fmat4 elevation_matrix;
             glm::fmat4 color_matrix;
             glm::fmat4 model_matrix;
+            glm::fvec4 elevation_range; // x = offset, y = scale
+        };
+        // see rocky.terrain.vert (texture array mode)
+        struct PushConstants
+        {
+            glm::fvec4 elevation_scale_bias;
+            glm::fvec4 color_scale_bias;
+            glm::ivec4 slots; // elevation page, elevation layer, color page, color layer
         };
         vsg::ref_ptr<vsg::DescriptorImage> color;
         vsg::ref_ptr<vsg::DescriptorImage> elevation;
@@ -68,13 +90,32 @@ namespace ROCKY_NAMESPACE
 
         void applyScaleBias(const glm::dmat4& sb)
         {
-            if (color.image)
+            if (color.image || color.compressed)
                 color.matrix *= sb;
             if (elevation.image)
                 elevation.matrix *= sb;
         }
     };
 
+    /**
+     * Stand-in for a camera that drives the terrain without a record traversal
+     * (and therefore without a GPU), for paging simulations and benchmarks.
+     * See TerrainTileNode::simulate.
+     */
+    struct TerrainTileSimulatedView
+    {
+        glm::dvec3 eye = { 0, 0, 0 };        // eye position in world coordinates
+        glm::dvec3 lookVector = { 0, 0, -1 }; // unit view direction in world coordinates
+        double fovy = 30.0;                  // vertical field of view, degrees
+        double aspectRatio = 16.0 / 9.0;     // viewport width / height
+        double viewportHeight = 1080.0;      // pixels
+        std::uint64_t frame = 0;             // frame number; advance it every traversal
+        vsg::time_point time;                // frame time
+        Horizon horizon;                     // horizon for culling; set its eye to match
+        vsg::RecordTraversal* record = nullptr; // passed through to TerrainTileHost::ping
+        std::size_t tilesDrawn = 0;          // output: number of tiles that drew geometry
+    };
+
     /**
      * TileNode represents a single tile. TileNode has 5 children:
      * one SurfaceNode that renders the actual tile content under a MatrixTransform;
@@ -94,6 +135,7 @@ namespace ROCKY_NAMESPACE
         mutable std::atomic<uint64_t> lastTraversalFrame = { 0 };
         mutable std::atomic<vsg::time_point> lastTraversalTime;
         mutable std::atomic<float> lastTraversalRange = { FLT_MAX };
+        mutable std::atomic<uint64_t> lastPayloadFrame = { 0 }; // last frame this tile drew its own geometry
 
         //! Update this node (placeholder).
         //! @return true if any changes occur.
@@ -105,6 +147,10 @@ namespace ROCKY_NAMESPACE
 
         //! Intersectors, etc.
         void accept(vsg::ConstVisitor& visitor) const override;
+
+        //! Runs the same level-of-detail selection and paging as the record traversal,
+        //! from a simulated camera instead of a real one.
+        void simulate(TerrainTileSimulatedView& view) const;
         
     protected:
 
@@ -119,6 +165,10 @@ namespace ROCKY_NAMESPACE
 
     private:
 
+        //! Level-of-detail selection and paging, shared by accept and simulate
+        template<class VIEW>
+        void traverseTile(VIEW& view) const;
+
         //! Whether child tiles are present
         inline bool subtilesExist() const
         {
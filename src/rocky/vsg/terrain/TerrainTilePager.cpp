@@ -8,6 +8,7 @@
 #include "TerrainSettings.h"
 #include "../VSGUtils.h"
 #include <rocky/TerrainTileModelFactory.h>
+#include <algorithm>
 
 using namespace ROCKY_NAMESPACE;
 
@@ -17,11 +18,144 @@ using namespace ROCKY_NAMESPACE;
 
 //----------------------------------------------------------------------------
 
+namespace
+{
+    std::atomic<std::uint64_t> s_pagerUID = { 0 };
+
+    // Job priority of a prefetch that no tile has asked for yet:
+    // lower than any real tile load.
+    constexpr float PREFETCH_PRIORITY = -FLT_MAX * 0.5f;
+}
+
+// Priority function of a prefetch job. It starts out low, and takes on
+// the priority of the tile that claims it.
+struct TerrainTilePager::PrefetchPriority
+{
+    std::function<float()> tilePriority;
+    std::atomic_bool claimed = { false };
+
+    inline float operator()() const {
+        return claimed.load(std::memory_order_acquire) ? tilePriority() : PREFETCH_PRIORITY;
+    }
+
+    inline void claim(std::function<float()> func) {
+        tilePriority = std::move(func);
+        claimed.store(true, std::memory_order_release);
+    }
+};
+
+TerrainTilePager::TileInfo*
+TerrainTilePager::TileTable::find(const TileID& id)
+{
+    if (_size == 0u)
+        return nullptr;
+    auto& slot = _slots[probe(id)];
+    return slot.used ? &slot.info : nullptr;
+}
+
+const TerrainTilePager::TileInfo*
+TerrainTilePager::TileTable::find(const TileID& id) const
+{
+    if (_size == 0u)
+        return nullptr;
+    auto& slot = _slots[probe(id)];
+    return slot.used ? &slot.info : nullptr;
+}
+
+TerrainTilePager::TileInfo&
+TerrainTilePager::TileTable::operator[](const TileID& id)
+{
+    // keep the load factor under 3/4
+    if ((_size + 1u) * 4u > _slots.size() * 3u)
+    {
+        rehash(std::max(_slots.size() * 2u, (std::size_t)256u));
+    }
+
+    auto& slot = _slots[probe(id)];
+    if (!slot.used)
+    {
+        slot.id = id;
+        slot.used = true;
+        ++_size;
+    }
+    return slot.info;
+}
+
+bool
+TerrainTilePager::TileTable::erase(const TileID& id)
+{
+    if (_size == 0u)
+        return false;
+
+    auto i = probe(id);
+    if (!_slots[i].used)
+        return false;
+
+    // backward-shift deletion: pull any displaced entries that follow into
+    // the hole, so that lookups never need tombstones.
+    for (auto j = (i + 1u) & _mask; _slots[j].used; j = (j + 1u) & _mask)
+    {
+        auto home = _slots[j].id.hash() & _mask;
+        bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+        if (!stays)
+        {
+            _slots[i] = std::move(_slots[j]);
+            i = j;
+        }
+    }
+
+    _slots[i].used = false;
+    _slots[i].info = { };
+    --_size;
+    return true;
+}
+
+void
+TerrainTilePager::TileTable::clear()
+{
+    _slots.clear();
+    _size = 0u;
+    _mask = 0u;
+}
+
+std::size_t
+TerrainTilePager::TileTable::probe(const TileID& id) const
+{
+    // returns the slot holding id, or the empty slot where it belongs
+    auto i = id.hash() & _mask;
+    while (_slots[i].used && !(_slots[i].id == id))
+        i = (i + 1u) & _mask;
+    return i;
+}
+
+void
+TerrainTilePager::TileTable::rehash(std::size_t capacity)
+{
+    std::vector<Slot> old;
+    old.swap(_slots);
+    _slots.resize(capacity); // power of two
+    _mask = capacity - 1u;
+
+    for (auto& slot : old)
+    {
+        if (slot.used)
+        {
+            auto& dest = _slots[probe(slot.id)];
+            dest = std::move(slot);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+
 TerrainTilePager::TerrainTilePager(const TerrainSettings& settings, TerrainTileHost* host) :
     _host(host),
-    _settings(settings)
+    _settings(settings),
+    _uid(++s_pagerUID)
 {
     _firstLOD = settings.minLevel;
+    _compressedImages = std::make_shared<TerrainTileModelFactory::CompressedImageCache>(256);
+    _ancestorImages = std::make_shared<TerrainTileModelFactory::AncestorImageCache>(16 * 1024 * 1024);
 }
 
 TerrainTilePager::~TerrainTilePager()
@@ -40,76 +174,179 @@ TerrainTilePager::releaseAll()
     _loadData.clear();
     _mergeData.clear();
     _updateData.clear();
+    _prefetches.clear();
+    _prefetchHints.clear();
+    _pendingLeaves = 0u;
+    _refining = false;
+    _residentBytes = {};
+    _pinged = 0u;
+
+    std::scoped_lock buffers_lock(_pingBuffersMutex);
+    for (auto& buffer : _pingBuffers)
+    {
+        std::scoped_lock buffer_lock(buffer->mutex);
+        buffer->pings.clear();
+    }
+}
+
+TerrainTilePager::PingBuffer&
+TerrainTilePager::pingBuffer()
+{
+    // Each thread caches the buffers it has registered, tagged with the owning
+    // pager's UID (pagers come and go, and a new one might reuse an old one's
+    // address). Only a thread's first ping to a pager takes the registration lock.
+    struct Cached {
+        std::uint64_t uid = 0;
+        PingBuffer* buffer = nullptr;
+        std::weak_ptr<PingBuffer> owned; // expires with the pager
+    };
+    thread_local std::vector<Cached> cache;
+
+    for (auto& entry : cache)
+    {
+        if (entry.uid == _uid)
+            return *entry.buffer;
+    }
+
+    // forget the buffers of pagers that no longer exist:
+    cache.erase(
+        std::remove_if(cache.begin(), cache.end(), [](const Cached& entry) { return entry.owned.expired(); }),
+        cache.end());
+
+    std::scoped_lock lock(_pingBuffersMutex);
+    _pingBuffers.emplace_back(std::make_shared<PingBuffer>());
+    cache.emplace_back(Cached{ _uid, _pingBuffers.back().get(), _pingBuffers.back() });
+    return *cache.back().buffer;
 }
 
 void
 TerrainTilePager::ping(TerrainTileNode* tile, const TerrainTileNode* parent, vsg::RecordTraversal& rv)
 {
-    if (_settings.supportMultiThreadedRecord)
-        _mutex.lock();
+    auto& buffer = pingBuffer();
+    std::scoped_lock lock(buffer.mutex);
+    if (parent)
+        buffer.pings.emplace_back(Ping{ vsg::ref_ptr<TerrainTileNode>(tile), TileID(parent->key), true });
+    else
+        buffer.pings.emplace_back(Ping{ vsg::ref_ptr<TerrainTileNode>(tile), TileID(), false });
+}
+
+void
+TerrainTilePager::processPing(const Ping& ping)
+{
+    auto* tile = ping.tile.get();
+    TileID id(tile->key);
 
     // first, update the tracker to keep this tile alive.
-    auto& info = _tiles[tile->key];
+    auto& info = _tiles[id];
     if (!info.tile)
-        info.tile = tile;
+    {
+        info.tile = ping.tile;
+        account(info, ResidentBytes{ 0u, 0u, tile->surface->sizeInBytes() });
+    }
+
+    if (info.lastPingCycle != _cycle)
+    {
+        info.lastPingCycle = _cycle;
+        ++_pinged;
+    }
 
     if (info.trackerToken)
         info.trackerToken = _tracker.update(info.trackerToken);
     else
         info.trackerToken = _tracker.emplace(info.tile);
 
+    // A leaf is a visible tile that drew its own geometry during the last record.
+    const bool leaf = (tile->lastPayloadFrame == tile->lastTraversalFrame);
+
+    // A tile that is about to give way to its subtiles still counts as a leaf
+    // until they exist.
+    const bool subdividing =
+        tile->needsSubtiles ||
+        (info.childrenCreator.working()) ||
+        (info.childrenCreator.available() && info.childrenCreator.value() && !tile->subtilesExist());
+
     // next, see if the tile needs anything.
-    // "progressive" means do not load LOD N+1 until LOD N is complete.
-    // This is currently the only option.
-    const bool progressive = true;
-    if (progressive)
+    if (_settings.skipLOD.value())
+    {
+        // "skip LOD" means go straight to the level of detail the camera needs.
+        // Intermediate tiles get created (so their children can exist) but they
+        // do not load any data of their own; they inherit their ancestor's and
+        // serve as placeholders. Only the root tiles and the final leaves load data.
+        info.placeholder = ping.hasParent && (!leaf || subdividing);
+
+        if (tile->needsSubtiles)
+        {
+            _createChildren.push_back(id);
+        }
+
+        if (info.placeholder)
+        {
+            // a load from when this tile was a leaf is of no use now
+            if (info.dataLoader.working())
+            {
+                info.dataLoader.abandon();
+                ++_stats.canceledLoads;
+            }
+        }
+        else if (info.dataLoader.empty())
+        {
+            _loadData.push_back(id);
+        }
+    }
+    else
     {
+        // "progressive" means do not load LOD N+1 until LOD N is complete.
+
         // If this tile is fully merged, and it needs children, queue them up to load.
         if (info.dataMerger.available() && tile->needsSubtiles)
         {
-            _createChildren.push_back(tile->key);
+            _createChildren.push_back(id);
         }
 
-        if (parent == nullptr)
+        if (!ping.hasParent)
         {
             // If this is a root tile, and it needs data, queue that up:
             if (info.dataLoader.empty())
             {
-                _loadData.emplace_back(tile->key);
+                _loadData.emplace_back(id);
             }
         }
         else
         {
             // If this is a non-root tile that needs data, check to make sure the 
             // parent's tile is done loaded before queueing that up.
-            auto& parent_info = _tiles[parent->key];
-            if (!parent_info.tile)
-            {
-                ROCKY_SOFT_ASSERT_AND_RETURN(parent_info.tile, void());
-            }
-            if (parent_info.tile && parent_info.dataMerger.available() && info.dataLoader.empty())
+            // (The parent always pings before its children, so it is in the table.)
+            auto* parent_info = _tiles.find(ping.parent);
+            ROCKY_SOFT_ASSERT_AND_RETURN(parent_info && parent_info->tile, void());
+
+            if (parent_info->dataMerger.available() && info.dataLoader.empty())
             {
-                _loadData.push_back(tile->key);
+                _loadData.push_back(id);
             }
         }
     }
 
+    // A leaf that is still waiting on its data or its subtiles means the
+    // terrain has not yet reached its final detail.
+    if (leaf)
+    {
+        if (!info.dataMerger.available() || subdividing)
+        {
+            ++_pendingLeaves;
+        }
+    }
+
     // If a data-load is complete and ready to merge, queue it up.
-    // This will only queue one merge per frame to prevent overloading
-    // the (synchronous) update cycle in VSG.
     if (info.dataLoader.available() && info.dataMerger.empty())
     {
-        _mergeData.push_back(tile->key);
+        _mergeData.push_back(id);
     }
 
     // Tile updates are TBD.
     if (tile->needsUpdate)
     {
-        _updateData.push_back(tile->key);
+        _updateData.push_back(id);
     }
-
-    if (_settings.supportMultiThreadedRecord)
-        _mutex.unlock();
 }
 
 bool
@@ -117,6 +354,23 @@ TerrainTilePager::update(const vsg::FrameStamp* fs, const IOOptions& io, std::sh
 {
     std::scoped_lock lock(_mutex);
 
+    auto canceledLoads = _stats.canceledLoads;
+
+    // process all the pings from the last record traversal(s):
+    ++_cycle;
+    _pinged = 0u;
+    _pendingLeaves = 0u;
+    {
+        std::scoped_lock buffers_lock(_pingBuffersMutex);
+        for (auto& buffer : _pingBuffers)
+        {
+            std::scoped_lock buffer_lock(buffer->mutex);
+            for (auto& ping : buffer->pings)
+                processPing(ping);
+            buffer->pings.clear();
+        }
+    }
+
     bool changes = false;
 
     changes =
@@ -133,25 +387,25 @@ TerrainTilePager::update(const vsg::FrameStamp* fs, const IOOptions& io, std::sh
     //    << "needsMerge=" << _mergeData.size() << std::endl;
 
     // update any tiles that asked for it
-    for (auto& key : _updateData)
+    for (auto& id : _updateData)
     {
-        auto iter = _tiles.find(key);
-        if (iter != _tiles.end())
+        auto* info = _tiles.find(id);
+        if (info)
         {
-            if (iter->second.tile->update(fs, io))
+            if (info->tile->update(fs, io))
                 changes = true;
         }
     }
     _updateData.clear();
 
     // launch any "new subtiles" requests
-    for (auto& key : _createChildren)
+    for (auto& id : _createChildren)
     {
-        auto iter = _tiles.find(key);
-        if (iter != _tiles.end())
+        auto* info = _tiles.find(id);
+        if (info)
         {
-            requestCreateChildren(iter->second, engine); // parent, context
-            iter->second.tile->needsSubtiles = false;
+            requestCreateChildren(*info, engine); // parent, context
+            info->tile->needsSubtiles = false;
         }
 
         changes = true;
@@ -159,12 +413,12 @@ TerrainTilePager::update(const vsg::FrameStamp* fs, const IOOptions& io, std::sh
     _createChildren.clear();
 
     // launch any data loading requests
-    for (auto& key : _loadData)
+    for (auto& id : _loadData)
     {
-        auto iter = _tiles.find(key);
-        if (iter != _tiles.end())
+        auto* info = _tiles.find(id);
+        if (info)
         {
-            requestLoadData(iter->second, io, engine);
+            requestLoadData(*info, io, engine);
         }
 
         changes = true;
@@ -172,68 +426,352 @@ TerrainTilePager::update(const vsg::FrameStamp* fs, const IOOptions& io, std::sh
     _loadData.clear();
 
     // schedule any data merging requests
-    for (auto& key : _mergeData)
+    for (auto& id : _mergeData)
     {
-        auto iter = _tiles.find(key);
-        if (iter != _tiles.end())
+        auto* info = _tiles.find(id);
+        if (info)
         {
-            requestMergeData(iter->second, io, engine);
+            requestMergeData(*info, io, engine);
+
+            // the tile now holds whatever data it loaded for itself:
+            auto* parent_info = _tiles.find(info->tile->key.createParentKey());
+            auto* parent = parent_info ? parent_info->tile.get() : nullptr;
+            auto& model = info->tile->renderModel;
+            ResidentBytes bytes{ 0u, 0u, info->tile->surface->sizeInBytes() };
+
+            if (model.color.compressed && (!parent || parent->renderModel.color.compressed != model.color.compressed))
+                bytes.color = model.color.compressed->sizeInBytes();
+            else if (model.color.image && (!parent || parent->renderModel.color.image != model.color.image))
+                bytes.color = model.color.image->sizeInBytes();
+
+            if (model.elevation.image && (!parent || parent->renderModel.elevation.image != model.elevation.image))
+                bytes.elevation = model.elevation.image->sizeInBytes();
+
+            account(*info, bytes);
+
+            if (info->dataLoader.value())
+            {
+                ++_stats.loaded;
+                if (info->placeholder)
+                    ++_stats.placeholderLoads;
+            }
         }
 
         changes = true;
     }
     _mergeData.clear();
 
-    // Flush unused tiles (i.e., tiles that failed to ping) out of the system.
+    // get a head start on tiles the camera is about to need
+    requestPrefetches(io, engine);
+
+    // measure how long it takes the terrain to settle at its final detail:
+    auto now = std::chrono::steady_clock::now();
+    if (_pendingLeaves > 0u && !_refining)
+    {
+        _refining = true;
+        _refineStart = now;
+    }
+    else if (_pendingLeaves == 0u && _refining)
+    {
+        _refining = false;
+        _stats.lastTimeToFinalDetail = std::chrono::duration_cast<std::chrono::milliseconds>(now - _refineStart);
+        _stats.maxTimeToFinalDetail = std::max(_stats.maxTimeToFinalDetail, _stats.lastTimeToFinalDetail);
+        ++_stats.refinements;
+    }
+
+    // Stop working on tiles the camera is no longer using, and release them
+    // if we need the memory. Only do this is the frame advanced - otherwise
+    // just leave it be.
+    if (fs->frameCount > _lastUpdate)
+    {
+        cancelOffscreenWork();
+        evict(engine);
+    }
+
+    // loads we just canceled may be asleep waiting to share another tile's
+    // read of the same URI; wake them so they notice and quit.
+    if (_stats.canceledLoads != canceledLoads)
+    {
+        io.services().uriFlights.wake();
+    }
+
+    // synchronize
+    _lastUpdate = fs->frameCount;
+
+    return changes;
+}
+
+void
+TerrainTilePager::cancelOffscreenWork()
+{
+    // Abandoning a job cancels it before it starts, and a running one sees it
+    // through its IOOptions (which aborts any network transfer underway).
+    // The tile stays resident; if it comes back into view it will ask again.
+    _tracker.for_each_stale([&](TerrainTileNode* tile)
+        {
+            auto* info = _tiles.find(tile->key);
+            if (!info || info->lastPingCycle == _cycle)
+                return;
+
+            if (info->dataLoader.working() || info->childrenCreator.working())
+                ++_stats.canceledLoads;
+
+            if (info->dataLoader.working())
+                info->dataLoader.abandon();
+
+            if (info->childrenCreator.working())
+                info->childrenCreator.abandon();
+        });
+}
+
+void
+TerrainTilePager::evict(std::shared_ptr<TerrainEngine> engine)
+{
+    // Tiles that did not ping are off-screen. Keep them around (so that coming back
+    // to them is instant) until the terrain exceeds its memory budget, or runs low
+    // on texture array slots, and then release the least recently used ones until
+    // it fits again.
     // Tiles ping their children all at once; this should in theory prevent
     // a child from expiring without its siblings.
-    // Only do this is the frame advanced - otherwise just leave it be.
-    if (fs->frameCount > _lastUpdate)
+    const std::size_t budget = (std::size_t)_settings.residencyBudget.value() * 1024u * 1024u;
+
+    const auto within_budget = [&]()
     {
-        const auto dispose = [&](TerrainTileNode* tile)
+        return _residentBytes.total() <= budget && !engine->stateFactory.textureArraysNeedSpace();
+    };
+
+    const auto dispose = [&](TerrainTileNode* tile)
+    {
+        if (tile->doNotExpire)
+            return false;
+
+        // A tile cannot go while any of its subtiles are still here; they will
+        // have to go first, on this pass or a later one.
+        if (tile->subtilesExist())
+        {
+            for (unsigned i = 0; i < 4; ++i)
+                if (_tiles.find(tile->subTile(i)->key))
+                    return false;
+        }
+
+        auto key = tile->key;
+        auto* info = _tiles.find(key);
+        auto* parent_info = _tiles.find(key.createParentKey());
+        if (parent_info)
         {
-            if (!tile->doNotExpire)
+            auto parent = parent_info->tile;
+            if (parent.valid())
             {
-                auto key = tile->key;
-                auto parent_iter = _tiles.find(key.createParentKey());
-                if (parent_iter != _tiles.end())
+                // Feed the children to the garbage disposal before removing them
+                // so any vulkan objects are safely destroyed
+                if (tile->children.size() > 1)
+                    engine->context->dispose(tile->children[1]);
+
+                tile->children.resize(1);
+                tile->subtilesLoader.reset();
+                tile->needsSubtiles = false;
+
+                // The tile itself stays in its parent's quad, so release the data it
+                // loaded and have it borrow its parent's instead, like a new tile.
+                if (info && (info->bytes.color > 0u || info->bytes.elevation > 0u))
                 {
-                    auto parent = parent_iter->second.tile;
-                    if (parent.valid())
-                    {
-                        // Feed the children to the garbage disposal before removing them
-                        // so any vulkan objects are safely destroyed
-                        if (tile->children.size() > 1)
-                            engine->context->dispose(tile->children[1]);
-
-                        tile->children.resize(1);
-                        tile->subtilesLoader.reset();
-                        tile->needsSubtiles = false;
-                    }
+                    auto old = tile->renderModel;
+
+                    tile->inheritFrom(parent);
+                    tile->renderModel = engine->stateFactory.updateRenderModel(tile->renderModel, {}, engine->context);
+
+                    if (old.descriptors.color && old.descriptors.color != tile->renderModel.descriptors.color)
+                        engine->context->dispose(old.descriptors.color);
+                    if (old.descriptors.elevation && old.descriptors.elevation != tile->renderModel.descriptors.elevation)
+                        engine->context->dispose(old.descriptors.elevation);
+
+                    for (auto c : tile->stategroup->stateCommands)
+                        engine->context->dispose(c);
+
+                    tile->stategroup->stateCommands = { tile->renderModel.descriptors.bind };
                 }
-                _tiles.erase(key);
-                return true;
             }
-            return false;
-        };
+        }
 
-        _tracker.flush(~0, dispose);
-    }
+        if (info)
+        {
+            // cancelOffscreenWork() already stopped any loads in progress
+            info->dataLoader.abandon();
+            info->childrenCreator.abandon();
 
-    // synchronize
-    _lastUpdate = fs->frameCount;
+            account(*info, ResidentBytes{});
+        }
 
-    return changes;
+        _tiles.erase(key);
+        ++_stats.evictions;
+        return true;
+    };
+
+    _tracker.flush_oldest(within_budget, dispose);
+}
+
+void
+TerrainTilePager::account(TileInfo& info, const ResidentBytes& bytes)
+{
+    _residentBytes -= info.bytes;
+    _residentBytes += bytes;
+    info.bytes = bytes;
+
+    auto& peak = _stats.peakBytes;
+    peak.color = std::max(peak.color, _residentBytes.color);
+    peak.elevation = std::max(peak.elevation, _residentBytes.elevation);
+    peak.geometry = std::max(peak.geometry, _residentBytes.geometry);
 }
 
 vsg::ref_ptr<TerrainTileNode>
 TerrainTilePager::getTile(const TileKey& key) const
 {
     std::scoped_lock lock(_mutex);
-    auto iter = _tiles.find(key);
-    return
-        iter != _tiles.end() ? iter->second.tile :
-        vsg::ref_ptr<TerrainTileNode>(nullptr);
+    auto* info = _tiles.find(key);
+    return info ? info->tile : vsg::ref_ptr<TerrainTileNode>(nullptr);
+}
+
+void
+TerrainTilePager::prefetch(const std::vector<TerrainPrefetchHint>& hints)
+{
+    std::scoped_lock lock(_mutex);
+    _prefetchHints.insert(_prefetchHints.end(), hints.begin(), hints.end());
+}
+
+TerrainTilePager::Stats
+TerrainTilePager::stats() const
+{
+    std::scoped_lock lock(_mutex);
+    auto stats = _stats;
+    stats.tiles = _tiles.size();
+    stats.pendingLeaves = _pendingLeaves;
+    stats.offscreenTiles = _tiles.size() - std::min(_pinged, _tiles.size());
+    stats.residentBytes = _residentBytes;
+    stats.prefetch = _prefetchStats;
+    stats.prefetch.pending = _prefetches.size();
+    return stats;
+}
+
+TerrainTileModelFactory
+TerrainTilePager::createModelFactory(const TerrainEngine& engine) const
+{
+    TerrainTileModelFactory factory;
+    factory.compositeColorLayers = true;
+
+    // texture arrays hold uncompressed color, so only compress for per-tile textures
+    factory.compressColor = _settings.compressTextures.value() && !engine.stateFactory.usingTextureArrays();
+    factory.compressedImageCache = _compressedImages;
+    factory.ancestorImageCache = _ancestorImages;
+
+    return factory;
+}
+
+void
+TerrainTilePager::requestPrefetches(const IOOptions& io, std::shared_ptr<TerrainEngine> engine)
+{
+    auto now = std::chrono::steady_clock::now();
+
+    // discard prefetches that nobody claimed in time. Abandoning the future
+    // cancels the load if it hasn't started yet.
+    for (auto iter = _prefetches.begin(); iter != _prefetches.end(); )
+    {
+        if (now - iter->second.issued > _prefetchExpiry)
+        {
+            if (iter->second.model.available())
+                ++_prefetchStats.wasted;
+            else
+                ++_prefetchStats.canceled;
+
+            iter = _prefetches.erase(iter);
+        }
+        else ++iter;
+    }
+
+    if (_prefetchHints.empty())
+        return;
+
+    if (!_settings.prefetch.value())
+    {
+        _prefetchHints.clear();
+        return;
+    }
+
+    auto& profile = engine->profile;
+    unsigned minLevel = _settings.minLevel.value();
+    unsigned maxLevel = _settings.maxLevel.value();
+    std::size_t maxPrefetches = _settings.maxPrefetchTiles.value();
+
+    auto factory = createModelFactory(*engine);
+
+    auto start = [&](const TileKey& key)
+    {
+        if (!key.valid() || _prefetches.size() >= maxPrefetches)
+            return;
+
+        TileID id(key);
+
+        // skip tiles that are already loaded or loading, or already prefetching:
+        auto* info = _tiles.find(id);
+        if (info && !info->dataLoader.empty())
+            return;
+
+        if (_prefetches.count(id) > 0)
+            return;
+
+        auto priority = std::make_shared<PrefetchPriority>();
+
+        auto model = factory.createTileModelAsync(
+            engine->map,
+            key,
+            io,
+            jobs::context {
+                "prefetch",
+                jobs::get_pool(engine->loadSchedulerName),
+                [priority]() { return (*priority)(); },
+                nullptr
+            });
+
+        _prefetches.emplace(id, Prefetch{ model, priority, now });
+        ++_prefetchStats.issued;
+    };
+
+    for (auto& hint : _prefetchHints)
+    {
+        if (!hint.point.valid() || hint.range <= 0.0 || hint.viewportHeight <= 0.0f)
+            continue;
+
+        // Estimate the LOD the terrain will settle on at this position, using the same
+        // screen-space test as TerrainTileNode (tile radius vs. distance).
+        double ratio = (_settings.tilePixelSize.value() + _settings.pixelError.value()) / hint.viewportHeight;
+        double threshold = hint.range * ratio;
+
+        unsigned targetLevel = minLevel;
+        for (; targetLevel < maxLevel; ++targetLevel)
+        {
+            auto key = TileKey::createTileKeyContainingPoint(hint.point, targetLevel, profile);
+            if (!key.valid() || !(key.extent().computeBoundingGeoCircle().radius() > threshold))
+                break;
+        }
+
+        // Paging is progressive (a tile loads only after its parent) so prefetch the
+        // whole chain of LODs, with the neighbors at each level. Go coarsest first:
+        // those tiles are needed first, and if we hit maxPrefetches it should be
+        // the finest levels that miss out.
+        for (unsigned level = minLevel; level <= targetLevel; ++level)
+        {
+            auto key = TileKey::createTileKeyContainingPoint(hint.point, level, profile);
+            if (!key.valid())
+                continue;
+
+            start(key);
+            for (int dy = -1; dy <= 1; ++dy)
+                for (int dx = -1; dx <= 1; ++dx)
+                    if (dx != 0 || dy != 0)
+                        start(key.createNeighborKey(dx, dy));
+        }
+    }
+
+    _prefetchHints.clear();
 }
 
 void
@@ -306,7 +844,7 @@ TerrainTilePager::requestCreateChildren(TileInfo& info, std::shared_ptr<TerrainE
     info.childrenCreator = jobs::dispatch(
         create_children,
         jobs::context {
-            "create child " + info.tile->key.str(),
+            "create child",
             jobs::get_pool(engine->loadSchedulerName),
             priority_func,
             nullptr
@@ -314,7 +852,7 @@ TerrainTilePager::requestCreateChildren(TileInfo& info, std::shared_ptr<TerrainE
 }
 
 void
-TerrainTilePager::requestLoadData(TileInfo& info, const IOOptions& in_io, std::shared_ptr<TerrainEngine> engine) const
+TerrainTilePager::requestLoadData(TileInfo& info, const IOOptions& in_io, std::shared_ptr<TerrainEngine> engine)
 {
     ROCKY_SOFT_ASSERT_AND_RETURN(info.tile, void());
 
@@ -329,52 +867,73 @@ TerrainTilePager::requestLoadData(TileInfo& info, const IOOptions& in_io, std::s
 
     //RP_DEBUG("requestLoadData -> {}", key.str());
 
-    const IOOptions io(in_io);
-
-    auto load = [key, tile, engine, io](Cancelable& p) -> bool
+    // a callback that will return the loading priority of a tile
+    // we must use a WEAK pointer to allow job cancelation to work
+    vsg::observer_ptr<TerrainTileNode> tile_weak(info.tile);
+    auto priority_func = [tile_weak]() -> float
     {
-        if (p.canceled())
-            return false;
+        vsg::ref_ptr<TerrainTileNode> tile = tile_weak.ref_ptr();
+        return tile ? -(sqrt(tile->lastTraversalRange) * tile->key.level) : -FLT_MAX;
+    };
 
-        TerrainTileModelFactory factory;
-        factory.compositeColorLayers = true;
+    // Load the data and build the render model in the loader pool, whose size
+    // (TerrainSettings::concurrency) limits how much loading goes on at once.
+    // If we already prefetched the data, claim that instead.
+    jobs::future<TerrainTileModel> dataModel;
 
-        auto dataModel = factory.createTileModel(engine->map.get(), key, IOOptions(io, p));
+    auto prefetched = _prefetches.find(TileID(key));
+    if (prefetched != _prefetches.end())
+    {
+        dataModel = prefetched->second.model;
 
-        if (!dataModel.empty())
-        {
-            auto newRenderModel = engine->stateFactory.updateRenderModel(
-                tile->renderModel,
-                dataModel,
-                engine->context);
+        // if it's still in the queue, bump it up to the tile's priority:
+        prefetched->second.priority->claim(priority_func);
+        jobs::get_pool(engine->loadSchedulerName)->invalidate_priorities();
 
-            tile->renderModel = newRenderModel;
+        _prefetches.erase(prefetched);
+        ++_prefetchStats.hits;
+    }
+    else
+    {
+        auto factory = createModelFactory(*engine);
+
+        dataModel = factory.createTileModelAsync(
+            engine->map,
+            key,
+            in_io,
+            jobs::context {
+                "load data",
+                jobs::get_pool(engine->loadSchedulerName),
+                priority_func,
+                nullptr
+            });
+    }
 
-            engine->context->requestFrame();
+    auto build = [tile, engine](const TerrainTileModel& dataModel, Cancelable& p) -> bool
+    {
+        if (p.canceled() || dataModel.empty())
+            return false;
 
-            return true;
-        }
+        auto newRenderModel = engine->stateFactory.updateRenderModel(
+            tile->renderModel,
+            dataModel,
+            engine->context);
 
-        return false;
-    };
+        tile->renderModel = newRenderModel;
 
-    // a callback that will return the loading priority of a tile
-    // we must use a WEAK pointer to allow job cancelation to work
-    vsg::observer_ptr<TerrainTileNode> tile_weak(info.tile);
-    auto priority_func = [tile_weak]() -> float
-    {
-        vsg::ref_ptr<TerrainTileNode> tile = tile_weak.ref_ptr();
-        return tile ? -(sqrt(tile->lastTraversalRange) * tile->key.level) : -FLT_MAX;
+        engine->context->requestFrame();
+
+        return true;
     };
 
-    info.dataLoader = jobs::dispatch(
-        load, 
+    info.dataLoader = dataModel.then(
+        build,
         jobs::context {
-            "load data " + key.str(),
+            "build data",
             jobs::get_pool(engine->loadSchedulerName),
             priority_func,
             nullptr
-        } );
+        });
 }
 
 void
@@ -403,6 +962,10 @@ TerrainTilePager::requestMergeData(TileInfo& info, const IOOptions& in_io, std::
         auto tile = engine->host->tiles().getTile(key);
         if (tile)
         {
+            // in texture array mode, make sure the tile's textures are in place
+            // before it starts pointing at them
+            engine->stateFactory.updateTextureArrays(engine->context);
+
             for (auto c : tile->stategroup->stateCommands)
                 engine->context->dispose(c);
 
@@ -410,7 +973,8 @@ TerrainTilePager::requestMergeData(TileInfo& info, const IOOptions& in_io, std::
 
             tile->surface->setElevation(
                 tile->renderModel.elevation.image,
-                tile->renderModel.elevation.matrix);
+                tile->renderModel.elevation.matrix,
+                tile->renderModel.elevation.range);
 
             engine->context->requestFrame();
             return true;
@@ -8,14 +8,36 @@
 #include <rocky/vsg/VSGContext.h>
 #include <rocky/vsg/terrain/TerrainTileNode.h>
 #include <rocky/SentryTracker.h>
+#include <rocky/TerrainTileModel.h>
+#include <rocky/TerrainTileModelFactory.h>
+#include <rocky/GeoPoint.h>
 #include <chrono>
-#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 namespace ROCKY_NAMESPACE
 {
     class TerrainSettings;
     class Runtime;
 
+    /**
+     * A camera position the terrain should get ready for; for example where
+     * a moving camera is predicted to be shortly, or the destination of a
+     * viewpoint transition.
+     */
+    struct TerrainPrefetchHint
+    {
+        //! Predicted focal point
+        GeoPoint point;
+
+        //! Predicted distance from the camera to the focal point (meters)
+        double range = 0.0;
+
+        //! Height of the viewport (pixels), for estimating the level of detail
+        float viewportHeight = 1080.0f;
+    };
+
     /**
      * Keeps track of all the tiles resident in the terrain engine.
      */
@@ -26,6 +48,24 @@ namespace ROCKY_NAMESPACE
 
         using Tracker = util::SentryTracker<TerrainTileNode*>;
 
+        //! Memory held by terrain tiles, in bytes
+        struct ResidentBytes
+        {
+            std::size_t color = 0;     // color images
+            std::size_t elevation = 0; // elevation images
+            std::size_t geometry = 0;  // per-tile surface geometry
+
+            inline std::size_t total() const {
+                return color + elevation + geometry;
+            }
+            inline void operator += (const ResidentBytes& rhs) {
+                color += rhs.color, elevation += rhs.elevation, geometry += rhs.geometry;
+            }
+            inline void operator -= (const ResidentBytes& rhs) {
+                color -= rhs.color, elevation -= rhs.elevation, geometry -= rhs.geometry;
+            }
+        };
+
         struct TileInfo
         {
             // this needs to be a ref ptr because it's possible for the unloader
@@ -37,9 +77,79 @@ namespace ROCKY_NAMESPACE
             jobs::future<vsg::ref_ptr<vsg::Node>> childrenCreator;
             jobs::future<bool> dataLoader;
             jobs::future<bool> dataMerger;
+            ResidentBytes bytes; // memory this tile holds itself (not shared with an ancestor)
+            std::uint64_t lastPingCycle = 0u;
+            bool placeholder = false; // skip-LOD tile that lends its place to its subtiles
+        };
+
+        //! Compact, hashable identifier for a TileKey
+        struct TileID
+        {
+            unsigned level = 0u;
+            unsigned x = 0u;
+            unsigned y = 0u;
+            std::size_t profile = 0u;
+
+            TileID() = default;
+            TileID(const TileKey& key) :
+                level(key.level), x(key.x), y(key.y), profile(key.valid() ? key.profile.hash() : 0u) { }
+
+            inline bool operator == (const TileID& rhs) const {
+                return level == rhs.level && x == rhs.x && y == rhs.y && profile == rhs.profile;
+            }
+
+            struct Hasher {
+                inline std::size_t operator()(const TileID& id) const { return id.hash(); }
+            };
+
+            inline std::size_t hash() const {
+                std::uint64_t h = profile;
+                h ^= ((std::uint64_t)x << 32 | (std::uint64_t)y) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+                h ^= (std::uint64_t)level + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+                // final avalanche (splitmix64) so that nearby tiles spread across the table
+                h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+                h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+                return (std::size_t)(h ^ (h >> 31));
+            }
         };
 
-        using TileTable = std::map<TileKey, TileInfo>;
+        /**
+         * Open-addressing (linear probing) hash table of TileInfo, keyed by TileID.
+         * Pointers returned by find() are invalidated by any insertion or erasure.
+         */
+        class TileTable
+        {
+        public:
+            //! Find a tile's record, or nullptr if it's not in the table
+            TileInfo* find(const TileID& id);
+            const TileInfo* find(const TileID& id) const;
+
+            //! Find a tile's record, inserting an empty one if necessary
+            TileInfo& operator[](const TileID& id);
+
+            //! Remove a tile's record; returns true if it was found
+            bool erase(const TileID& id);
+
+            //! Number of records in the table
+            std::size_t size() const { return _size; }
+
+            //! Remove all records
+            void clear();
+
+        private:
+            struct Slot
+            {
+                TileID id;
+                bool used = false;
+                TileInfo info;
+            };
+            std::vector<Slot> _slots;
+            std::size_t _size = 0u;
+            std::size_t _mask = 0u;
+
+            std::size_t probe(const TileID& id) const;
+            void rehash(std::size_t capacity);
+        };
 
     public:
         //! Consturct the tile manager.
@@ -48,7 +158,8 @@ namespace ROCKY_NAMESPACE
         ~TerrainTilePager();
 
         //! TerrainTileNode will call this to let us know that it's alive
-        //! and that it may need something.
+        //! and that it may need something. The pager processes pings
+        //! during the next update().
         //! ONLY call during record.
         void ping(
             TerrainTileNode* tile,
@@ -73,6 +184,40 @@ namespace ROCKY_NAMESPACE
         //! @return The tile, if it exists
         vsg::ref_ptr<TerrainTileNode> getTile(const TileKey& key) const;
 
+        //! Queues predicted camera positions. During the next update() the pager
+        //! will start loading data, at low priority, for the tiles it expects
+        //! those positions to need. Thread-safe.
+        void prefetch(const std::vector<TerrainPrefetchHint>& hints);
+
+        //! Prefetching statistics
+        struct PrefetchStats
+        {
+            std::uint64_t issued = 0;   // prefetch loads started
+            std::uint64_t hits = 0;     // prefetches later used by a real tile load
+            std::uint64_t wasted = 0;   // prefetches that finished loading but were never used
+            std::uint64_t canceled = 0; // prefetches discarded before they finished loading
+            std::size_t pending = 0;    // prefetches currently loading or waiting to be used
+        };
+
+        //! Paging statistics
+        struct Stats
+        {
+            std::size_t tiles = 0;          // tiles in the registry
+            std::uint64_t loaded = 0;       // tiles that loaded and merged new data
+            std::size_t pendingLeaves = 0;  // visible leaf tiles still waiting on data or subtiles
+            std::uint64_t refinements = 0;  // number of times the terrain has reached its final detail
+            std::uint64_t canceledLoads = 0; // loads abandoned because their tiles went off-screen or became placeholders
+            std::uint64_t placeholderLoads = 0; // skip-LOD placeholder tiles that merged data of their own
+            std::chrono::milliseconds lastTimeToFinalDetail = {}; // duration of the most recent refinement
+            std::chrono::milliseconds maxTimeToFinalDetail = {};  // duration of the longest refinement
+            std::size_t offscreenTiles = 0; // tiles kept resident though nothing saw them last frame
+            std::uint64_t evictions = 0;    // tiles released to stay within the residency budget
+            ResidentBytes residentBytes;    // memory held by all tiles in the registry
+            ResidentBytes peakBytes;        // high-water mark of residentBytes, per category
+            PrefetchStats prefetch;
+        };
+        Stats stats() const;
+
         TileTable _tiles;
         Tracker _tracker;
         std::uint64_t _lastUpdate = 0;
@@ -80,15 +225,84 @@ namespace ROCKY_NAMESPACE
         TerrainTileHost* _host;
         const TerrainSettings& _settings;
 
-        std::vector<TileKey> _createChildren;
-        std::vector<TileKey> _loadData;
-        std::vector<TileKey> _mergeData;
-        std::vector<TileKey> _updateData;
+        std::vector<TileID> _createChildren;
+        std::vector<TileID> _loadData;
+        std::vector<TileID> _mergeData;
+        std::vector<TileID> _updateData;
+
+        // Pings recorded since the last update. Each record thread appends to
+        // its own buffer, and update() drains them all, so that recording never
+        // contends on the pager's lock.
+        struct Ping
+        {
+            vsg::ref_ptr<TerrainTileNode> tile;
+            TileID parent;
+            bool hasParent = false;
+        };
+        struct PingBuffer
+        {
+            std::mutex mutex; // only contended if a record overlaps an update
+            std::vector<Ping> pings;
+        };
+        std::vector<std::shared_ptr<PingBuffer>> _pingBuffers;
+        mutable std::mutex _pingBuffersMutex;
+        const std::uint64_t _uid;
+
+        // Data loads started ahead of need, waiting for requestLoadData to claim them.
+        struct PrefetchPriority;
+        struct Prefetch
+        {
+            jobs::future<TerrainTileModel> model;
+            std::shared_ptr<PrefetchPriority> priority;
+            std::chrono::steady_clock::time_point issued;
+        };
+        std::unordered_map<TileID, Prefetch, TileID::Hasher> _prefetches;
+        std::vector<TerrainPrefetchHint> _prefetchHints;
+        PrefetchStats _prefetchStats;
+        std::chrono::steady_clock::duration _prefetchExpiry = std::chrono::seconds(5);
+
+        // Refinement tracking. A refinement starts when a visible leaf tile needs data
+        // or subtiles, and ends when no visible leaf does.
+        std::size_t _pendingLeaves = 0u;
+        bool _refining = false;
+        std::chrono::steady_clock::time_point _refineStart;
+        Stats _stats;
+
+        // Residency accounting; see TerrainSettings::residencyBudget
+        ResidentBytes _residentBytes;
+        std::uint64_t _cycle = 0u;
+        std::size_t _pinged = 0u;
+
+        // Compressed color images; see TerrainSettings::compressTextures
+        std::shared_ptr<TerrainTileModelFactory::CompressedImageCache> _compressedImages;
+
+        // Ancestor layer tiles that children fell back on
+        std::shared_ptr<TerrainTileModelFactory::AncestorImageCache> _ancestorImages;
 
         unsigned _firstLOD = 0u;
 
     private:
 
+        //! The calling thread's ping buffer
+        PingBuffer& pingBuffer();
+
+        //! Processes one ping from a record traversal
+        void processPing(const Ping& ping);
+
+        //! Abandons the data loads and subtile creation of tiles that did not ping
+        //! this cycle, so work (and network transfers) for off-screen tiles stops.
+        void cancelOffscreenWork();
+
+        //! Releases tiles that nothing has seen recently, least recently seen first,
+        //! until the tiles fit within the residency budget.
+        void evict(std::shared_ptr<TerrainEngine> engine);
+
+        //! Updates the memory accounting for one tile
+        void account(TileInfo& info, const ResidentBytes& bytes);
+
+        //! Factory for loading tile data models with the current settings
+        TerrainTileModelFactory createModelFactory(const TerrainEngine& engine) const;
+
         //! Loads the geometry for 4 new subtiles, and inherits their data models from a parent.
         void requestCreateChildren(
             TileInfo& info,
@@ -98,7 +312,12 @@ namespace ROCKY_NAMESPACE
         void requestLoadData(
             TileInfo& info,
             const IOOptions& io,
-            std::shared_ptr<TerrainEngine> terrain) const;
+            std::shared_ptr<TerrainEngine> terrain);
+
+        //! Expires stale prefetches and starts new ones for the queued hints
+        void requestPrefetches(
+            const IOOptions& io,
+            std::shared_ptr<TerrainEngine> terrain);
 
         //! Merges the new data model loaded in loadData.
         void requestMergeData(
@@ -18,6 +18,11 @@
 #include <string>
 #include <algorithm>
 #include <variant>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <optional>
 
 // OPTIONAL: Define WEEJOBS_EXPORT if you want to use this library from multiple modules (DLLs)
 #ifndef WEEJOBS_EXPORT
@@ -29,6 +34,24 @@
 #define WEEJOBS_NAMESPACE jobs
 #endif
 
+// OPTIONAL: Maximum number of per-thread work-stealing queues per job pool.
+// Threads beyond this number will only use the pool's shared queue.
+#ifndef WEEJOBS_MAX_WORKERS
+#define WEEJOBS_MAX_WORKERS 64
+#endif
+
+// OPTIONAL: Bytes of inline storage for a job's function object. Larger
+// functions (with lots of captured state) go on the heap.
+#ifndef WEEJOBS_DELEGATE_BUFFER_SIZE
+#define WEEJOBS_DELEGATE_BUFFER_SIZE 128
+#endif
+
+// OPTIONAL: Maximum number of recycled blocks each thread keeps per size class
+// (for future states and local job records).
+#ifndef WEEJOBS_MAX_CACHED_BLOCKS
+#define WEEJOBS_MAX_CACHED_BLOCKS 4096
+#endif
+
 // Version
 #define WEEJOBS_VERSION_MAJOR 1
 #define WEEJOBS_VERSION_MINOR 1
@@ -157,8 +180,8 @@ namespace WEEJOBS_NAMESPACE
             }
 
         protected:
-            bool _set;
-            std::condition_variable_any _cond;
+            std::atomic_bool _set;
+            std::condition_variable _cond; // (not _any, which allocates)
             std::mutex _m; // do not use Mutex, we never want tracking
         };
 
@@ -246,6 +269,285 @@ namespace WEEJOBS_NAMESPACE
         template<typename F, typename...Args>
         using result_of_t = typename std::result_of<F(Args...)>::type;
 #endif
+
+        template<typename SIGNATURE, std::size_t SIZE>
+        class small_function;
+
+        /**
+         * Copyable, type-erased function object (like std::function) that stores
+         * callables of up to SIZE bytes inline instead of on the heap.
+         */
+        template<typename R, typename... Args, std::size_t SIZE>
+        class small_function<R(Args...), SIZE>
+        {
+        public:
+            small_function() = default;
+
+            small_function(std::nullptr_t) { }
+
+            template<typename F, typename = typename std::enable_if<
+                !std::is_same<typename std::decay<F>::type, small_function>::value>::type>
+            small_function(F&& func)
+            {
+                using T = typename std::decay<F>::type;
+
+                if constexpr (std::is_constructible<bool, const T&>::value)
+                {
+                    if (!static_cast<bool>(func))
+                        return; // empty std::function or null pointer
+                }
+
+                if constexpr (fits_inline<T>())
+                {
+                    new (_buf) T(std::forward<F>(func));
+                    _ops = &inline_ops<T>::table;
+                }
+                else
+                {
+                    _ptr = new T(std::forward<F>(func));
+                    _ops = &heap_ops<T>::table;
+                }
+            }
+
+            small_function(const small_function& rhs)
+            {
+                if (rhs._ops)
+                {
+                    rhs._ops->copy(*this, rhs);
+                    _ops = rhs._ops;
+                }
+            }
+
+            small_function(small_function&& rhs) noexcept
+            {
+                if (rhs._ops)
+                {
+                    rhs._ops->move(*this, rhs);
+                    _ops = rhs._ops;
+                    rhs._ops = nullptr;
+                }
+            }
+
+            small_function& operator = (const small_function& rhs)
+            {
+                if (this != &rhs)
+                {
+                    small_function temp(rhs);
+                    *this = std::move(temp);
+                }
+                return *this;
+            }
+
+            small_function& operator = (small_function&& rhs) noexcept
+            {
+                if (this != &rhs)
+                {
+                    reset();
+                    if (rhs._ops)
+                    {
+                        rhs._ops->move(*this, rhs);
+                        _ops = rhs._ops;
+                        rhs._ops = nullptr;
+                    }
+                }
+                return *this;
+            }
+
+            ~small_function()
+            {
+                reset();
+            }
+
+            //! Release the function object
+            void reset()
+            {
+                if (_ops)
+                {
+                    _ops->destroy(*this);
+                    _ops = nullptr;
+                }
+            }
+
+            //! Whether this object holds a function
+            explicit operator bool() const
+            {
+                return _ops != nullptr;
+            }
+
+            //! Whether the function is stored inline (i.e., did not allocate)
+            bool is_inline() const
+            {
+                return _ops && _ops->is_inline;
+            }
+
+            //! Invoke the function
+            R operator()(Args... args) const
+            {
+                return _ops->invoke(*this, std::forward<Args>(args)...);
+            }
+
+        private:
+            struct ops
+            {
+                R(*invoke)(const small_function&, Args&&...);
+                void(*copy)(small_function& dst, const small_function& src);
+                void(*move)(small_function& dst, small_function& src);
+                void(*destroy)(small_function&);
+                bool is_inline;
+            };
+
+            template<typename T>
+            static constexpr bool fits_inline()
+            {
+                return
+                    sizeof(T) <= SIZE &&
+                    alignof(T) <= alignof(std::max_align_t) &&
+                    std::is_nothrow_move_constructible<T>::value;
+            }
+
+            template<typename T>
+            struct inline_ops
+            {
+                static T* get(const small_function& f) { return const_cast<T*>(reinterpret_cast<const T*>(f._buf)); }
+                static R invoke(const small_function& f, Args&&... args) { return (*get(f))(std::forward<Args>(args)...); }
+                static void copy(small_function& dst, const small_function& src) { new (dst._buf) T(*get(src)); }
+                static void move(small_function& dst, small_function& src) { new (dst._buf) T(std::move(*get(src))); get(src)->~T(); }
+                static void destroy(small_function& f) { get(f)->~T(); }
+                static constexpr ops table = { &invoke, &copy, &move, &destroy, true };
+            };
+
+            template<typename T>
+            struct heap_ops
+            {
+                static T* get(const small_function& f) { return static_cast<T*>(f._ptr); }
+                static R invoke(const small_function& f, Args&&... args) { return (*get(f))(std::forward<Args>(args)...); }
+                static void copy(small_function& dst, const small_function& src) { dst._ptr = new T(*get(src)); }
+                static void move(small_function& dst, small_function& src) { dst._ptr = src._ptr; src._ptr = nullptr; }
+                static void destroy(small_function& f) { delete get(f); f._ptr = nullptr; }
+                static constexpr ops table = { &invoke, &copy, &move, &destroy, false };
+            };
+
+            const ops* _ops = nullptr;
+            union
+            {
+                alignas(std::max_align_t) unsigned char _buf[SIZE];
+                void* _ptr;
+            };
+        };
+
+        /**
+         * Per-thread free lists of fixed-size memory blocks. Recycles small,
+         * short-lived objects (future states, local job records) without going
+         * back to the system allocator. A block returns to the free list of
+         * whichever thread releases it.
+         */
+        template<std::size_t SIZE>
+        struct block_pool
+        {
+            struct node { node* next; };
+
+            // trivially destructible, so it's safe to use during thread shutdown
+            struct state
+            {
+                node* head;
+                unsigned count;
+                bool dead;
+            };
+
+            static state& local()
+            {
+                static thread_local state s = { nullptr, 0u, false };
+                return s;
+            }
+
+            // frees the calling thread's cached blocks when the thread exits
+            struct reaper
+            {
+                ~reaper()
+                {
+                    auto& s = local();
+                    while (s.head)
+                    {
+                        node* n = s.head;
+                        s.head = n->next;
+                        ::operator delete(n);
+                    }
+                    s.count = 0;
+                    s.dead = true;
+                }
+            };
+
+            static void* allocate()
+            {
+                auto& s = local();
+                if (s.head)
+                {
+                    node* n = s.head;
+                    s.head = n->next;
+                    --s.count;
+                    return n;
+                }
+                return ::operator new(SIZE);
+            }
+
+            static void deallocate(void* ptr)
+            {
+                auto& s = local();
+                if (!s.dead && s.count < WEEJOBS_MAX_CACHED_BLOCKS)
+                {
+                    static thread_local reaper r;
+                    (void)&r;
+                    node* n = static_cast<node*>(ptr);
+                    n->next = s.head;
+                    s.head = n;
+                    ++s.count;
+                }
+                else
+                {
+                    ::operator delete(ptr);
+                }
+            }
+        };
+
+        //! Size class (64-byte multiple) used by the block pool for an object of a given size
+        constexpr std::size_t block_size(std::size_t bytes)
+        {
+            return (bytes + 63u) & ~std::size_t(63u);
+        }
+
+        //! STL allocator that draws single objects from a block_pool.
+        template<typename T>
+        struct pool_allocator
+        {
+            using value_type = T;
+
+            pool_allocator() = default;
+
+            template<typename U>
+            pool_allocator(const pool_allocator<U>&) { }
+
+            T* allocate(std::size_t n)
+            {
+                static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types not supported");
+                if (n == 1)
+                    return static_cast<T*>(block_pool<block_size(sizeof(T))>::allocate());
+                return static_cast<T*>(::operator new(n * sizeof(T)));
+            }
+
+            void deallocate(T* ptr, std::size_t n)
+            {
+                if (n == 1)
+                    block_pool<block_size(sizeof(T))>::deallocate(ptr);
+                else
+                    ::operator delete(ptr);
+            }
+
+            template<typename U>
+            bool operator == (const pool_allocator<U>&) const { return true; }
+
+            template<typename U>
+            bool operator != (const pool_allocator<U>&) const { return false; }
+        };
     }
 
     /**
@@ -267,9 +569,12 @@ namespace WEEJOBS_NAMESPACE
     */
     struct context
     {
-        std::string name; // readable name of the job
+        std::string name; // readable name of the job (tip: keep it short and constant; it's copied into each job)
         class jobpool* pool = nullptr; // job pool to run in
-        std::function<float()> priority = {}; // priority of the job
+        // Priority of the job. Takes any float() callable, including a std::function,
+        // but is not a std::function itself. Callables up to 32 bytes are stored inline;
+        // larger ones are allocated on the heap (like std::function does).
+        detail::small_function<float(), 32> priority = {};
         std::shared_ptr<jobgroup> group = nullptr; // join group for this job
         bool can_cancel = true; // if true, the job will cancel if its future goes out of scope
     };
@@ -303,14 +608,17 @@ namespace WEEJOBS_NAMESPACE
             mutable detail::event _ev;
             std::mutex _continuation_mutex;
             std::function<void()> _continuation;
+            std::function<bool()> _continuation_abandoned; // true if the continuation's consumer is gone
             std::atomic_bool _continuation_ran = { false };
         };
 
+        template<typename U> friend class future;
+
     public:
         //! Default constructor
         future()
         {
-            _shared = std::make_shared<shared_t>();
+            _shared = std::allocate_shared<shared_t>(detail::pool_allocator<shared_t>());
         }
 
         //! Default copy constructor
@@ -336,9 +644,21 @@ namespace WEEJOBS_NAMESPACE
         }
 
         // cancelable interface
+        //! A future is canceled when nobody holds a reference to it anymore.
+        //! If a continuation (see then, when_all, when_any) is waiting on the
+        //! result, the future stays alive until that continuation's own
+        //! consumer abandons it; so canceling the end of a chain cancels
+        //! everything upstream of it.
         bool canceled() const override
         {
-            return empty();
+            if (!empty())
+                return false;
+
+            std::lock_guard<std::mutex> lock(_shared->_continuation_mutex);
+            return
+                !_shared->_continuation ||
+                !_shared->_continuation_abandoned ||
+                _shared->_continuation_abandoned();
         }
 
         //! Deference the result object. Make sure you check available()
@@ -386,12 +706,27 @@ namespace WEEJOBS_NAMESPACE
         //! or a cancelation flag is set; then returns the result object. Be sure to
         //! check canceled() after calling join() to see if the return value is valid.
         const T& join(const cancelable* p) const
+        {
+            wait(p);
+            return value();
+        }
+
+        //! Blocks like join(p), but instead of the result object returns whether
+        //! it is available; use this when there may be no result to read.
+        bool wait(const cancelable* p) const
         {
             while (working() && (p == nullptr || !p->canceled()))
             {
                 _shared->_ev.wait(std::chrono::milliseconds(1));
             }
-            return value();
+            return available();
+        }
+
+        //! Blocks like join(p), but instead of the result object returns whether
+        //! it is available; use this when there may be no result to read.
+        bool wait(const cancelable& p) const
+        {
+            return wait(&p);
         }
 
         //! Blocks until the result becomes available or the future is abandoned
@@ -405,7 +740,7 @@ namespace WEEJOBS_NAMESPACE
         //! Release reference to a promise, resetting this future to its default state
         void abandon()
         {
-            _shared.reset(new shared_t());
+            _shared = std::allocate_shared<shared_t>(detail::pool_allocator<shared_t>());
         }
 
         //! synonym for abandon.
@@ -465,6 +800,21 @@ namespace WEEJOBS_NAMESPACE
         //! return value (fire and forget).
         inline void then_dispatch(std::function<void(const T&)> func, const context& con = {});
 
+        //! Chain a continuation to this future. When this future resolves, func(value, cancelable&)
+        //! is dispatched to the pool in "con" and its return value resolves the returned future.
+        //! Unlike then_dispatch, the chain keeps upstream work alive even if you discard the
+        //! intermediate futures, and abandoning the returned future cancels all pending upstream
+        //! work that only it was waiting on. If this future is canceled, the returned future
+        //! will be canceled as well. Only one continuation per future is allowed.
+        template<typename F, typename R = typename detail::result_of_t<F, const T&, cancelable&>>
+        WEEJOBS_NO_DISCARD inline future<R> then(F func, const context& con = {});
+
+        //! Low-level continuation hook used by then(), when_all() and when_any().
+        //! Runs "func" synchronously in the resolving thread once a value is available.
+        //! "abandoned" should return true when nobody wants the continuation's output anymore.
+        //! Returns false if this future already has a continuation.
+        inline bool _add_continuation(std::function<void(const T&)> func, std::function<bool()> abandoned);
+
     private:
         std::shared_ptr<shared_t> _shared;
 
@@ -479,6 +829,7 @@ namespace WEEJOBS_NAMESPACE
             // This is important because the continuation might hold a reference to a promise
             // that might hamper cancelation.
             _shared->_continuation = nullptr;
+            _shared->_continuation_abandoned = nullptr;
         }
     };
 
@@ -490,23 +841,175 @@ namespace WEEJOBS_NAMESPACE
     {
         struct job
         {
+            using delegate_t = small_function<bool(), WEEJOBS_DELEGATE_BUFFER_SIZE>;
+
             context ctx;
-            std::function<bool()> _delegate;
+            delegate_t _delegate;
+            float _priority = 0.0f; // cached result of ctx.priority()
+
+            // jobs in the per-thread queues are allocated individually; recycle them
+            static void* operator new(std::size_t) { return block_pool<block_size(sizeof(job))>::allocate(); }
+            static void operator delete(void* ptr) { block_pool<block_size(sizeof(job))>::deallocate(ptr); }
+
+            //! Re-evaluate and cache the priority of this job
+            inline void update_priority()
+            {
+                _priority = ctx.priority ? ctx.priority() : 0.0f;
+            }
 
+            //! Compares cached priorities, so it's safe to use in a heap
             bool operator < (const job& rhs) const
             {
-                float lp = ctx.priority ? ctx.priority() : -FLT_MAX;
-                float rp = rhs.ctx.priority ? rhs.ctx.priority() : -FLT_MAX;
-                return lp < rp;
+                return _priority < rhs._priority;
             }
         };
 
         inline bool steal_job(class jobpool* thief, detail::job& stolen);
+
+        /**
+         * Chase-Lev work-stealing deque.
+         * One thread (the owner) pushes and pops at the bottom; any other thread
+         * may steal from the top. Based on Le, Pop, Cohen, Nardelli, "Correct and
+         * Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013).
+         * T must be trivially copyable (we store job pointers).
+         */
+        template<typename T>
+        class ws_deque
+        {
+        public:
+            ws_deque(std::int64_t capacity = 256) :
+                _ring(new ring(capacity)) { }
+
+            ~ws_deque()
+            {
+                delete _ring.load();
+            }
+
+            //! Push an item at the bottom. Owner thread only.
+            inline void push(T item)
+            {
+                auto b = _bottom.load(std::memory_order_relaxed);
+                auto t = _top.load(std::memory_order_acquire);
+                auto* a = _ring.load(std::memory_order_relaxed);
+                if (b - t > a->capacity - 1)
+                {
+                    // full; grow the ring. Stealers may still be reading the old one,
+                    // so keep it alive until the deque goes away.
+                    auto* bigger = a->grow(b, t);
+                    _retired.emplace_back(a);
+                    _ring.store(bigger, std::memory_order_release);
+                    a = bigger;
+                }
+                a->put(b, item);
+                _bottom.store(b + 1, std::memory_order_release); // publish the item to stealers
+            }
+
+            //! Pop the most recently pushed item. Owner thread only.
+            inline bool pop(T& output)
+            {
+                auto b = _bottom.load(std::memory_order_relaxed) - 1;
+                auto* a = _ring.load(std::memory_order_relaxed);
+                _bottom.store(b, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                auto t = _top.load(std::memory_order_relaxed);
+
+                if (t <= b)
+                {
+                    output = a->get(b);
+                    if (t == b)
+                    {
+                        // last item; race against stealers for it.
+                        bool won = _top.compare_exchange_strong(t, t + 1,
+                            std::memory_order_seq_cst, std::memory_order_relaxed);
+                        _bottom.store(b + 1, std::memory_order_relaxed);
+                        return won;
+                    }
+                    return true;
+                }
+
+                _bottom.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            //! Steal the oldest item. Safe to call from any thread.
+            inline bool steal(T& output)
+            {
+                auto t = _top.load(std::memory_order_acquire);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                auto b = _bottom.load(std::memory_order_acquire);
+
+                if (t < b)
+                {
+                    auto* a = _ring.load(std::memory_order_acquire);
+                    output = a->get(t);
+                    return _top.compare_exchange_strong(t, t + 1,
+                        std::memory_order_seq_cst, std::memory_order_relaxed);
+                }
+                return false;
+            }
+
+            //! Approximate number of items in the deque
+            inline std::int64_t size() const
+            {
+                auto b = _bottom.load(std::memory_order_relaxed);
+                auto t = _top.load(std::memory_order_relaxed);
+                return b > t ? b - t : 0;
+            }
+
+        private:
+            struct ring
+            {
+                std::int64_t capacity;
+                std::unique_ptr<std::atomic<T>[]> data;
+
+                ring(std::int64_t c) : capacity(c), data(new std::atomic<T>[c]) { }
+
+                inline T get(std::int64_t i) const {
+                    return data[i & (capacity - 1)].load(std::memory_order_relaxed);
+                }
+                inline void put(std::int64_t i, T item) {
+                    data[i & (capacity - 1)].store(item, std::memory_order_relaxed);
+                }
+                inline ring* grow(std::int64_t b, std::int64_t t) const {
+                    auto* r = new ring(capacity * 2);
+                    for (auto i = t; i < b; ++i)
+                        r->put(i, get(i));
+                    return r;
+                }
+            };
+
+            alignas(64) std::atomic<std::int64_t> _top = { 0 };
+            alignas(64) std::atomic<std::int64_t> _bottom = { 0 };
+            std::atomic<ring*> _ring;
+            std::vector<std::unique_ptr<ring>> _retired;
+        };
+
+        //! Per-thread work queue belonging to one thread in a jobpool.
+        struct worker
+        {
+            ws_deque<job*> deque;
+            bool active = false; // protected by the pool's _quit_mutex
+        };
+
+        //! Identifies the pool and worker (if any) that the current thread belongs to.
+        struct worker_id
+        {
+            class jobpool* pool = nullptr;
+            worker* w = nullptr;
+        };
+
+        inline worker_id& this_worker()
+        {
+            static thread_local worker_id id;
+            return id;
+        }
     }
 
     /**
     * A priority-sorted collection of jobs that are running or waiting
-    * to run in a thread pool.
+    * to run in a thread pool. Queued jobs live in a heap keyed on a cached
+    * priority value that is refreshed once per "priority epoch"
+    * (see set_priority_epoch) or on demand (see invalidate_priorities).
     */
     class jobpool
     {
@@ -523,6 +1026,24 @@ namespace WEEJOBS_NAMESPACE
             std::atomic_uint postprocessing = { 0u };
             std::atomic_uint canceled = { 0u };
             std::atomic_uint total = { 0u };
+            std::atomic_uint reprioritizations = { 0u }; // number of times the queue priorities were re-evaluated
+            std::atomic_uint64_t picks = { 0u }; // number of jobs taken from the queue
+            std::atomic_uint64_t pick_time_ns = { 0u }; // cumulative time spent picking the next job
+            std::atomic_uint64_t max_pick_time_ns = { 0u }; // longest time spent picking a job
+            std::atomic_uint64_t steals = { 0u }; // jobs one worker took from another worker's local queue
+            std::atomic_uint64_t compute_ns = { 0u }; // cumulative CPU time spent running jobs
+            std::atomic_uint64_t blocked_ns = { 0u }; // cumulative time jobs spent waiting (I/O, locks, sleep)
+            std::atomic_uint grows = { 0u }; // number of times adaptive mode added threads
+            std::atomic_uint shrinks = { 0u }; // number of times adaptive mode removed threads
+            std::atomic<float> blocked_ratio = { 0.0f }; // fraction of job time spent blocked (last adaptive window)
+            std::atomic<float> cpu_saturation = { 0.0f }; // fraction of all cores busy running jobs (last adaptive window)
+
+            //! Average time (nanoseconds) spent choosing the next job to run
+            inline double average_pick_time_ns() const
+            {
+                auto n = picks.load();
+                return n > 0 ? (double)pick_time_ns.load() / (double)n : 0.0;
+            }
         };
 
     public:
@@ -544,8 +1065,14 @@ namespace WEEJOBS_NAMESPACE
         }
 
         //! Set the concurrency of this job scheduler
+        //! (Turns off adaptive concurrency.)
         void set_concurrency(unsigned value)
         {
+            {
+                std::lock_guard<std::mutex> lock(_quit_mutex);
+                _adaptive_max = 0;
+                _adaptive = false;
+            }
             value = std::max(value, 1u);
             if (_target_concurrency != value)
             {
@@ -560,6 +1087,47 @@ namespace WEEJOBS_NAMESPACE
             return _target_concurrency;
         }
 
+        //! Let the pool size itself between min_threads and max_threads.
+        //! The pool measures how much time its jobs spend blocked (e.g., waiting on
+        //! the network) versus computing; it adds threads while jobs are waiting
+        //! in the queue and the workers are mostly blocked, and removes threads
+        //! when the CPU is saturated or the workers are idle.
+        //! Requires a thread CPU time function (see set_thread_cpu_time_function);
+        //! without one, all job time counts as compute and the pool never grows.
+        //! Pass max_threads = 0 to turn adaptive mode off (keeps the current size).
+        void set_adaptive_concurrency(unsigned min_threads, unsigned max_threads)
+        {
+            {
+                std::lock_guard<std::mutex> lock(_quit_mutex);
+                _adaptive_min = std::max(min_threads, 1u);
+                _adaptive_max = max_threads > 0 ? std::max(max_threads, _adaptive_min) : 0u;
+                _adaptive = _adaptive_max > 0;
+                if (_adaptive_max == 0)
+                    return;
+                _target_concurrency = std::min(std::max(_target_concurrency.load(), _adaptive_min), _adaptive_max);
+            }
+            start_threads();
+        }
+
+        //! Whether adaptive concurrency is on
+        bool adaptive() const
+        {
+            return _adaptive;
+        }
+
+        //! Lower and upper thread counts for adaptive mode
+        std::pair<unsigned, unsigned> adaptive_range() const
+        {
+            std::lock_guard<std::mutex> lock(_quit_mutex);
+            return { _adaptive_min, _adaptive_max };
+        }
+
+        //! How often adaptive mode re-evaluates the thread count. Default is 250ms.
+        void set_adaptive_interval(std::chrono::steady_clock::duration value)
+        {
+            _adaptive_interval_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(value).count();
+        }
+
         //! Whether this job pool is allowed to steal work from other job pools
         //! when it is idle. Default = true.
         void set_can_steal_work(bool value)
@@ -567,20 +1135,67 @@ namespace WEEJOBS_NAMESPACE
             _can_steal_work = value;
         }
 
+        //! How often to re-evaluate the priority functions of queued jobs.
+        //! Between epochs the pool uses each job's cached priority, so a pick
+        //! is O(log n) instead of calling every priority function.
+        //! Default is 16ms; zero means re-evaluate on every pick.
+        void set_priority_epoch(std::chrono::steady_clock::duration value)
+        {
+            std::lock_guard<std::mutex> lock(_queue_mutex);
+            _priority_epoch = value;
+        }
+
+        //! Force the pool to re-evaluate all job priorities before the next pick.
+        //! Call this when something that affects priorities changes significantly
+        //! (like a camera jump) and you don't want to wait for the next epoch.
+        void invalidate_priorities()
+        {
+            _priorities_dirty = true;
+        }
+
         //! Discard all queued jobs
         void cancel_all()
         {
             std::lock_guard<std::mutex> lock(_queue_mutex);
             _queue.clear();
+            _drain_workers(false);
             _metrics.canceled += _metrics.pending;
             _metrics.pending = 0;
         }
 
+        //! Discard the queued jobs that belong to a group. Jobs that are already
+        //! running, or waiting in a worker's local queue, are not affected.
+        //! @return Number of jobs discarded
+        std::size_t cancel_group(const std::shared_ptr<jobgroup>& group)
+        {
+            if (!group)
+                return 0;
+
+            std::lock_guard<std::mutex> lock(_queue_mutex);
+
+            auto end = std::remove_if(_queue.begin(), _queue.end(),
+                [&](const detail::job& job) { return job.ctx.group == group; });
+
+            auto count = (std::size_t)(_queue.end() - end);
+            if (count > 0)
+            {
+                _queue.erase(end, _queue.end());
+                std::make_heap(_queue.begin(), _queue.end());
+
+                for (std::size_t i = 0; i < count; ++i)
+                    group->release();
+
+                _metrics.pending -= (unsigned)count;
+                _metrics.canceled += (unsigned)count;
+            }
+            return count;
+        }
+
         //! Schedule an asynchronous task on this scheduler
         //! Use job::dispatch to run jobs (usually no need to call this directly)
         //! @param delegate Function to execute
         //! @param context Job details
-        void _dispatch_delegate(std::function<bool()>& delegate, const context& context)
+        void _dispatch_delegate(detail::job::delegate_t&& delegate, const context& context)
         {
             if (!_done)
             {
@@ -590,11 +1205,33 @@ namespace WEEJOBS_NAMESPACE
                     context.group->acquire();
                 }
 
-                if (_target_concurrency > 0)
+                auto& self = detail::this_worker();
+                if (self.pool == this && self.w != nullptr)
+                {
+                    // Dispatching from inside one of our own jobs: keep the new job
+                    // on this thread's local queue, where it runs LIFO (no priority)
+                    // and idle siblings can steal it without touching the shared queue.
+                    ++_local_pending;
+                    self.w->deque.push(new detail::job{ context, std::move(delegate) });
+                    _metrics.pending++;
+                    _metrics.total++;
+
+                    if (_idle > 0)
+                    {
+                        std::lock_guard<std::mutex> lock(_queue_mutex);
+                        _block.notify_one();
+                    }
+                }
+                else if (_target_concurrency > 0)
                 {
+                    // evaluate the initial priority outside the lock
+                    detail::job job{ context, std::move(delegate) };
+                    job.update_priority();
+
                     std::lock_guard<std::mutex> lock(_queue_mutex);
 
-                    _queue.emplace_back(detail::job{ context, delegate });
+                    _queue.emplace_back(std::move(job));
+                    std::push_heap(_queue.begin(), _queue.end());
 
                     _metrics.pending++;
                     _metrics.total++;
@@ -613,47 +1250,234 @@ namespace WEEJOBS_NAMESPACE
             }
         }
 
-        //! removes the highest priority job from the queue and places it
-        //! in output. Returns true if a job was taken, false if the queue
-        //! was empty.
-        inline bool _take_job(detail::job& output, bool lock)
+        //! Schedule a batch of asynchronous tasks that share one context,
+        //! acquiring the queue lock only once.
+        //! Use jobs::dispatch_batch to run jobs (usually no need to call this directly)
+        //! @param delegates Functions to execute
+        //! @param context Job details
+        void _dispatch_delegates(std::vector<detail::job::delegate_t>& delegates, const context& context)
         {
-            if (lock)
+            if (_done || delegates.empty())
+                return;
+
+            if (context.group)
             {
+                for (std::size_t i = 0; i < delegates.size(); ++i)
+                    context.group->acquire();
+            }
+
+            auto& self = detail::this_worker();
+            if (self.pool == this && self.w != nullptr)
+            {
+                // same as _dispatch_delegate: nested jobs go to the local queue
+                _local_pending += (int)delegates.size();
+                for (auto& delegate : delegates)
+                    self.w->deque.push(new detail::job{ context, std::move(delegate) });
+                _metrics.pending += (unsigned)delegates.size();
+                _metrics.total += (unsigned)delegates.size();
+
+                if (_idle > 0)
+                {
+                    std::lock_guard<std::mutex> lock(_queue_mutex);
+                    _block.notify_all();
+                }
+            }
+            else if (_target_concurrency > 0)
+            {
+                // the jobs share a context, so evaluate the priority once
+                detail::job prototype{ context, {}, 0.0f };
+                prototype.update_priority();
+
                 std::lock_guard<std::mutex> lock(_queue_mutex);
-                return _take_job(output, false);
+
+                for (auto& delegate : delegates)
+                {
+                    _queue.emplace_back(detail::job{ context, std::move(delegate), prototype._priority });
+                    std::push_heap(_queue.begin(), _queue.end());
+                }
+
+                _metrics.pending += (unsigned)delegates.size();
+                _metrics.total += (unsigned)delegates.size();
+                _block.notify_all();
             }
-            else if (!_done && !_queue.empty())
+            else
             {
-                auto ptr = _queue.end();
-                float highest_priority = -FLT_MAX;
-                for (auto iter = _queue.begin(); iter != _queue.end(); ++iter)
+                // no threads? run synchronously.
+                for (auto& delegate : delegates)
                 {
-                    float priority = iter->ctx.priority != nullptr ?
-                        iter->ctx.priority() :
-                        0.0f;
+                    delegate();
 
-                    if (ptr == _queue.end() || priority > highest_priority)
+                    if (context.group)
                     {
-                        ptr = iter;
-                        highest_priority = priority;
+                        context.group->release();
                     }
                 }
+            }
+        }
 
-                if (ptr == _queue.end())
-                    ptr = _queue.begin();
+        //! removes the highest priority job from the queue and places it
+        //! in output. Returns true if a job was taken, false if the queue
+        //! was empty.
+        inline bool _take_job(detail::job& output, bool lock)
+        {
+            if (lock)
+            {
+                std::lock_guard<std::mutex> lock(_queue_mutex);
+                return _take_job(output, false);
+            }
+            else if (!_done && !_queue.empty())
+            {
+                auto t0 = std::chrono::steady_clock::now();
 
-                output = std::move(*ptr);
-                if (_queue.size() > 1)
-                    *ptr = std::move(_queue.back());
-                _queue.resize(_queue.size() - 1);
+                // periodically refresh the cached priorities and rebuild the heap:
+                if (_priorities_dirty.exchange(false) || (t0 - _last_epoch) >= _priority_epoch)
+                {
+                    for (auto& job : _queue)
+                        job.update_priority();
+
+                    std::make_heap(_queue.begin(), _queue.end());
+                    _last_epoch = t0;
+                    _metrics.reprioritizations++;
+                }
+
+                // highest priority job is at the front of the heap:
+                std::pop_heap(_queue.begin(), _queue.end());
+                output = std::move(_queue.back());
+                _queue.pop_back();
 
                 _metrics.pending--;
+
+                auto ns = (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - t0).count();
+                _metrics.picks++;
+                _metrics.pick_time_ns += ns;
+                if (ns > _metrics.max_pick_time_ns)
+                    _metrics.max_pick_time_ns = ns;
+
                 return true;
             }
             return false;
         }
 
+        //! Takes the next job from this thread's local queue, or steals one
+        //! from a sibling worker. Returns true if a job was taken.
+        inline bool _take_local_job(detail::job& output)
+        {
+            detail::job* ptr = nullptr;
+            auto* self = detail::this_worker().w;
+            bool taken = self && self->deque.pop(ptr);
+
+            if (!taken && _local_pending > 0)
+            {
+                // steal from a sibling, starting at a different spot each time
+                // so thieves spread out.
+                unsigned n = _num_workers;
+                unsigned start = n > 0 ? _steal_cursor++ % n : 0;
+                for (unsigned i = 0; i < n && !taken; ++i)
+                {
+                    auto* w = _workers[(start + i) % n].get();
+                    if (w != self && w->deque.steal(ptr))
+                    {
+                        taken = true;
+                        _metrics.steals++;
+                    }
+                }
+            }
+
+            if (taken)
+            {
+                --_local_pending;
+                _metrics.pending--;
+                output = std::move(*ptr);
+                delete ptr;
+            }
+            return taken;
+        }
+
+        //! Empties all worker queues. If requeue is true, the jobs move to the
+        //! shared queue; otherwise they are discarded. Caller must hold _queue_mutex.
+        inline void _drain_workers(bool requeue)
+        {
+            unsigned n = _num_workers;
+            for (unsigned i = 0; i < n; ++i)
+            {
+                detail::job* ptr = nullptr;
+                while (_workers[i]->deque.steal(ptr))
+                {
+                    --_local_pending;
+                    if (requeue)
+                    {
+                        ptr->update_priority();
+                        _queue.emplace_back(std::move(*ptr));
+                        std::push_heap(_queue.begin(), _queue.end());
+                    }
+                    else if (ptr->ctx.group)
+                    {
+                        ptr->ctx.group->release();
+                    }
+                    delete ptr;
+                }
+            }
+        }
+
+        //! Assigns a local work queue to the calling thread. Caller must hold _quit_mutex.
+        inline void _attach_worker()
+        {
+            for (unsigned i = 0; i < _num_workers; ++i)
+            {
+                if (!_workers[i]->active)
+                {
+                    _workers[i]->active = true;
+                    detail::this_worker() = { this, _workers[i].get() };
+                    return;
+                }
+            }
+            if (_num_workers < WEEJOBS_MAX_WORKERS)
+            {
+                _workers[_num_workers] = std::make_unique<detail::worker>();
+                _workers[_num_workers]->active = true;
+                detail::this_worker() = { this, _workers[_num_workers].get() };
+                ++_num_workers;
+            }
+            else
+            {
+                // out of local queues; this thread only uses the shared queue.
+                detail::this_worker() = { this, nullptr };
+            }
+        }
+
+        //! Releases the calling thread's local work queue, moving any remaining
+        //! jobs to the shared queue. Caller must hold _quit_mutex.
+        inline void _detach_worker()
+        {
+            auto& self = detail::this_worker();
+            if (self.w)
+            {
+                std::lock_guard<std::mutex> lock(_queue_mutex);
+                detail::job* ptr = nullptr;
+                while (self.w->deque.pop(ptr))
+                {
+                    --_local_pending;
+                    if (_done)
+                    {
+                        // shutting down; just make sure joiners don't deadlock
+                        if (ptr->ctx.group)
+                            ptr->ctx.group->release();
+                    }
+                    else
+                    {
+                        ptr->update_priority();
+                        _queue.emplace_back(std::move(*ptr));
+                        std::push_heap(_queue.begin(), _queue.end());
+                    }
+                    delete ptr;
+                }
+                self.w->active = false;
+                _block.notify_all();
+            }
+            self = {};
+        }
+
         //! Construct a new job pool.
         //! Do not call this directly - call getPool(name) instead.
         jobpool(const std::string& name, unsigned concurrency) :
@@ -677,14 +1501,46 @@ namespace WEEJOBS_NAMESPACE
         //! Wait for all threads to exit (after calling stop_threads)
         inline void join_threads();
 
+        //! Record the compute/blocked time of a job that just ran
+        inline void _record_job_time(std::int64_t wall_ns, std::int64_t cpu_ns);
+
+        //! Adaptive mode: resize the pool based on the last window's measurements
+        inline void _adapt(std::int64_t now_ns);
+
+        //! Wait for work; in adaptive mode, wakes up once per window so an idle pool can shrink.
+        template<typename PREDICATE>
+        inline void _wait(std::unique_lock<std::mutex>& lock, PREDICATE pred)
+        {
+            if (_adaptive)
+                _block.wait_for(lock, std::chrono::nanoseconds(_adaptive_interval_ns.load()), pred);
+            else
+                _block.wait(lock, pred);
+        }
+
         bool _can_steal_work = true;
-        std::vector<detail::job> _queue;
+        std::vector<detail::job> _queue; // binary max-heap on cached job priority
+        std::chrono::steady_clock::duration _priority_epoch = std::chrono::milliseconds(16);
+        std::chrono::steady_clock::time_point _last_epoch;
+        std::atomic_bool _priorities_dirty = { false };
+        std::unique_ptr<detail::worker> _workers[WEEJOBS_MAX_WORKERS]; // per-thread queues (never freed until the pool is)
+        std::atomic<unsigned> _num_workers = { 0u }; // number of allocated worker queues
+        std::atomic<int> _local_pending = { 0 }; // jobs waiting in per-thread queues
+        std::atomic<int> _idle = { 0 }; // number of threads waiting for work
+        std::atomic<unsigned> _steal_cursor = { 0u };
         mutable std::mutex _queue_mutex; // protect access to the queue
         mutable std::mutex _quit_mutex; // protects access to _done
         std::atomic<unsigned> _target_concurrency; // target number of concurrent threads in the pool
         std::condition_variable_any _block; // thread waiter block
-        bool _done = false; // set to true when threads should exit
-        std::vector<std::thread> _threads; // threads in the pool
+        std::atomic_bool _done = { false }; // set to true when threads should exit
+        std::vector<std::thread> _threads; // threads in the pool (protected by _quit_mutex)
+        unsigned _adaptive_min = 1u; // adaptive mode lower thread count (protected by _quit_mutex)
+        unsigned _adaptive_max = 0u; // adaptive mode upper thread count; 0 = disabled (protected by _quit_mutex)
+        std::atomic_bool _adaptive = { false }; // same as _adaptive_max > 0, readable without the lock
+        std::atomic<std::int64_t> _adaptive_interval_ns = { 250000000 };
+        std::atomic<std::int64_t> _window_start_ns = { 0 }; // start of the current adaptive window
+        std::atomic<std::int64_t> _window_wall_ns = { 0 }; // job wall time in the current window
+        std::atomic<std::int64_t> _window_cpu_ns = { 0 }; // job cpu time in the current window
+        std::atomic<std::uint64_t> _window_runtime_cpu_ns = { 0 }; // runtime-wide cpu time at window start
         metrics_t _metrics; // metrics for this pool
     };
 
@@ -733,6 +1589,8 @@ namespace WEEJOBS_NAMESPACE
             std::vector<jobpool*> _pools;
             metrics _metrics;
             std::function<void(const char*)> _set_thread_name;
+            std::function<std::chrono::nanoseconds()> _thread_cpu_time;
+            std::atomic<std::uint64_t> _compute_ns = { 0u }; // cpu time spent in jobs, all pools
         };
     }
 
@@ -763,12 +1621,12 @@ namespace WEEJOBS_NAMESPACE
     namespace detail
     {
         // dispatches a function to the appropriate job pool.
-        inline void pool_dispatch(std::function<bool()> delegate, const context& context)
+        inline void pool_dispatch(job::delegate_t&& delegate, const context& context)
         {
             auto pool = context.pool ? context.pool : get_pool({});
             if (pool)
             {
-                pool->_dispatch_delegate(delegate, context);
+                pool->_dispatch_delegate(std::move(delegate), context);
 
                 // if work stealing is enabled, wake up all pools
                 if (instance()._stealing_allowed)
@@ -782,15 +1640,58 @@ namespace WEEJOBS_NAMESPACE
                 }
             }
         }
+
+        inline void pool_dispatch_batch(std::vector<job::delegate_t>& delegates, const context& context)
+        {
+            auto pool = context.pool ? context.pool : get_pool({});
+            if (pool)
+            {
+                pool->_dispatch_delegates(delegates, context);
+
+                // if work stealing is enabled, wake up all pools
+                if (instance()._stealing_allowed)
+                {
+                    std::lock_guard<std::mutex> lock(instance()._pools_mutex);
+
+                    for (auto pool : instance()._pools)
+                    {
+                        pool->_block.notify_all();
+                    }
+                }
+            }
+        }
+
+        //! Job function that runs "task" and resolves "promise" with its return value
+        template<typename F, typename T>
+        inline auto make_future_delegate(F&& task, future<T> promise, bool can_cancel)
+        {
+            return [task = std::forward<F>(task), promise, can_cancel]() mutable
+                {
+                    bool good = true;
+                    if (can_cancel)
+                    {
+                        good = !promise.canceled();
+                        if (good)
+                            promise.resolve(task(promise));
+                    }
+                    else
+                    {
+                        cancelable dummy;
+                        promise.resolve(task(dummy));
+                    }
+                    return good;
+                };
+        }
     }
 
     //! Dispatches a job with no return value. Fire and forget.
     //! @param task Function to run in a thread. Prototype is void(void).
     //! @param context Optional configuration for the asynchronous function call
-    inline void dispatch(std::function<void()> task, const context& context = {})
+    template<typename F>
+    inline typename std::enable_if<std::is_invocable<F>::value>::type dispatch(F task, const context& context = {})
     {
         auto delegate = [task]() mutable -> bool { task(); return true; };
-        detail::pool_dispatch(delegate, context);
+        detail::pool_dispatch(std::move(delegate), context);
     }
 
     //! Dispatches a job and immediately returns a future result.
@@ -801,27 +1702,7 @@ namespace WEEJOBS_NAMESPACE
     WEEJOBS_NO_DISCARD inline future<T> dispatch(F task, const context& context = {})
     {
         future<T> promise;
-        bool can_cancel = context.can_cancel;
-
-        std::function<bool()> delegate = [task, promise, can_cancel]() mutable
-            {
-                bool good = true;
-                if (can_cancel)
-                {
-                    good = !promise.canceled();
-                    if (good)
-                        promise.resolve(task(promise));
-                }
-                else
-                {
-                    cancelable dummy;
-                    promise.resolve(task(dummy));
-                }
-                return good;
-            };
-
-        detail::pool_dispatch(delegate, context);
-
+        detail::pool_dispatch(detail::make_future_delegate(std::move(task), promise, context.can_cancel), context);
         return promise;
     }
 
@@ -835,7 +1716,7 @@ namespace WEEJOBS_NAMESPACE
     {
         bool can_cancel = context.can_cancel;
 
-        std::function<bool()> delegate = [task, promise, can_cancel]() mutable
+        auto delegate = [task, promise, can_cancel]() mutable
             {
                 bool run = !can_cancel || !promise.canceled();
                 if (run)
@@ -845,11 +1726,213 @@ namespace WEEJOBS_NAMESPACE
                 return run;
             };
 
-        detail::pool_dispatch(delegate, context);
+        detail::pool_dispatch(std::move(delegate), context);
 
         return promise;
     }
 
+    //! Dispatches a batch of jobs with no return value (fire and forget),
+    //! queuing them all at once under a single lock.
+    //! @param tasks Functions to run in threads. Prototype is void(void).
+    //! @param context Optional configuration shared by all the jobs
+    template<typename F>
+    inline typename std::enable_if<std::is_invocable<F>::value>::type dispatch_batch(std::vector<F> tasks, const context& context = {})
+    {
+        std::vector<detail::job::delegate_t> delegates;
+        delegates.reserve(tasks.size());
+        for (auto& task : tasks)
+            delegates.emplace_back([task = std::move(task)]() mutable -> bool { task(); return true; });
+
+        detail::pool_dispatch_batch(delegates, context);
+    }
+
+    //! Dispatches a batch of jobs, queuing them all at once under a single lock,
+    //! and returns a future result for each one.
+    //! @param tasks Functions to run in threads. Prototype is T(cancelable&)
+    //! @param context Optional configuration shared by all the jobs
+    //! @return Future results, in the same order as the tasks
+    template<typename F, typename T = typename detail::result_of_t<F, cancelable&>>
+    WEEJOBS_NO_DISCARD inline std::vector<future<T>> dispatch_batch(std::vector<F> tasks, const context& context = {})
+    {
+        std::vector<future<T>> promises(tasks.size());
+        std::vector<detail::job::delegate_t> delegates;
+        delegates.reserve(tasks.size());
+        for (std::size_t i = 0; i < tasks.size(); ++i)
+            delegates.emplace_back(detail::make_future_delegate(std::move(tasks[i]), promises[i], context.can_cancel));
+
+        detail::pool_dispatch_batch(delegates, context);
+
+        return promises;
+    }
+
+    namespace detail
+    {
+        // State shared by the caller and helper jobs of one parallel loop.
+        // Helpers can start after the loop has finished, so they only touch
+        // the loop body after successfully claiming a chunk; and the caller
+        // doesn't return until every claimed chunk is done.
+        struct parallel_state
+        {
+            std::size_t chunks = 0;
+            std::atomic<std::size_t> next = { 0 };
+            std::atomic<std::size_t> done = { 0 };
+            std::function<void(std::size_t)> run_chunk;
+            std::mutex mutex;
+            std::condition_variable cv;
+
+            // claim and run chunks until there are none left
+            inline void work()
+            {
+                for (;;)
+                {
+                    auto c = next.fetch_add(1);
+                    if (c >= chunks)
+                        return;
+
+                    run_chunk(c);
+
+                    if (done.fetch_add(1) + 1 == chunks)
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        cv.notify_all();
+                    }
+                }
+            }
+        };
+
+        // Runs run_chunk(0..chunks-1) using the calling thread plus up to
+        // (chunks-1) helper jobs in the pool. The caller always participates,
+        // so this never deadlocks even if the pool is busy or shut down.
+        inline void parallel_chunks(std::size_t chunks, std::function<void(std::size_t)> run_chunk, jobpool* pool, const context& con)
+        {
+            if (chunks == 0)
+                return;
+
+            if (chunks == 1)
+            {
+                run_chunk(0);
+                return;
+            }
+
+            auto state = std::make_shared<parallel_state>();
+            state->chunks = chunks;
+            state->run_chunk = std::move(run_chunk);
+
+            context helper_context{ con.name, pool, con.priority, nullptr, false };
+            auto helpers = std::min(chunks - 1, (std::size_t)std::max(pool->concurrency(), 1u));
+            std::vector<job::delegate_t> delegates;
+            delegates.reserve(helpers);
+            for (std::size_t i = 0; i < helpers; ++i)
+                delegates.emplace_back([state]() { state->work(); return true; });
+
+            pool_dispatch_batch(delegates, helper_context);
+
+            state->work();
+
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->cv.wait(lock, [&]() { return state->done == state->chunks; });
+        }
+
+        // Grain size heuristic: about 4 chunks per thread, so faster threads can
+        // pick up the slack, but never smaller than min_grain.
+        inline std::size_t grain_size(std::size_t count, unsigned threads, std::size_t min_grain)
+        {
+            auto grain = count / (4u * (std::size_t)std::max(threads, 1u));
+            return std::max(std::max(grain, min_grain), (std::size_t)1u);
+        }
+    }
+
+    //! Job pool that parallel_for and parallel_reduce use when the
+    //! context does not specify one. One thread per core, less the caller.
+    inline jobpool* get_parallel_pool()
+    {
+        return get_pool("weejobs::parallel", std::max(std::thread::hardware_concurrency(), 2u) - 1u);
+    }
+
+    /**
+    * Runs func(chunk_begin, chunk_end) over contiguous chunks of the range
+    * [begin, end) in parallel, and returns when all chunks are done. The calling
+    * thread works on chunks too. Chunks are about 1/4 of an even split per
+    * thread, but never smaller than min_grain.
+    *
+    * Usage:
+    *   jobs::parallel_for(0u, height, [&](unsigned r0, unsigned r1) {
+    *       for (unsigned r = r0; r < r1; ++r) ...
+    *   });
+    *
+    * @param begin First index
+    * @param end One past the last index
+    * @param func Function to run on each chunk; prototype is void(INDEX, INDEX)
+    * @param min_grain Minimum number of indices per chunk (use this for very cheap loop bodies)
+    * @param con Optional context (pool and priority of the helper jobs)
+    */
+    template<typename INDEX, typename F>
+    inline void parallel_for(INDEX begin, INDEX end, F&& func, std::size_t min_grain = 1, const context& con = {})
+    {
+        if (!(begin < end))
+            return;
+
+        auto pool = con.pool ? con.pool : get_parallel_pool();
+        auto count = (std::size_t)(end - begin);
+        auto grain = detail::grain_size(count, pool->concurrency() + 1u, min_grain);
+        auto chunks = (count + grain - 1) / grain;
+
+        detail::parallel_chunks(chunks, [&](std::size_t c)
+            {
+                auto chunk_begin = (INDEX)(begin + (INDEX)(c * grain));
+                auto chunk_end = (INDEX)(begin + (INDEX)std::min((c + 1) * grain, count));
+                func(chunk_begin, chunk_end);
+            },
+            pool, con);
+    }
+
+    /**
+    * Computes func(chunk_begin, chunk_end) over contiguous chunks of the range
+    * [begin, end) in parallel, and combines the partial results with reduce,
+    * in chunk order (so the result is deterministic).
+    *
+    * Usage:
+    *   auto sum = jobs::parallel_reduce(0u, count, 0.0,
+    *       [&](unsigned i0, unsigned i1) { double s = 0; for (auto i = i0; i < i1; ++i) s += data[i]; return s; },
+    *       [](double a, double b) { return a + b; });
+    *
+    * @param begin First index
+    * @param end One past the last index
+    * @param identity Initial value of the reduction
+    * @param func Function to run on each chunk; prototype is T(INDEX, INDEX)
+    * @param reduce Function that combines two results; prototype is T(const T&, const T&)
+    * @param min_grain Minimum number of indices per chunk
+    * @param con Optional context (pool and priority of the helper jobs)
+    */
+    template<typename INDEX, typename T, typename F, typename R>
+    inline T parallel_reduce(INDEX begin, INDEX end, T identity, F&& func, R&& reduce, std::size_t min_grain = 1, const context& con = {})
+    {
+        if (!(begin < end))
+            return identity;
+
+        auto pool = con.pool ? con.pool : get_parallel_pool();
+        auto count = (std::size_t)(end - begin);
+        auto grain = detail::grain_size(count, pool->concurrency() + 1u, min_grain);
+        auto chunks = (count + grain - 1) / grain;
+
+        // wrapped so that T=bool doesn't pack partials into shared words
+        struct partial_t { T value; };
+        std::vector<partial_t> partials(chunks, partial_t{ identity });
+
+        detail::parallel_chunks(chunks, [&](std::size_t c)
+            {
+                auto chunk_begin = (INDEX)(begin + (INDEX)(c * grain));
+                auto chunk_end = (INDEX)(begin + (INDEX)std::min((c + 1) * grain, count));
+                partials[c].value = func(chunk_begin, chunk_end);
+            },
+            pool, con);
+
+        T result = identity;
+        for (auto& partial : partials)
+            result = reduce(result, partial.value);
+        return result;
+    }
+
     //! Metrics for all job pool
     inline metrics* get_metrics()
     {
@@ -875,6 +1958,14 @@ namespace WEEJOBS_NAMESPACE
         instance()._set_thread_name = f;
     }
 
+    //! Install a function that returns the CPU time consumed so far by the calling
+    //! thread. Job pools use it to tell blocked time from compute time (see
+    //! jobpool::set_adaptive_concurrency).
+    inline void set_thread_cpu_time_function(std::function<std::chrono::nanoseconds()> f)
+    {
+        instance()._thread_cpu_time = f;
+    }
+
     //! Whether to allow jobpools to steal work from other jobpools when they are idle.
     inline void set_allow_work_stealing(bool value)
     {
@@ -908,10 +1999,19 @@ namespace WEEJOBS_NAMESPACE
 
     inline void jobpool::run()
     {
+        bool retired = false;
+
+        {
+            std::lock_guard<std::mutex> lock(_quit_mutex);
+            _attach_worker();
+        }
+
         while (!_done)
         {
             detail::job next;
-            bool have_next = false;
+            bool have_next = _take_local_job(next);
+
+            if (!have_next)
             {
                 if (_can_steal_work && instance()._stealing_allowed)
                 {
@@ -919,7 +2019,9 @@ namespace WEEJOBS_NAMESPACE
                         std::unique_lock<std::mutex> lock(_queue_mutex);
 
                         // work-stealing enabled: wait until any queue is non-empty
-                        _block.wait(lock, [this]() { return get_metrics()->total_pending() > 0 || _done; });
+                        ++_idle;
+                        _wait(lock, [this]() { return get_metrics()->total_pending() > 0 || _done; });
+                        --_idle;
 
                         if (!_done && !_queue.empty())
                         {
@@ -927,6 +2029,11 @@ namespace WEEJOBS_NAMESPACE
                         }
                     }
 
+                    if (!_done && !have_next)
+                    {
+                        have_next = _take_local_job(next);
+                    }
+
                     if (!_done && !have_next)
                     {
                         have_next = detail::steal_job(this, next);
@@ -934,14 +2041,23 @@ namespace WEEJOBS_NAMESPACE
                 }
                 else
                 {
-                    std::unique_lock<std::mutex> lock(_queue_mutex);
+                    {
+                        std::unique_lock<std::mutex> lock(_queue_mutex);
 
-                    // wait until just our local queue is non-empty
-                    _block.wait(lock, [this] { return !_queue.empty() || _done; });
+                        // wait until our shared queue or a sibling's local queue is non-empty
+                        ++_idle;
+                        _wait(lock, [this] { return !_queue.empty() || _local_pending > 0 || _done; });
+                        --_idle;
 
-                    if (!_done && !_queue.empty())
+                        if (!_done && !_queue.empty())
+                        {
+                            have_next = _take_job(next, false);
+                        }
+                    }
+
+                    if (!_done && !have_next)
                     {
-                        have_next = _take_job(next, false);
+                        have_next = _take_local_job(next);
                     }
                 }
             }
@@ -950,11 +2066,16 @@ namespace WEEJOBS_NAMESPACE
             {
                 _metrics.running++;
 
+                auto& cpu_time = instance()._thread_cpu_time;
                 auto t0 = std::chrono::steady_clock::now();
+                auto c0 = cpu_time ? cpu_time() : std::chrono::nanoseconds(0);
 
                 bool job_executed = next._delegate();
 
-                auto duration = std::chrono::steady_clock::now() - t0;
+                auto t1 = std::chrono::steady_clock::now();
+                auto wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+                auto cpu_ns = cpu_time ? (cpu_time() - c0).count() : wall_ns;
+                _record_job_time(wall_ns, cpu_ns);
 
                 if (job_executed == false)
                 {
@@ -968,6 +2089,14 @@ namespace WEEJOBS_NAMESPACE
                 }
 
                 _metrics.running--;
+
+                _adapt(std::chrono::duration_cast<std::chrono::nanoseconds>(t1.time_since_epoch()).count());
+            }
+            else if (_adaptive)
+            {
+                // idle wakeup; lets an idle pool shrink
+                _adapt(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
             }
 
             // See if we no longer need this thread because the
@@ -977,13 +2106,109 @@ namespace WEEJOBS_NAMESPACE
             if (_target_concurrency < _metrics.concurrency)
             {
                 _metrics.concurrency--;
+                retired = true;
                 break;
             }
         }
+
+        std::lock_guard<std::mutex> lock(_quit_mutex);
+        _detach_worker();
+
+        if (retired)
+        {
+            // Nobody will join a thread retired by a concurrency reduction,
+            // so detach it and forget it.
+            auto id = std::this_thread::get_id();
+            for (auto iter = _threads.begin(); iter != _threads.end(); ++iter)
+            {
+                if (iter->get_id() == id)
+                {
+                    iter->detach();
+                    _threads.erase(iter);
+                    break;
+                }
+            }
+        }
+    }
+
+    inline void jobpool::_record_job_time(std::int64_t wall_ns, std::int64_t cpu_ns)
+    {
+        cpu_ns = std::max(std::min(cpu_ns, wall_ns), (std::int64_t)0);
+        _metrics.compute_ns += cpu_ns;
+        _metrics.blocked_ns += wall_ns - cpu_ns;
+        _window_wall_ns += wall_ns;
+        _window_cpu_ns += cpu_ns;
+        instance()._compute_ns += cpu_ns;
+    }
+
+    inline void jobpool::_adapt(std::int64_t now_ns)
+    {
+        // only one thread evaluates each window
+        auto start_ns = _window_start_ns.load();
+        auto elapsed_ns = now_ns - start_ns;
+        if (elapsed_ns < _adaptive_interval_ns || !_window_start_ns.compare_exchange_strong(start_ns, now_ns))
+            return;
+
+        double wall = (double)_window_wall_ns.exchange(0);
+        double cpu = (double)_window_cpu_ns.exchange(0);
+        auto runtime_cpu_ns = instance()._compute_ns.load();
+        double all_cpu = (double)(runtime_cpu_ns - _window_runtime_cpu_ns.exchange(runtime_cpu_ns));
+
+        if (start_ns == 0)
+            return; // first window
+
+        float blocked = wall > 0.0 ? (float)(1.0 - cpu / wall) : 0.0f;
+        float saturation = (float)(all_cpu / ((double)elapsed_ns * (double)std::max(std::thread::hardware_concurrency(), 1u)));
+        _metrics.blocked_ratio = blocked;
+        _metrics.cpu_saturation = saturation;
+
+        bool grow = false;
+        {
+            std::lock_guard<std::mutex> lock(_quit_mutex);
+
+            if (_adaptive_max == 0 || _done)
+                return;
+
+            unsigned target = _target_concurrency;
+            bool backlog = _metrics.pending > 0;
+
+            if (saturation > 0.9f && target > _adaptive_min)
+            {
+                // CPU is maxed out; more threads would only contend. Remove ~25%.
+                _target_concurrency = std::max(target - std::max(target / 4u, 1u), _adaptive_min);
+                _metrics.shrinks++;
+            }
+            else if (backlog && blocked > 0.5f && saturation < 0.75f && target < _adaptive_max)
+            {
+                // work is waiting and the workers are mostly blocked; add ~25%.
+                _target_concurrency = std::min(target + std::max(target / 4u, 1u), _adaptive_max);
+                _metrics.grows++;
+                grow = true;
+            }
+            else if (!backlog && _idle > 1 && target > _adaptive_min)
+            {
+                // nothing to do; let a thread go.
+                _target_concurrency = target - 1;
+                _metrics.shrinks++;
+            }
+        }
+
+        if (grow)
+        {
+            start_threads();
+        }
+        else
+        {
+            // wake idle threads so a surplus one can exit
+            std::lock_guard<std::mutex> lock(_queue_mutex);
+            _block.notify_all();
+        }
     }
 
     inline void jobpool::start_threads()
     {
+        std::lock_guard<std::mutex> lock(_quit_mutex);
+
         _done = false;
 
         // Not enough? Start up more
@@ -1020,6 +2245,7 @@ namespace WEEJOBS_NAMESPACE
             }
         }
         _queue.clear();
+        _drain_workers(false);
 
         // wake up all threads so they can exit
         _block.notify_all();
@@ -1028,16 +2254,20 @@ namespace WEEJOBS_NAMESPACE
     //! Wait for all threads to exit (after calling stop_threads)
     inline void jobpool::join_threads()
     {
+        std::vector<std::thread> threads;
+        {
+            std::lock_guard<std::mutex> lock(_quit_mutex);
+            threads.swap(_threads);
+        }
+
         // wait for them to exit
-        for (unsigned i = 0; i < _threads.size(); ++i)
+        for (auto& thread : threads)
         {
-            if (_threads[i].joinable())
+            if (thread.joinable())
             {
-                _threads[i].join();
+                thread.join();
             }
         }
-
-        _threads.clear();
     }
 
     // steal a job from another jobpool's queue (other than "thief").
@@ -1197,7 +2427,7 @@ namespace WEEJOBS_NAMESPACE
                                 return true;
                             };
 
-                        detail::pool_dispatch(fire_and_forget_delegate, copy_of_con);
+                        detail::pool_dispatch(std::move(fire_and_forget_delegate), copy_of_con);
                     }
                 };
         }
@@ -1208,6 +2438,157 @@ namespace WEEJOBS_NAMESPACE
         }
     }
 
+    template<typename T>
+    inline bool future<T>::_add_continuation(std::function<void(const T&)> func, std::function<bool()> abandoned)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_shared->_continuation_mutex);
+
+            if (_shared->_continuation)
+            {
+                return false; // only one continuation allowed
+            }
+
+            std::weak_ptr<shared_t> weak_shared = _shared;
+
+            _shared->_continuation = [func, weak_shared]()
+                {
+                    auto shared = weak_shared.lock();
+                    if (shared && shared->_ev.isSet() && std::holds_alternative<T>(shared->_obj))
+                    {
+                        func(std::get<T>(shared->_obj));
+                    }
+                };
+
+            _shared->_continuation_abandoned = abandoned;
+        }
+
+        if (available())
+        {
+            fire_continuation();
+        }
+
+        return true;
+    }
+
+    template<typename T>
+    template<typename F, typename R>
+    inline future<R> future<T>::then(F func, const context& con)
+    {
+        // Hold the downstream promise in one place so that both closures below
+        // share a single reference to it (otherwise it could never look abandoned).
+        auto next = std::make_shared<future<R>>();
+        future<R> result = *next;
+
+        auto on_resolve = [func, con, next](const T& value)
+            {
+                future<R> promise = *next;
+                T copy_of_value = value;
+                auto delegate = [func, copy_of_value, promise]() mutable
+                    {
+                        if (promise.canceled())
+                            return false;
+                        promise.resolve(func(copy_of_value, promise));
+                        return true;
+                    };
+                detail::pool_dispatch(std::move(delegate), con);
+            };
+
+        auto abandoned = [next]() { return next->canceled(); };
+
+        if (!_add_continuation(on_resolve, abandoned))
+            return {};
+
+        return result;
+    }
+
+    //! Returns a future that resolves to a vector of all the input values,
+    //! in order, once every input future has resolved. The aggregation happens
+    //! in whichever thread resolves the last input; chain a then() to schedule
+    //! follow-up work on a specific pool. If any input is canceled, the result
+    //! is canceled as well; abandoning the result cancels the inputs.
+    //! Note: this uses each input's (single) continuation slot.
+    template<typename T>
+    WEEJOBS_NO_DISCARD inline future<std::vector<T>> when_all(const std::vector<future<T>>& inputs)
+    {
+        struct state_t
+        {
+            std::vector<std::variant<std::monostate, T>> slots;
+            std::atomic<std::size_t> remaining;
+            std::mutex mutex;
+            future<std::vector<T>> promise;
+        };
+
+        auto state = std::make_shared<state_t>();
+        future<std::vector<T>> result = state->promise;
+
+        if (inputs.empty())
+        {
+            state->promise.resolve({});
+            return result;
+        }
+
+        state->slots.resize(inputs.size());
+        state->remaining = inputs.size();
+
+        for (std::size_t i = 0; i < inputs.size(); ++i)
+        {
+            future<T> input = inputs[i];
+
+            input._add_continuation(
+                [state, i](const T& value)
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(state->mutex);
+                        state->slots[i].template emplace<T>(value);
+                    }
+                    if (--state->remaining == 0)
+                    {
+                        std::vector<T> values;
+                        values.reserve(state->slots.size());
+                        for (auto& slot : state->slots)
+                            values.emplace_back(std::move(std::get<T>(slot)));
+                        state->promise.resolve(std::move(values));
+                    }
+                },
+                [state]() { return state->promise.canceled(); });
+        }
+
+        return result;
+    }
+
+    //! Returns a future that resolves to the value of whichever input future
+    //! resolves first. Once a winner is in, the remaining inputs are no longer
+    //! needed and will report themselves as canceled (if nothing else holds them).
+    //! Note: this uses each input's (single) continuation slot.
+    template<typename T>
+    WEEJOBS_NO_DISCARD inline future<T> when_any(const std::vector<future<T>>& inputs)
+    {
+        struct state_t
+        {
+            std::atomic_bool done = { false };
+            future<T> promise;
+        };
+
+        auto state = std::make_shared<state_t>();
+        future<T> result = state->promise;
+
+        for (auto& in : inputs)
+        {
+            future<T> input = in;
+
+            input._add_continuation(
+                [state](const T& value)
+                {
+                    if (!state->done.exchange(true))
+                        state->promise.resolve(value);
+                },
+                [state]() { return state->done || state->promise.canceled(); });
+        }
+
+        return result;
+    }
+
     //! Total number of pending jobs across all schedulers
     inline int metrics::total_pending() const
     {
@@ -2,7 +2,21 @@
 #include "catch.hpp"
 
 #include <rocky/rocky.h>
+#include <rocky/SentryTracker.h>
+#include <rocky/CompressedImage.h>
+#include <rocky/DiskContentCache.h>
+#include <rocky/TerrainTileModelFactory.h>
+#include <rocky/vsg/terrain/TerrainState.h>
 #include <random>
+#include <set>
+
+#if (defined(ROCKY_HAS_CURL) || defined(ROCKY_HAS_HTTPLIB)) && !defined(_WIN32)
+#include <rocky/HTTPClient.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
 
 #define ROCKY_EXPOSE_JSON_FUNCTIONS
 #include <rocky/json.h>
@@ -22,6 +36,186 @@ namespace
             return ResultVoidOK;
         }
     };
+
+    class TestElevationLayer : public Inherit<ElevationLayer, TestElevationLayer>
+    {
+    public:
+        float height = 0.0f;
+        bool westHalfOnly = false; // no data in the east half
+        unsigned size = 17;
+        unsigned maxDataLevel = 99; // no data beyond this level
+        mutable std::atomic_int tilesCreated = { 0 };
+
+        Result<> openImplementation(const IOOptions& io) override {
+            auto r = super::openImplementation(io);
+            profile = Profile("global-geodetic");
+            return r;
+        }
+
+    protected:
+        Result<GeoImage> createTileImplementation(const TileKey& key, const IOOptions& io) const override {
+            ++tilesCreated;
+            if (key.level > maxDataLevel)
+                return Failure_ResourceUnavailable;
+            auto hf = Heightfield::create(size, size);
+            for (unsigned row = 0; row < hf.height(); ++row)
+                for (unsigned col = 0; col < hf.width(); ++col)
+                    hf.heightAt(col, row) = (westHalfOnly && col > size / 2) ? NO_DATA_VALUE : height;
+            return GeoImage(hf.image, key.extent());
+        }
+    };
+
+    class TestImageLayer : public Inherit<ImageLayer, TestImageLayer>
+    {
+    public:
+        unsigned maxDataLevel = 99; // no data beyond this level
+        mutable std::atomic_int tilesCreated = { 0 };
+
+        Result<> openImplementation(const IOOptions& io) override {
+            auto r = super::openImplementation(io);
+            profile = Profile("global-geodetic");
+            return r;
+        }
+
+    protected:
+        Result<GeoImage> createTileImplementation(const TileKey& key, const IOOptions& io) const override {
+            ++tilesCreated;
+            if (key.level > maxDataLevel)
+                return Failure_ResourceUnavailable;
+            auto image = Image::create(Image::R8G8B8A8_UNORM, 16, 16);
+            image->fill(glm::fvec4(1, 1, 1, 1));
+            return GeoImage(image, key.extent());
+        }
+    };
+
+#if (defined(ROCKY_HAS_CURL) || defined(ROCKY_HAS_HTTPLIB)) && !defined(_WIN32)
+    // Local stand-in for a tile server: HTTP/1.1 with keep-alive. It answers
+    // "/delay/<ms>" after a delay, "/missing" with a 404, "/redirect/<path>"
+    // with a 302 to "/<path>", and anything else right away. The response body
+    // is the request path. "/cached/<directives>"
+    // sends those Cache-Control directives and an ETag for the current version,
+    // appends the version to the body, and answers a matching If-None-Match
+    // with a 304.
+    class TestHTTPServer
+    {
+    public:
+        int port = 0;
+        std::atomic_int connections = { 0 };
+        std::atomic_int requests = { 0 };
+        std::atomic_int version = { 1 };
+        std::atomic_int notModified = { 0 };
+
+        TestHTTPServer()
+        {
+            _listener = ::socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in addr = {};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = 0;
+            socklen_t len = sizeof(addr);
+            if (::bind(_listener, (sockaddr*)&addr, len) == 0 &&
+                ::listen(_listener, 64) == 0 &&
+                ::getsockname(_listener, (sockaddr*)&addr, &len) == 0)
+            {
+                port = ntohs(addr.sin_port);
+                _thread = std::thread([this]() { accept(); });
+            }
+        }
+
+        ~TestHTTPServer()
+        {
+            ::shutdown(_listener, SHUT_RDWR);
+            ::close(_listener);
+            if (_thread.joinable())
+                _thread.join();
+
+            std::scoped_lock lock(_mutex);
+            for (auto fd : _sockets)
+                ::shutdown(fd, SHUT_RDWR);
+            for (auto& t : _threads)
+                t.join();
+        }
+
+    private:
+        int _listener = -1;
+        std::thread _thread;
+        std::mutex _mutex;
+        std::vector<int> _sockets;
+        std::vector<std::thread> _threads;
+
+        void accept()
+        {
+            for (;;)
+            {
+                int fd = ::accept(_listener, nullptr, nullptr);
+                if (fd < 0)
+                    break;
+                ++connections;
+                std::scoped_lock lock(_mutex);
+                _sockets.push_back(fd);
+                _threads.emplace_back([this, fd]() { serve(fd); });
+            }
+        }
+
+        void serve(int fd)
+        {
+            std::string buffer;
+            char chunk[4096];
+            for (;;)
+            {
+                auto end = buffer.find("\r\n\r\n");
+                if (end == std::string::npos)
+                {
+                    auto n = ::recv(fd, chunk, sizeof(chunk), 0);
+                    if (n <= 0)
+                        break;
+                    buffer.append(chunk, n);
+                    continue;
+                }
+
+                // "GET /path HTTP/1.1"
+                auto path = buffer.substr(4, buffer.find(' ', 4) - 4);
+                auto head = buffer.substr(0, end);
+                buffer.erase(0, end + 4);
+                ++requests;
+
+                if (util::startsWith(path, "/delay/"))
+                    std::this_thread::sleep_for(std::chrono::milliseconds(std::stoi(path.substr(7))));
+
+                std::string status = path == "/missing" ? "404 Not Found" : "200 OK";
+                std::string headers;
+                std::string body = path;
+
+                if (util::startsWith(path, "/redirect/"))
+                {
+                    status = "302 Found";
+                    headers = "Location: " + path.substr(9) + "\r\nCache-Control: no-store\r\n";
+                }
+
+                if (util::startsWith(path, "/cached/"))
+                {
+                    std::string etag = "\"v" + std::to_string(version) + "\"";
+                    headers = "Cache-Control: " + path.substr(8) + "\r\nETag: " + etag + "\r\n";
+                    body += " v" + std::to_string(version);
+                    if (head.find("If-None-Match: " + etag) != std::string::npos)
+                    {
+                        status = "304 Not Modified";
+                        body.clear();
+                        ++notModified;
+                    }
+                }
+
+                std::string response =
+                    "HTTP/1.1 " + status + "\r\n"
+                    "Content-Type: text/plain\r\n" + headers +
+                    "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                    "\r\n" + body;
+                ::send(fd, response.data(), response.size(), MSG_NOSIGNAL);
+            }
+            ::close(fd);
+        }
+    };
+#endif
 }
 
 TEST_CASE("strings")
@@ -113,6 +307,31 @@ TEST_CASE("TileKey")
     CHECK(TileKey(2, 5, 1, p).quadKey() == "103");
 }
 
+TEST_CASE("SentryTracker")
+{
+    SentryTracker<int> tracker;
+    void* tokens[5];
+    for (int i = 1; i <= 4; ++i)
+        tokens[i] = tracker.emplace(i);
+    tracker.flush(~0u, [](int) { return false; });
+
+    // only 3 is in use this cycle; the rest go oldest first, and 2 refuses to go
+    tokens[3] = tracker.update(tokens[3]);
+    std::vector<int> visited;
+    tracker.for_each_stale([&](int i) { visited.push_back(i); });
+    CHECK(visited == std::vector<int>{ 4, 2, 1 });
+    visited.clear();
+    tracker.flush_oldest([]() { return false; }, [&](int i) { visited.push_back(i); return i != 2; });
+    CHECK(visited == std::vector<int>{ 1, 2, 4 });
+    CHECK(tracker._size == 2);
+
+    // nothing in use this cycle; 2 is older than 3, and we stop after one
+    visited.clear();
+    tracker.flush_oldest([&]() { return visited.size() >= 1; }, [&](int i) { visited.push_back(i); return true; });
+    CHECK(visited == std::vector<int>{ 2 });
+    CHECK(tracker._size == 1);
+}
+
 TEST_CASE("Threading")
 {
     jobs::future<int> f1;
@@ -134,6 +353,375 @@ TEST_CASE("Threading")
     CHECK(f2.value() == 123);
 }
 
+TEST_CASE("Job priority")
+{
+    auto pool = jobs::get_pool("rocky::test_priority", 1);
+
+    // occupy the only thread so the remaining jobs pile up in the queue:
+    jobs::detail::event gate;
+    jobs::dispatch([&]() { gate.wait(); }, jobs::context{ "blocker", pool });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    std::mutex mutex;
+    std::vector<int> order;
+    auto group = jobs::jobgroup::create();
+    for (int i = 0; i < 10; ++i)
+    {
+        jobs::context c;
+        c.pool = pool;
+        c.group = group;
+        c.priority = [i]() { return (float)i; };
+        jobs::dispatch([&, i]() { std::scoped_lock lock(mutex); order.push_back(i); }, c);
+    }
+
+    gate.set();
+    group->join();
+
+    REQUIRE(order.size() == 10);
+    CHECK(std::is_sorted(order.rbegin(), order.rend()));
+    CHECK(pool->metrics()->picks >= 11);
+
+    // priority functions too big to store inline still work, as do std::functions:
+    std::array<float, 16> weights = {};
+    weights[15] = 1.0f;
+    jobs::context large;
+    large.priority = [weights]() { return weights[15]; };
+    CHECK(large.priority.is_inline() == false);
+    CHECK(large.priority() == 1.0f);
+    std::function<float()> func = []() { return 2.0f; };
+    large.priority = func;
+    CHECK(large.priority() == 2.0f);
+}
+
+TEST_CASE("Job work stealing")
+{
+    auto pool = jobs::get_pool("rocky::test_stealing", 4);
+    auto group = jobs::jobgroup::create();
+    std::atomic_int count = { 0 };
+
+    // jobs dispatched from inside a job go to that worker's local queue,
+    // where idle siblings can steal them.
+    std::function<void(int)> spawn = [&](int depth)
+        {
+            ++count;
+            if (depth > 0)
+            {
+                for (int i = 0; i < 4; ++i)
+                    jobs::dispatch([&spawn, depth]() { spawn(depth - 1); }, jobs::context{ {}, pool, {}, group });
+            }
+        };
+
+    jobs::dispatch([&]() { spawn(5); }, jobs::context{ {}, pool, {}, group });
+    group->join();
+
+    CHECK(count == 1 + 4 + 16 + 64 + 256 + 1024);
+    CHECK(pool->metrics()->pending == 0);
+}
+
+TEST_CASE("Run concurrently")
+{
+    auto pool = jobs::get_pool("rocky::test_concurrently", 2);
+    std::atomic_int count = { 0 };
+
+    // every worker blocks in a nested call; the callers run the
+    // inner tasks themselves so this can't deadlock.
+    std::vector<std::function<void()>> outer;
+    for (int i = 0; i < 8; ++i)
+    {
+        outer.emplace_back([&]()
+            {
+                std::vector<std::function<void()>> inner(8, [&]() { ++count; });
+                util::runConcurrently(inner, pool);
+            });
+    }
+    util::runConcurrently(outer, pool);
+
+    CHECK(count == 64);
+
+    // with the pool busy, the caller runs everything and leaves no helpers queued
+    auto busy = jobs::get_pool("rocky::test_concurrently_busy", 1);
+    jobs::detail::event gate;
+    auto blocker = jobs::dispatch([&](jobs::cancelable&) { gate.wait(); return true; }, jobs::context{ "blocker", busy });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    count = 0;
+    std::vector<std::function<void()>> tasks(4, [&]() { ++count; });
+    util::runConcurrently(tasks, jobs::context{ "test", busy, []() { return 1.0f; } });
+    CHECK(count == 4);
+    CHECK(busy->metrics()->pending == 0);
+
+    // once canceled, tasks that have not started are skipped
+    struct Canceled : public Cancelable {
+        bool canceled() const override { return true; }
+    } canceled;
+    util::runConcurrently(tasks, jobs::context{ "test", busy }, &canceled);
+    CHECK(count == 4);
+
+    gate.set();
+    blocker.join();
+}
+
+TEST_CASE("Single flight")
+{
+    using namespace std::chrono_literals;
+
+    util::SingleFlight<std::string, std::string> flights;
+    std::atomic_int calls = { 0 };
+    Cancelable never;
+
+    // callers that arrive while the first one is running share its result
+    std::vector<std::thread> threads;
+    std::vector<std::shared_ptr<const std::string>> results(8);
+    for (int i = 0; i < 8; ++i)
+    {
+        threads.emplace_back([&, i]()
+            {
+                results[i] = flights.run("key", [&]() { ++calls; std::this_thread::sleep_for(200ms); return std::string("value"); }, never);
+            });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    CHECK(calls == (int)flights.executed());
+    CHECK(flights.executed() + flights.coalesced() == 8);
+    CHECK(flights.coalesced() > 0);
+    CHECK(std::all_of(results.begin(), results.end(), [](auto& r) { return r && *r == "value"; }));
+
+    // everyone in a flight shares the one result object
+    std::set<const std::string*> distinct;
+    for (auto& r : results)
+        distinct.insert(r.get());
+    CHECK(distinct.size() == flights.executed());
+
+    // a canceled waiter stops waiting without a result
+    struct Canceled : public Cancelable {
+        bool canceled() const override { return true; }
+    } canceled;
+    std::thread leader([&]() { flights.run("slow", [&]() { std::this_thread::sleep_for(200ms); return std::string(); }, never); });
+    while (flights.executed() == (std::uint64_t)calls)
+        std::this_thread::sleep_for(1ms);
+    CHECK(flights.run("slow", [&]() { return std::string("other"); }, canceled) == nullptr);
+    leader.join();
+
+    // a waiter canceled while it sleeps stops waiting as soon as it's woken
+    struct Flag : public Cancelable {
+        std::atomic_bool value = { false };
+        bool canceled() const override { return value; }
+    } flag;
+    std::atomic_bool release = { false }, waiterDone = { false };
+    auto started = flights.executed();
+    std::thread blocked([&]() { flights.run("blocked", [&]() { while (!release) std::this_thread::sleep_for(1ms); return std::string(); }, never); });
+    while (flights.executed() == started)
+        std::this_thread::sleep_for(1ms);
+    std::thread waiter([&]() { CHECK(flights.run("blocked", [&]() { return std::string(); }, flag) == nullptr); waiterDone = true; });
+    std::this_thread::sleep_for(50ms);
+    flag.value = true;
+    flights.wake();
+    while (!waiterDone)
+        std::this_thread::sleep_for(1ms);
+    CHECK(flights.running("blocked")); // the waiter left before the call finished
+    release = true;
+    waiter.join();
+    blocked.join();
+
+    // when the leader throws, the exception is its own; a waiter runs the call again
+    auto executed = flights.executed();
+    std::atomic_bool threw = { false };
+    std::thread thrower([&]()
+        {
+            try {
+                flights.run("throws", [&]() -> std::string { std::this_thread::sleep_for(200ms); throw std::runtime_error("failed"); }, never);
+            }
+            catch (const std::runtime_error&) {
+                threw = true;
+            }
+        });
+    while (flights.executed() == executed)
+        std::this_thread::sleep_for(1ms);
+    auto retried = flights.run("throws", [&]() { return std::string("value"); }, never);
+    thrower.join();
+    CHECK(threw);
+    CHECK(*retried == "value");
+    CHECK(flights.running("throws") == false);
+}
+
+TEST_CASE("Job adaptive concurrency")
+{
+    jobs::set_thread_cpu_time_function([]() { return util::getThreadCPUTime(); });
+
+    auto pool = jobs::get_pool("rocky::test_adaptive", 2);
+    pool->set_adaptive_interval(std::chrono::milliseconds(20));
+    pool->set_adaptive_concurrency(2, 16);
+    CHECK(pool->adaptive());
+
+    // jobs that spend all their time blocked should make the pool grow:
+    auto group = jobs::jobgroup::create();
+    for (int i = 0; i < 200; ++i)
+    {
+        jobs::dispatch([]() { std::this_thread::sleep_for(std::chrono::milliseconds(5)); },
+            jobs::context{ {}, pool, {}, group });
+    }
+    group->join();
+
+    CHECK(pool->metrics()->grows > 0);
+    CHECK(pool->metrics()->blocked_ns > pool->metrics()->compute_ns);
+    CHECK(pool->concurrency() <= 16);
+
+    pool->set_concurrency(2);
+    CHECK(pool->adaptive() == false);
+}
+
+TEST_CASE("Job parallel_for")
+{
+    std::vector<double> values(100000);
+    jobs::parallel_for(std::size_t(0), values.size(), [&](std::size_t i0, std::size_t i1)
+        {
+            for (auto i = i0; i < i1; ++i)
+                values[i] = (double)i;
+        });
+
+    auto sum = jobs::parallel_reduce(std::size_t(0), values.size(), 0.0,
+        [&](std::size_t i0, std::size_t i1)
+        {
+            double s = 0.0;
+            for (auto i = i0; i < i1; ++i)
+                s += values[i];
+            return s;
+        },
+        [](double a, double b) { return a + b; },
+        1000);
+    CHECK(sum == 99999.0 * 100000.0 / 2.0);
+
+    // batch dispatch, with parallel loops nested inside the jobs:
+    auto pool = jobs::get_pool("rocky::test_batch", 2);
+    std::vector<std::function<int(jobs::cancelable&)>> tasks;
+    for (int i = 0; i < 16; ++i)
+    {
+        tasks.emplace_back([i](jobs::cancelable&)
+            {
+                std::atomic_int count = { 0 };
+                jobs::parallel_for(0, 1000, [&](int i0, int i1) { count += i1 - i0; }, 10);
+                return count + i;
+            });
+    }
+
+    auto results = jobs::dispatch_batch(tasks, jobs::context{ "batch", pool });
+    REQUIRE(results.size() == 16);
+    int total = 0;
+    for (auto& result : results)
+        total += result.join();
+    CHECK(total == 16 * 1000 + 120);
+}
+
+TEST_CASE("Job dispatch benchmark", "[.benchmark]")
+{
+    // measures the cost of dispatching a typical tile job (with a priority
+    // function and a few captured values) while the pool is busy.
+    auto pool = jobs::get_pool("rocky::test_dispatch_benchmark", 1);
+    auto anchor = std::make_shared<int>(0);
+    std::weak_ptr<int> anchor_weak(anchor);
+
+    jobs::context context{ "benchmark", pool };
+    context.priority = [anchor_weak]() { return anchor_weak.expired() ? -FLT_MAX : 0.0f; };
+
+    Profile profile("global-geodetic");
+    const int batch = 1000, batches = 10;
+    std::vector<jobs::future<int>> results;
+    results.reserve(batch);
+    std::chrono::nanoseconds elapsed(0);
+
+    for (int b = 0; b < batches; ++b)
+    {
+        jobs::detail::event gate;
+        jobs::dispatch([&]() { gate.wait(); }, jobs::context{ "gate", pool });
+
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < batch; ++i)
+        {
+            TileKey key(8, i % 256, i / 256, profile);
+            results.emplace_back(jobs::dispatch([key](Cancelable&) { return (int)key.level; }, context));
+        }
+        elapsed += std::chrono::steady_clock::now() - t0;
+
+        gate.set();
+        for (auto& r : results)
+            r.join();
+        results.clear();
+    }
+
+    auto per_job = (double)elapsed.count() / (double)(batch * batches);
+    MESSAGE("Dispatch cost: " << per_job << " ns per job");
+    CHECK(pool->metrics()->pending == 0);
+}
+
+TEST_CASE("Job continuations")
+{
+    jobs::context context{ {}, jobs::get_pool("rocky::test_continuations", 2) };
+
+    SECTION("then")
+    {
+        auto result = jobs::dispatch([](Cancelable&) { return 21; }, context)
+            .then([](const int& value, Cancelable&) { return value * 2; }, context)
+            .then([](const int& value, Cancelable&) { return std::to_string(value); }, context);
+
+        CHECK(result.join() == "42");
+    }
+
+    SECTION("when_all")
+    {
+        std::vector<jobs::future<int>> inputs;
+        for (int i = 0; i < 8; ++i)
+            inputs.emplace_back(jobs::dispatch([i](Cancelable&) { return i; }, context));
+
+        auto all = jobs::when_all(inputs);
+        auto& values = all.join();
+        REQUIRE(values.size() == 8);
+        for (int i = 0; i < 8; ++i)
+            CHECK(values[i] == i);
+    }
+
+    SECTION("when_any")
+    {
+        std::vector<jobs::future<int>> inputs(3);
+        auto any = jobs::when_any(inputs);
+        inputs[1].resolve(7);
+        CHECK(any.available());
+        CHECK(any.value() == 7);
+    }
+
+    SECTION("cancelation")
+    {
+        jobs::future<int> head;
+        auto tail = head.then([](const int& value, Cancelable&) { return value; }, context);
+        CHECK(tail.working());
+
+        // nobody holds the head, but the tail still wants it:
+        jobs::future<int> producer = head;
+        head.reset();
+        CHECK(producer.canceled() == false);
+
+        // canceling the tail propagates up the chain:
+        tail.reset();
+        CHECK(producer.canceled() == true);
+    }
+
+    SECTION("wait")
+    {
+        struct Canceled : public Cancelable {
+            bool canceled() const override { return true; }
+        } canceled;
+
+        // a canceled wait returns with no result to read:
+        jobs::future<int> pending;
+        auto promise = pending;
+        CHECK(pending.wait(canceled) == false);
+
+        promise.resolve(5);
+        CHECK(pending.wait(canceled) == true);
+        CHECK(pending.value() == 5);
+    }
+}
+
 TEST_CASE("Math")
 {
     CHECK(is_identity(glm::fmat4(1)));
@@ -223,6 +811,197 @@ TEST_CASE("Image")
     CHECK(equiv(value.a, 1.0f, 0.01f));
 }
 
+TEST_CASE("CompressedImage")
+{
+    // opaque: BC1 with mip levels down to the last whole 4x4 block
+    auto image = Image::create(Image::R8G8B8A8_UNORM, 8, 8);
+    image->fill(Color::Red);
+    auto r = CompressedImage::create(*image);
+    REQUIRE(r.ok());
+    auto compressed = r.value();
+    CHECK(compressed->format == CompressedImage::BC1);
+    CHECK(compressed->mipLevels == 2);
+    CHECK(compressed->sizeInBytes() == 5 * 8);
+    CHECK(compressed->data[0] == 0x00);
+    CHECK(compressed->data[1] == 0xf8); // pure red in 5:6:5
+
+    // translucent: BC3
+    image->fill(Color(1.0f, 0.0f, 0.0f, 0.5f));
+    r = CompressedImage::create(*image);
+    REQUIRE(r.ok());
+    CHECK(r.value()->format == CompressedImage::BC3);
+    CHECK(r.value()->sizeInBytes() == 5 * 16);
+
+    // not a whole number of blocks
+    image = Image::create(Image::R8G8B8A8_UNORM, 6, 6);
+    CHECK(CompressedImage::create(*image).failed());
+
+    // not color
+    image = Image::create(Image::R32_SFLOAT, 8, 8);
+    CHECK(CompressedImage::create(*image).failed());
+}
+
+#ifndef _WIN32 // TerrainTextureArray is not exported from the DLL
+TEST_CASE("Terrain texture array")
+{
+    // 8 pages of 2 layers; the placeholder takes one of them
+    auto array = std::make_shared<TerrainTextureArray>(Image::R8G8B8A8_UNORM, 4, 16, Image::Pixel(0.0f));
+    REQUIRE(array->capacity() == 16);
+    auto image = Image::create(Image::R8G8B8A8_UNORM, 4, 4);
+
+    // the array asks for space while it still has some
+    std::vector<std::shared_ptr<TextureSlot>> slots;
+    while (!array->needsSpace())
+        slots.emplace_back(array->store(image));
+    CHECK(slots.size() == 14);
+    CHECK(std::all_of(slots.begin(), slots.end(), [](auto& slot) { return slot != nullptr; }));
+
+    while (auto slot = array->store(image))
+        slots.emplace_back(slot);
+    CHECK(slots.size() == 15);
+    CHECK(array->slotsInUse() == 16);
+
+    // releasing tiles frees their slots once no frame in flight can be using them
+    slots.resize(4);
+    CHECK(array->needsSpace() == false);
+    CHECK(array->store(image) == nullptr);
+    array->update(TerrainTextureArray::retireFrames);
+    CHECK(array->store(image) != nullptr);
+}
+#endif
+
+TEST_CASE("ShardedLRUCache")
+{
+    // counted in entries: the least recently used go first
+    util::ShardedLRUCache<int, int> lru(4, {}, false, 1);
+    for (int i = 0; i < 4; ++i)
+        lru.put(i, i);
+    CHECK(lru.get(0) == 0);
+    CHECK(lru.get(1000).has_value() == false);
+    lru.put(4, 4);
+    CHECK(lru.get(0).has_value());
+    CHECK(lru.get(1).has_value() == false);
+    CHECK(lru.count() == 4);
+    CHECK(lru.hits() == 2);
+    CHECK(lru.misses() == 2);
+
+    util::ShardedLRUCache<int, int> cache(64);
+    for (int i = 0; i < 1000; ++i)
+        cache.put(i, i);
+    CHECK(cache.size() <= 64);
+    CHECK(cache.get(999) == 999);
+    CHECK(cache.get(0).has_value() == false);
+
+    // weighted in bytes
+    MemoryContentCache bytes(1024 * 1024);
+    for (int i = 0; i < 2000; ++i)
+        bytes.put(std::to_string(i), Content{ "text/plain", std::string(1000, 'x') });
+    CHECK(bytes.size() <= bytes.capacity());
+    CHECK(bytes.count() < 1100);
+    CHECK(bytes.get("1999").has_value());
+    CHECK(bytes.get("1999")->value().data.data() == bytes.get("1999")->value().data.data()); // shared, not copied
+    bytes.put("huge", Content{ "text/plain", std::string(1024 * 1024, 'x') });
+    CHECK(bytes.get("huge").has_value() == false);
+
+    // with admission filtering, a scan of one-off keys can't flush out keys in regular use
+    util::ShardedLRUCache<int, int> filtered(64, {}, true);
+    for (int round = 0; round < 4; ++round)
+        for (int i = 0; i < 48; ++i)
+            if (!filtered.get(i))
+                filtered.put(i, i);
+    for (int i = 1000; i < 2000; ++i)
+        if (!filtered.get(i))
+            filtered.put(i, i);
+    int kept = 0;
+    for (int i = 0; i < 48; ++i)
+        kept += filtered.get(i).has_value() ? 1 : 0;
+    CHECK(kept > 40);
+
+    // concurrent use
+    util::ShardedLRUCache<int, int> shared(1024);
+    std::atomic_int wrong = { 0 };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t)
+    {
+        threads.emplace_back([&, t]()
+            {
+                for (int i = 0; i < 10000; ++i)
+                {
+                    int key = (i * 7 + t) % 2048;
+                    if (auto value = shared.get(key))
+                        wrong += *value != key ? 1 : 0;
+                    else
+                        shared.put(key, key);
+                }
+            });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    CHECK(wrong == 0);
+    CHECK(shared.size() <= 1024);
+    CHECK(shared.hits() + shared.misses() == 80000);
+}
+
+TEST_CASE("DiskContentCache")
+{
+    DiskContentCache::Settings settings;
+    settings.path = (std::filesystem::temp_directory_path() / "rocky_test_disk_cache").string();
+    std::filesystem::remove_all(settings.path);
+
+    auto r = DiskContentCache::create(settings);
+    REQUIRE(r.ok());
+    auto cache = r.value();
+
+    Content content{ "image/png", std::string(1000, 'x') };
+    content.expires = std::chrono::system_clock::time_point(std::chrono::hours(1000000));
+    content.staleWhileRevalidate = std::chrono::seconds(60);
+    content.etag = "\"abc\"";
+    cache->put("https://example.com/0/0/0.png", content);
+    cache->put("https://example.com/1/0/0.png", Failure(Failure::ResourceUnavailable));
+    CHECK(cache->count() == 1);
+    CHECK(cache->get("https://example.com/1/0/0.png").has_value() == false);
+
+    // entries survive a restart
+    cache = nullptr;
+    cache = DiskContentCache::create(settings).value();
+    REQUIRE(cache->count() == 1);
+    auto cached = cache->get("https://example.com/0/0/0.png");
+    REQUIRE(cached.has_value());
+    REQUIRE(cached->ok());
+    CHECK(cached->value().type == "image/png");
+    CHECK(cached->value().data == content.data);
+    CHECK(cached->value().expires == content.expires);
+    CHECK(cached->value().staleWhileRevalidate == content.staleWhileRevalidate);
+    CHECK(cached->value().etag == content.etag);
+    CHECK(cached->value().lastModified.empty());
+
+    // a damaged entry is a miss, and gets removed
+    for (auto& file : std::filesystem::recursive_directory_iterator(settings.path))
+    {
+        if (file.is_regular_file())
+            std::filesystem::resize_file(file.path(), 100);
+    }
+    CHECK(cache->get("https://example.com/0/0/0.png").has_value() == false);
+    CHECK(cache->count() == 0);
+
+    // over budget: the least recently used entries go first
+    settings.maxBytes = 3500;
+    cache = DiskContentCache::create(settings).value();
+    cache->put("a", content);
+    cache->put("b", content);
+    cache->put("c", content);
+    CHECK(cache->get("a").has_value());
+    cache->put("d", content);
+    CHECK(cache->size() <= settings.maxBytes);
+    CHECK(cache->get("a").has_value());
+    CHECK(cache->get("b").has_value() == false);
+    CHECK(cache->get("d").has_value());
+
+    cache->clear();
+    CHECK(cache->count() == 0);
+    std::filesystem::remove_all(settings.path);
+}
+
 TEST_CASE("Heightfield")
 {
     auto hf = Heightfield::create(257, 257);
@@ -270,12 +1049,408 @@ TEST_CASE("Map")
     }
 }
 
+TEST_CASE("Elevation compositing")
+{
+    IOOptions io;
+    Profile p("global-geodetic");
+
+    auto base = TestElevationLayer::create();
+    base->height = 100.0f;
+
+    auto patch = TestElevationLayer::create();
+    patch->height = 500.0f;
+    patch->westHalfOnly = true;
+
+    auto map = Map::create();
+    map->add(base);
+    map->add(patch);
+    REQUIRE(base->open(io).ok());
+    REQUIRE(patch->open(io).ok());
+
+    // later layers take priority; earlier ones fill in their gaps
+    TerrainTileModelFactory factory;
+    auto model = factory.createTileModel(map.get(), TileKey(1, 0, 0, p), io);
+    REQUIRE(model.elevation.heightfield.valid());
+    Heightfield hf(model.elevation.heightfield.image());
+    CHECK(hf.heightAt(0, 0) == 500.0f);
+    CHECK(hf.heightAt(16, 16) == 100.0f);
+    CHECK(model.elevation.heightfield.minValue() == 100.0f);
+    CHECK(model.elevation.heightfield.maxValue() == 500.0f);
+
+    // a layer that covers the whole tile means nothing under it gets read
+    auto cover = TestElevationLayer::create();
+    cover->height = 10.0f;
+    map->add(cover);
+    REQUIRE(cover->open(io).ok());
+
+    int baseTiles = base->tilesCreated, patchTiles = patch->tilesCreated;
+    model = factory.createTileModel(map.get(), TileKey(1, 1, 0, p), io);
+    REQUIRE(model.elevation.heightfield.valid());
+    CHECK(Heightfield(model.elevation.heightfield.image()).heightAt(16, 16) == 10.0f);
+    CHECK(base->tilesCreated == baseTiles);
+    CHECK(patch->tilesCreated == patchTiles);
+
+    // a one-pixel ancestor tile still fills the heightfield
+    auto coarse = TestElevationLayer::create();
+    coarse->height = 20.0f;
+    coarse->size = 1;
+    coarse->maxDataLevel = 0;
+    map->add(coarse);
+    REQUIRE(coarse->open(io).ok());
+
+    model = factory.createTileModel(map.get(), TileKey(1, 1, 0, p), io);
+    REQUIRE(model.elevation.heightfield.valid());
+    CHECK(model.elevation.heightfield.minValue() == 20.0f);
+    CHECK(model.elevation.heightfield.maxValue() == 20.0f);
+}
+
+TEST_CASE("Elevation clamping")
+{
+    IOOptions io;
+
+    auto layer = TestElevationLayer::create();
+    layer->height = 100.0f;
+    REQUIRE(layer->open(io).ok());
+
+    ElevationSampler sampler;
+    sampler.layer = layer;
+
+    // enough points to split up, all clamped the same as one at a time
+    std::vector<glm::dvec3> points;
+    for (std::size_t i = 0; i < 2 * ElevationSession::parallelThreshold; ++i)
+        points.emplace_back(-10.0 + 20.0 * (double)i / 8192.0, 5.0, 0.0);
+
+    auto session = sampler.session(io);
+    session.srs = SRS::WGS84;
+    CHECK(session.clampRangeParallel(points.begin(), points.end()));
+    CHECK(std::all_of(points.begin(), points.end(), [](auto& p) { return p.z == 100.0; }));
+}
+
+TEST_CASE("Ancestor imagery")
+{
+    IOOptions io;
+    Profile p("global-geodetic");
+
+    auto base = TestImageLayer::create();
+    base->maxDataLevel = 1;
+    auto overlay = TestImageLayer::create();
+
+    auto map = Map::create();
+    map->add(base);
+    map->add(overlay);
+    REQUIRE(base->open(io).ok());
+    REQUIRE(overlay->open(io).ok());
+
+    TerrainTileModelFactory factory;
+    factory.ancestorImageCache = std::make_shared<TerrainTileModelFactory::AncestorImageCache>(1024 * 1024);
+
+    auto model = factory.createTileModel(map.get(), TileKey(1, 0, 0, p), io);
+    REQUIRE(model.colorLayers.size() == 1);
+    CHECK(base->tilesCreated == 1);
+
+    // a tile's own image is not cached
+    CHECK(factory.ancestorImageCache->size() == 0);
+
+    // the first child to fall back on the base layer's parent tile fetches it;
+    // the others take it from the cache instead of requesting it again.
+    for (unsigned q = 0; q < 4; ++q)
+    {
+        model = factory.createTileModel(map.get(), TileKey(1, 0, 0, p).createChildKey(q), io);
+        REQUIRE(model.colorLayers.size() == 1);
+        CHECK(model.colorLayers.front().key.level == 2);
+    }
+    CHECK(base->tilesCreated == 6);
+    CHECK(overlay->tilesCreated == 5);
+
+    // levels known to have no data are skipped too
+    model = factory.createTileModel(map.get(), TileKey(2, 0, 0, p).createChildKey(0), io);
+    CHECK(base->tilesCreated == 7);
+
+    // a child of a fallback tile sees its ancestor through a scale/bias
+    factory.compositeColorLayers = false;
+    model = factory.createTileModel(map.get(), TileKey(3, 0, 0, p).createChildKey(3), io);
+    REQUIRE(model.colorLayers.size() == 2);
+    auto& fallback = model.colorLayers.front();
+    CHECK(fallback.key.level == 1);
+    CHECK(fallback.matrix[0][0] == 0.125f);
+}
+
 #ifdef ROCKY_HAS_GDAL
 TEST_CASE("GDAL")
 {
 }
 #endif // ROCKY_HAS_GDAL
 
+TEST_CASE("HTTP caching")
+{
+    using namespace std::chrono_literals;
+
+    // exposes how URI interprets responses, so no transport is involved
+    struct TestURI : public URI
+    {
+        using URI::URI;
+        using URI::parseHTTPDate;
+        using URI::readCachingHeaders;
+        using URI::readResponse;
+    };
+
+    auto date = TestURI::parseHTTPDate("Sun, 06 Nov 1994 08:49:37 GMT");
+    REQUIRE(date.has_value());
+    CHECK(std::chrono::system_clock::to_time_t(*date) == 784111777);
+    CHECK(TestURI::parseHTTPDate("Thu, 01 Jan 1970 00:00:00 GMT")->time_since_epoch().count() == 0);
+    CHECK(TestURI::parseHTTPDate("Tue, 29 Feb 2000 12:00:00 GMT").has_value());
+    CHECK(TestURI::parseHTTPDate("Sun, 06 Foo 1994 08:49:37 GMT").has_value() == false);
+    CHECK(TestURI::parseHTTPDate("yesterday").has_value() == false);
+
+    auto read = [&](const URI::Headers& headers, Content& content)
+        {
+            content = Content();
+            content.timestamp = *date;
+            return TestURI::readCachingHeaders(headers, content);
+        };
+    Content content;
+
+    // max-age counts from the response, less the time it already spent in other caches
+    CHECK(read({ { "Cache-Control", "max-age=600" }, { "Age", "100" } }, content));
+    CHECK(content.expires == *date + 500s);
+
+    // header names and directives are case-insensitive
+    CHECK(read({ { "cache-control", "MAX-AGE=5" } }, content));
+    CHECK(content.expires == *date + 5s);
+
+    // Expires is measured against the server's clock, not ours
+    CHECK(read({ { "Date", "Sun, 06 Nov 1994 08:00:00 GMT" }, { "Expires", "Sun, 06 Nov 1994 09:00:00 GMT" } }, content));
+    CHECK(content.expires == *date + 1h);
+
+    // max-age wins over Expires, and an invalid Expires means already expired
+    CHECK(read({ { "Cache-Control", "max-age=60" }, { "Expires", "Sun, 06 Nov 1994 09:00:00 GMT" } }, content));
+    CHECK(content.expires == *date + 60s);
+    CHECK(read({ { "Expires", "0" } }, content));
+    CHECK(content.expires == *date);
+
+    // no-store forbids caching; no-cache allows it but always revalidates
+    CHECK(read({ { "Cache-Control", "no-store" } }, content) == false);
+    CHECK(read({ { "Cache-Control", "no-cache, max-age=600" } }, content));
+    CHECK(content.expires == *date);
+
+    // validators and revalidation directives
+    CHECK(read({ { "Cache-Control", "max-age=10, must-revalidate, stale-while-revalidate=30" }, { "ETag", "\"abc\"" } }, content));
+    CHECK(content.mustRevalidate);
+    CHECK(content.staleWhileRevalidate == 30s);
+    CHECK(content.etag == "\"abc\"");
+
+    // with no explicit lifetime, a tenth of the time since the last change
+    CHECK(read({ { "Date", "Sun, 06 Nov 1994 08:49:37 GMT" }, { "Last-Modified", "Sun, 06 Nov 1994 07:49:37 GMT" } }, content));
+    CHECK(content.lastModified == "Sun, 06 Nov 1994 07:49:37 GMT");
+    CHECK(content.expires == *date + 6min);
+
+    // a 304 (Not Modified) refreshes the cached content instead of replacing it
+    IOOptions io;
+    io.services().contentCache = std::make_shared<MemoryContentCache>(1024 * 1024);
+    TestURI uri("http://example.com/tile.png");
+
+    Content cached;
+    cached.type = "image/png";
+    cached.data = std::string("pixels");
+    cached.etag = "\"v1\"";
+    cached.timestamp = std::chrono::system_clock::now() - 1h;
+    cached.expires = cached.timestamp + 10min;
+
+    HTTPClient::Response notModified;
+    notModified.status = 304;
+    notModified.headers = { { "Cache-Control", "max-age=3600" } };
+
+    auto before = std::chrono::system_clock::now();
+    auto refreshed = uri.readResponse(notModified, uri.full(), &cached, io);
+    REQUIRE(refreshed.ok());
+    CHECK(refreshed.value().fromCache);
+    CHECK(refreshed.value().content.data.data() == cached.data.data()); // the same bytes
+    CHECK(refreshed.value().content.etag == "\"v1\"");
+    CHECK(refreshed.value().content.expires >= before + 1h);
+    REQUIRE(io.services().contentCache->get(uri.full()).has_value());
+    CHECK(io.services().contentCache->get(uri.full())->value().expires == refreshed.value().content.expires);
+
+    // without new caching headers, it keeps the lifetime it had, starting now
+    notModified.headers.clear();
+    refreshed = uri.readResponse(notModified, uri.full(), &cached, io);
+    REQUIRE(refreshed.ok());
+    CHECK(refreshed.value().content.expires >= before + 10min);
+    CHECK(refreshed.value().content.expires < before + 11min);
+
+    // a 304 for content we don't have is an error
+    CHECK(uri.readResponse(notModified, uri.full(), nullptr, io).failed());
+
+    // stale content beats no content when the server can't be reached, unless it must revalidate
+    auto unreachable = uri.readResponse(Failure(Failure::ServiceUnavailable), uri.full(), &cached, io);
+    REQUIRE(unreachable.ok());
+    CHECK(unreachable.value().fromCache);
+    cached.mustRevalidate = true;
+    CHECK(uri.readResponse(Failure(Failure::ServiceUnavailable), uri.full(), &cached, io).failed());
+
+    // a new response replaces the content, and no-store keeps it out of the cache
+    HTTPClient::Response ok;
+    ok.status = 200;
+    ok.data = "new pixels";
+    ok.headers = { { "Content-Type", "image/png" }, { "Cache-Control", "no-store" } };
+    TestURI other("http://example.com/other.png");
+    auto fresh = other.readResponse(ok, other.full(), nullptr, io);
+    REQUIRE(fresh.ok());
+    CHECK(fresh.value().fromCache == false);
+    CHECK(fresh.value().content.data == "new pixels");
+    CHECK(fresh.value().content.type == "image/png");
+    CHECK(io.services().contentCache->get(other.full()).has_value() == false);
+}
+
+#if (defined(ROCKY_HAS_CURL) || defined(ROCKY_HAS_HTTPLIB)) && !defined(_WIN32)
+TEST_CASE("HTTPClient")
+{
+    using namespace std::chrono_literals;
+
+    TestHTTPServer server;
+    REQUIRE(server.port != 0);
+    std::string base = "http://127.0.0.1:" + std::to_string(server.port);
+
+    HTTPClient::Settings settings;
+    settings.maxRequestsInFlight = 4;
+    settings.maxConnectionsPerHost = 4;
+    auto client = HTTPClient::create(settings);
+    REQUIRE(client);
+
+    // requests run at the same time, up to the in-flight limit, over pooled connections
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<jobs::future<Result<HTTPClient::Response>>> responses;
+    for (int i = 0; i < 16; ++i)
+        responses.emplace_back(client->get({ base + "/delay/100/" + std::to_string(i) }));
+
+    for (int i = 0; i < 16; ++i)
+    {
+        auto& r = responses[i].join();
+        REQUIRE(r.ok());
+        CHECK(r.value().status == 200);
+        CHECK(r.value().data == "/delay/100/" + std::to_string(i));
+    }
+    CHECK(std::chrono::steady_clock::now() - t0 < 1600ms);
+    CHECK(client->stats().peakInFlight == 4);
+    CHECK(server.connections <= 4);
+
+    // after a redirect, the response carries only the final headers
+    auto redirected = client->get({ base + "/redirect/hello" }).join();
+    REQUIRE(redirected.ok());
+    CHECK(redirected.value().data == "/hello");
+    CHECK(std::none_of(redirected.value().headers.begin(), redirected.value().headers.end(),
+        [](auto& h) { return util::ciEquals(h.first, "Location") || util::ciEquals(h.first, "Cache-Control"); }));
+
+    // URI reads go through the client when there is one
+    IOOptions io;
+    io.services().httpClient = client;
+    auto read = URI(base + "/hello").read(io);
+    REQUIRE(read.ok());
+    CHECK(read.value().content.data == "/hello");
+    auto missing = URI(base + "/missing").read(io);
+    REQUIRE(missing.failed());
+    CHECK(missing.error().type == Failure::ResourceUnavailable);
+
+    // concurrent reads of one URI share a single request
+    auto before = client->stats();
+    std::vector<jobs::future<Result<URIResponse>>> reads;
+    for (int i = 0; i < 8; ++i)
+        reads.emplace_back(URI(base + "/delay/300").readAsync(io));
+    for (auto& r : reads)
+    {
+        REQUIRE(r.join().ok());
+        CHECK(r.join().value().content.data == "/delay/300");
+        CHECK(r.join().value().content.data.data() == reads[0].join().value().content.data.data());
+    }
+    CHECK(client->stats().coalesced - before.coalesced == 7);
+    CHECK(client->stats().completed - before.completed == 1);
+
+    // async reads don't hold an I/O thread while they wait on the network
+    IOOptions oneThread;
+    oneThread.services().httpClient = client;
+    oneThread.services().ioPoolName = "rocky::test_async_io";
+    oneThread.services().ioPoolSize = 1;
+    t0 = std::chrono::steady_clock::now();
+    reads.clear();
+    for (int i = 0; i < 4; ++i)
+        reads.emplace_back(URI(base + "/delay/300/" + std::to_string(i)).readAsync(oneThread));
+    for (auto& r : reads)
+        REQUIRE(r.join().ok());
+    CHECK(std::chrono::steady_clock::now() - t0 < 1000ms);
+
+    // abandoning an async read cancels its request
+    before = client->stats();
+    URI(base + "/delay/1000/async").readAsync(io).abandon();
+    for (int i = 0; i < 100 && client->stats().canceled == before.canceled; ++i)
+        std::this_thread::sleep_for(10ms);
+    CHECK(client->stats().canceled - before.canceled == 1);
+
+    // jobs that wait on the network make an adaptive pool grow, the way the
+    // terrain loader pool does when its loads block on fetches
+    jobs::set_thread_cpu_time_function([]() { return util::getThreadCPUTime(); });
+    auto loader = jobs::get_pool("rocky::test_adaptive_io", 2);
+    loader->set_adaptive_interval(20ms);
+    loader->set_adaptive_concurrency(2, 16);
+    auto group = jobs::jobgroup::create();
+    for (int i = 0; i < 64; ++i)
+    {
+        jobs::dispatch([&io, uri = base + "/delay/50/" + std::to_string(i)]() { URI(uri).read(io); },
+            jobs::context{ "load", loader, {}, group });
+    }
+    group->join();
+    CHECK(loader->metrics()->grows > 0);
+    CHECK(loader->concurrency() > 2);
+    loader->set_concurrency(2);
+
+    // expired content is revalidated with a conditional request
+    io.services().contentCache = std::make_shared<MemoryContentCache>(1024 * 1024);
+    URI cached(base + "/cached/max-age=0");
+    auto first = cached.read(io);
+    REQUIRE(first.ok());
+    CHECK(first.value().fromCache == false);
+    CHECK(first.value().content.etag == "\"v1\"");
+    auto second = cached.read(io);
+    REQUIRE(second.ok());
+    CHECK(second.value().fromCache == true);
+    CHECK(second.value().content.data == "/cached/max-age=0 v1");
+    CHECK(server.notModified == 1);
+    server.version = 2;
+    auto third = cached.read(io);
+    REQUIRE(third.ok());
+    CHECK(third.value().fromCache == false);
+    CHECK(third.value().content.data == "/cached/max-age=0 v2");
+
+    // fresh content needs no request at all
+    auto requests = server.requests.load();
+    URI fresh(base + "/cached/max-age=3600");
+    REQUIRE(fresh.read(io).ok());
+    REQUIRE(fresh.read(io).ok());
+    CHECK(server.requests - requests == 1);
+
+    // stale-while-revalidate returns the stale content now and refreshes it in the background
+    io.services().staleWhileRevalidate = 60s;
+    server.version = 3;
+    auto stale = cached.read(io);
+    REQUIRE(stale.ok());
+    CHECK(stale.value().content.data == "/cached/max-age=0 v2");
+    std::string refreshed;
+    for (int i = 0; i < 100 && refreshed != "/cached/max-age=0 v3"; ++i)
+    {
+        std::this_thread::sleep_for(10ms);
+        refreshed = io.services().contentCache->get(cached.full())->value().data;
+    }
+    CHECK(refreshed == "/cached/max-age=0 v3");
+    io.services().contentCache = nullptr;
+
+    // abandoning the future cancels the request
+    before = client->stats();
+    client->get({ base + "/delay/1000" }).abandon();
+    for (int i = 0; i < 100 && client->stats().canceled == before.canceled; ++i)
+        std::this_thread::sleep_for(10ms);
+    CHECK(client->stats().canceled - before.canceled == 1);
+    CHECK(client->stats().inFlight == 0);
+}
+#endif
+
 TEST_CASE("TMS")
 {
     auto layer = TMSImageLayer::create();